@@ -0,0 +1,198 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+#include "angles.h"
+#include "lattice_primitives.h"
+#include "MotionCache.h"
+#include "motion_worker.h"
+#include "unicycle_motions.h"
+#include "work_stealing_pool.h"
+
+// Counts heap allocations made by the motion generation paths. The
+// vector-returning generate_unicycle_motion is the baseline; the buffer-reusing
+// overloads, the motion cache, the designer's background worker and the
+// lattice generator are expected to stop allocating once their storage has
+// grown, and the program exits nonzero if any of them still does.
+
+static std::atomic<std::size_t> g_num_allocations(0);
+
+void* operator new(std::size_t size)
+{
+    ++g_num_allocations;
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+static std::size_t num_allocations()
+{
+    return g_num_allocations.load();
+}
+
+static int num_failures = 0;
+
+static void report(const char* name, std::size_t allocations, std::size_t count, bool expect_none)
+{
+    printf("%-36s %10zu allocations  %8.3f per motion\n", name, allocations, (double)allocations / count);
+    if (expect_none && allocations != 0) {
+        printf("  expected no allocations\n");
+        ++num_failures;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int num_angles = argc > 1 ? atoi(argv[1]) : 16;
+    int extent = argc > 2 ? atoi(argv[2]) : 5;
+
+    std::vector<Pose2_cont> starts;
+    std::vector<Pose2_cont> goals;
+    for (int a = 0; a < num_angles; ++a) {
+        for (int x = -extent; x <= extent; ++x) {
+            for (int y = -extent; y <= extent; ++y) {
+                for (int g = 0; g < num_angles; ++g) {
+                    starts.push_back(Pose2_cont(0.0, 0.0, realize_angle(a, num_angles)));
+                    goals.push_back(Pose2_cont(x, y, realize_angle(g, num_angles)));
+                }
+            }
+        }
+    }
+    const std::size_t num_pairs = starts.size();
+
+    std::size_t checksum = 0;
+
+    // baseline: a fresh vector per motion
+    std::size_t before = num_allocations();
+    for (std::size_t i = 0; i < num_pairs; ++i) {
+        checksum += generate_unicycle_motion(starts[i], goals[i]).size();
+    }
+    report("generate (returned vector)", num_allocations() - before, num_pairs, false);
+
+    // one vector reused for every motion; warm it up to the longest motion first
+    std::vector<Pose2_cont> poses;
+    for (std::size_t i = 0; i < num_pairs; ++i) {
+        generate_unicycle_motion(starts[i], goals[i], poses);
+    }
+    before = num_allocations();
+    for (std::size_t i = 0; i < num_pairs; ++i) {
+        generate_unicycle_motion(starts[i], goals[i], poses);
+        checksum += poses.size();
+    }
+    report("generate (reused vector)", num_allocations() - before, num_pairs, true);
+
+    // caller-provided buffer
+    std::vector<Pose2_cont> buffer(poses.capacity());
+    before = num_allocations();
+    for (std::size_t i = 0; i < num_pairs; ++i) {
+        checksum += generate_unicycle_motion(starts[i], goals[i], buffer.data(), buffer.size());
+    }
+    report("generate (caller buffer)", num_allocations() - before, num_pairs, true);
+
+    // simulate dragging each goal of a designer session: every move
+    // invalidates one motion and regenerates it on the next repaint
+    const Pose2_cont start(0.0, 0.0, 0.0);
+    std::vector<Pose2_cont> session_goals;
+    for (int g = 0; g < num_angles; ++g) {
+        session_goals.push_back(Pose2_cont(extent, g - num_angles / 2, realize_angle(g, num_angles)));
+    }
+    MotionCache cache;
+    cache.update(start, session_goals.begin(), session_goals.end());
+    const int num_moves = 1000;
+    std::size_t num_regenerated = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        // the first pass grows every slot to the longest motion it will hold
+        before = num_allocations();
+        num_regenerated = cache.num_generated();
+        for (int m = 0; m < num_moves; ++m) {
+            Pose2_cont& goal = session_goals[m % session_goals.size()];
+            cache.invalidate(start, goal);
+            goal.x = (m % 2) ? extent : -extent;
+            cache.update(start, session_goals.begin(), session_goals.end());
+        }
+        num_regenerated = cache.num_generated() - num_regenerated;
+    }
+    report("motion cache (drag)", num_allocations() - before, num_regenerated, true);
+
+    // the same drag through the background worker, with the requests built
+    // and the results polled as GLWidget does; allocations on the worker and
+    // pool threads count too
+    MotionWorker worker(2);
+    MotionRequest request;
+    MotionSet result;
+    const std::string generator_name = motion_generator_names().front();
+    Pose2Array drag_goals;
+    for (const Pose2_cont& goal : session_goals) {
+        drag_goals.push_back(goal);
+    }
+    std::vector<Pose2_cont> stale_goals;
+    std::size_t num_results = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        before = num_allocations();
+        num_regenerated = worker.num_generated();
+        for (int m = 0; m < num_moves; ++m) {
+            const std::size_t i = m % drag_goals.size();
+            stale_goals.push_back(drag_goals[i]);
+            drag_goals.x[i] = (m % 2) ? extent : -extent;
+
+            request.generator = generator_name;
+            request.resolution = 0.0;
+            request.start = start;
+            request.goals = drag_goals;
+            request.stale_goals.clear();
+            request.stale_goals.swap(stale_goals);
+            const uint64_t version = worker.submit(request);
+            while (result.version != version) {
+                if (!worker.poll(result)) {
+                    std::this_thread::yield();
+                }
+            }
+            num_results += result.size();
+        }
+        num_regenerated = worker.num_generated() - num_regenerated;
+    }
+    report("motion worker (drag)", num_allocations() - before, num_regenerated, true);
+
+    // lattice generation into reused storage, one heading at a time
+    LatticeParams params;
+    params.num_angles = num_angles;
+    params.extent = extent;
+    WorkStealingPool pool(1);
+    UnicycleGenerator generator;
+    LatticeWorkspace<UnicycleGenerator> workspace;
+    PrimitiveSet primitives;
+    std::vector<int> start_angle(1, 0);
+    for (int a = 0; a < num_angles; ++a) {
+        start_angle[0] = a;
+        generate_lattice_primitives(generator, params, start_angle, pool, workspace, primitives);
+    }
+    before = num_allocations();
+    std::size_t num_primitives = 0;
+    for (int a = 0; a < num_angles; ++a) {
+        start_angle[0] = a;
+        generate_lattice_primitives(generator, params, start_angle, pool, workspace, primitives);
+        num_primitives += primitives.size();
+    }
+    report("lattice (reused workspace)", num_allocations() - before, num_primitives, true);
+
+    printf("%zu pairs, %zu poses generated, %zu motions received\n", num_pairs, checksum, num_results);
+    return num_failures ? 1 : 0;
+}
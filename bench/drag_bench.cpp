@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include "MotionCache.h"
+#include "motion_generator.h"
+#include "motion_worker.h"
+
+// Replays a drag of a group of goals in a crowded designer scene, one mouse
+// move per repaint, and times what the GUI thread spends per repaint when
+// the motions are regenerated in place through a MotionCache, as the
+// designer used to, and when they are handed to a MotionWorker. Reports the
+// worst and mean repaint, how many results arrived during the drag, and how
+// many motions each approach generated.
+
+typedef std::chrono::steady_clock Clock;
+
+/// Largest difference in a pose coordinate between motions counted as the same
+static const double MATCH_TOLERANCE = 1e-9;
+
+static double elapsed_ms(Clock::time_point since)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+}
+
+int main(int argc, char* argv[])
+{
+    const int num_goals = argc > 1 ? atoi(argv[1]) : 10000;
+    const int num_dragged = std::min(num_goals, argc > 2 ? atoi(argv[2]) : 1000);
+    const int num_steps = argc > 3 ? atoi(argv[3]) : 100;
+    const double resolution = argc > 4 ? atof(argv[4]) : 0.05;
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> coord(-20.0, 20.0);
+    std::uniform_real_distribution<double> yaw(-M_PI, M_PI);
+    const Pose2_cont start(0.0, 0.0, 0.0);
+    std::vector<Pose2_cont> initial_goals;
+    for (int i = 0; i < num_goals; ++i) {
+        initial_goals.push_back(Pose2_cont(coord(rng), coord(rng), yaw(rng)));
+    }
+
+    // synchronous: every repaint regenerates the moved goals before drawing
+    std::vector<Pose2_cont> goals = initial_goals;
+    std::unique_ptr<MotionGenerator> generator = create_motion_generator(motion_generator_names().front());
+    MotionCache cache;
+    cache.set_generator(generator.get());
+    cache.set_resolution(resolution);
+    cache.update(start, goals.begin(), goals.end());
+    const std::size_t sync_initial = cache.num_generated();
+
+    double sync_max = 0.0;
+    double sync_total = 0.0;
+    for (int step = 0; step < num_steps; ++step) {
+        Clock::time_point t = Clock::now();
+        for (int i = 0; i < num_dragged; ++i) {
+            cache.invalidate(start, goals[i]);
+            goals[i].x += 0.05;
+        }
+        cache.update(start, goals.begin(), goals.end());
+        const double ms = elapsed_ms(t);
+        sync_max = std::max(sync_max, ms);
+        sync_total += ms;
+    }
+    const std::size_t sync_generated = cache.num_generated() - sync_initial;
+
+    // asynchronous: every repaint submits a request and draws the newest result
+    goals = initial_goals;
+    MotionWorker worker;
+    MotionRequest request;
+    MotionSet motions;
+    request.generator = generator->name();
+    request.resolution = resolution;
+    request.start = start;
+    for (const Pose2_cont& goal : goals) {
+        request.goals.push_back(goal);
+    }
+    uint64_t version = worker.submit(request);
+    while (motions.version != version) {
+        std::this_thread::yield();
+        worker.poll(motions);
+    }
+    const std::size_t async_initial = worker.num_generated();
+
+    double async_max = 0.0;
+    double async_total = 0.0;
+    int num_results = 0;
+    for (int step = 0; step < num_steps; ++step) {
+        Clock::time_point t = Clock::now();
+        request.stale_goals.clear();
+        for (int i = 0; i < num_dragged; ++i) {
+            request.stale_goals.push_back(goals[i]);
+            goals[i].x += 0.05;
+        }
+        request.generator = generator->name();
+        request.resolution = resolution;
+        request.start = start;
+        request.goals.clear();
+        for (const Pose2_cont& goal : goals) {
+            request.goals.push_back(goal);
+        }
+        version = worker.submit(request);
+        num_results += worker.poll(motions);
+        const double ms = elapsed_ms(t);
+        async_max = std::max(async_max, ms);
+        async_total += ms;
+
+        // the time the GUI thread would spend drawing and waiting for input
+        std::this_thread::sleep_for(std::chrono::milliseconds(4));
+    }
+    Clock::time_point settle = Clock::now();
+    while (motions.version != version) {
+        std::this_thread::yield();
+        worker.poll(motions);
+    }
+    const double settle_ms = elapsed_ms(settle);
+    const std::size_t async_generated = worker.num_generated() - async_initial;
+
+    // the final result should be what the synchronous path drew. The worker
+    // solves in batches, whose vectorized trig may differ in the last bits.
+    std::size_t num_mismatches = 0;
+    for (int i = 0; i < num_goals; ++i) {
+        const MotionCache::Motion& expected = cache.motion(start, goals[i]);
+        if (expected.size() != motions.num_poses(i)) {
+            ++num_mismatches;
+            continue;
+        }
+        const Pose2_cont* actual = motions.motion(i);
+        for (std::size_t k = 0; k < expected.size(); ++k) {
+            if (std::fabs(expected[k].x - actual[k].x) > MATCH_TOLERANCE ||
+                std::fabs(expected[k].y - actual[k].y) > MATCH_TOLERANCE ||
+                std::fabs(expected[k].yaw - actual[k].yaw) > MATCH_TOLERANCE)
+            {
+                ++num_mismatches;
+                break;
+            }
+        }
+    }
+
+    printf("%d goals, %d dragged over %d repaints, resolution %g\n", num_goals, num_dragged, num_steps, resolution);
+    printf("synchronous   max %8.3f ms  mean %8.3f ms per repaint  %8zu motions generated\n",
+            sync_max, sync_total / num_steps, sync_generated);
+    printf("worker        max %8.3f ms  mean %8.3f ms per repaint  %8zu motions generated  %d results during the drag, last after %.3f ms\n",
+            async_max, async_total / num_steps, async_generated, num_results, settle_ms);
+    printf("%zu mismatches with the synchronous motions\n", num_mismatches);
+    return num_mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "angles.h"
+#include "dubins_motions.h"
+#include "unicycle_motions.h"
+
+// Solves every (start heading, lattice goal) pair with both the scalar and
+// batched Dubins solvers, reporting throughput, any disagreement between
+// them, how far the path ends land from their goals, and how the paths
+// compare with the unicycle model on the goals both can reach.
+
+int main(int argc, char* argv[])
+{
+    int num_angles = argc > 1 ? atoi(argv[1]) : 64;
+    int extent = argc > 2 ? atoi(argv[2]) : 15;
+    double radius = argc > 3 ? atof(argv[3]) : 1.0;
+
+    Pose2Array starts;
+    Pose2Array goals;
+    for (int a = 0; a < num_angles; ++a) {
+        for (int x = -extent; x <= extent; ++x) {
+            for (int y = -extent; y <= extent; ++y) {
+                if (x == 0 && y == 0) {
+                    continue;
+                }
+                for (int g = 0; g < num_angles; ++g) {
+                    starts.push_back(Pose2_cont(0.0, 0.0, realize_angle(a, num_angles)));
+                    goals.push_back(Pose2_cont(x, y, realize_angle(g, num_angles)));
+                }
+            }
+        }
+    }
+    const std::size_t n = goals.size();
+
+    // solve in lattice-column-sized chunks, as generate_lattice_primitives
+    // does, so the batch stays in cache
+    const std::size_t chunk = (2 * extent + 1) * num_angles;
+    Pose2Array chunk_starts;
+    Pose2Array chunk_goals;
+    DubinsMotionBatch chunk_batch;
+    DubinsMotionBatch batch;
+    batch.radius = radius;
+    batch.word.resize(n);
+    batch.segment0.resize(n);
+    batch.segment1.resize(n);
+    batch.segment2.resize(n);
+    double batch_time = 0.0;
+    for (std::size_t first = 0; first < n; first += chunk) {
+        const std::size_t last = std::min(n, first + chunk);
+        chunk_starts.clear();
+        chunk_goals.clear();
+        for (std::size_t i = first; i < last; ++i) {
+            chunk_starts.push_back(starts[i]);
+            chunk_goals.push_back(goals[i]);
+        }
+
+        auto batch_start = std::chrono::steady_clock::now();
+        solve_dubins_motions(chunk_starts, chunk_goals, radius, chunk_batch);
+        auto batch_end = std::chrono::steady_clock::now();
+        batch_time += std::chrono::duration<double>(batch_end - batch_start).count();
+
+        std::copy(chunk_batch.word.begin(), chunk_batch.word.end(), batch.word.begin() + first);
+        std::copy(chunk_batch.segment0.begin(), chunk_batch.segment0.end(), batch.segment0.begin() + first);
+        std::copy(chunk_batch.segment1.begin(), chunk_batch.segment1.end(), batch.segment1.begin() + first);
+        std::copy(chunk_batch.segment2.begin(), chunk_batch.segment2.end(), batch.segment2.begin() + first);
+    }
+
+    std::vector<DubinsMotion> scalar(n);
+    auto scalar_start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        solve_dubins_motion(starts[i], goals[i], radius, scalar[i]);
+    }
+    auto scalar_end = std::chrono::steady_clock::now();
+
+    std::size_t num_words[DUBINS_NUM_WORDS + 1] = { 0 };
+    std::size_t num_mismatches = 0;
+    double max_end_error = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        ++num_words[batch.word[i]];
+        if (batch.word[i] != scalar[i].word) {
+            ++num_mismatches;
+            continue;
+        }
+        if (batch.word[i] == DUBINS_INFEASIBLE) {
+            continue;
+        }
+
+        DubinsMotion motion = batch.motion(starts, i);
+        if (motion.segments[0] != scalar[i].segments[0] ||
+            motion.segments[1] != scalar[i].segments[1] ||
+            motion.segments[2] != scalar[i].segments[2])
+        {
+            ++num_mismatches;
+        }
+
+        Pose2_cont end = dubins_motion_pose(motion, 1.0);
+        double error = std::max(fabs(end.x - goals.x[i]), fabs(end.y - goals.y[i]));
+        error = std::max(error, fabs(shortest_angle_diff(end.yaw, goals.yaw[i])));
+        max_end_error = std::max(max_end_error, error);
+    }
+
+    // unicycle arcs tighter than the Dubins radius are not comparable
+    std::size_t num_unicycle = 0;
+    std::size_t num_shorter = 0;
+    double unicycle_length = 0.0;
+    double dubins_length = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        UnicycleMotion motion;
+        if (!solve_unicycle_motion(starts[i], goals[i], motion)) {
+            continue;
+        }
+        if (motion.radius != 0.0 && fabs(motion.radius) < radius) {
+            continue;
+        }
+        ++num_unicycle;
+        double lu = unicycle_motion_length(motion);
+        double ld = dubins_motion_length(scalar[i]);
+        unicycle_length += lu;
+        dubins_length += ld;
+        if (ld < lu - 1e-9) {
+            ++num_shorter;
+        }
+    }
+
+    double scalar_time = std::chrono::duration<double>(scalar_end - scalar_start).count();
+    printf("%zu pairs, radius %g\n", n, radius);
+    printf("batch:  %8.3f s  %6.2f ns/pair\n", batch_time, 1e9 * batch_time / n);
+    printf("scalar: %8.3f s  %6.2f ns/pair\n", scalar_time, 1e9 * scalar_time / n);
+    printf("words: LSL %zu, LSR %zu, RSL %zu, RSR %zu, RLR %zu, LRL %zu, infeasible %zu\n",
+            num_words[DUBINS_LSL], num_words[DUBINS_LSR], num_words[DUBINS_RSL],
+            num_words[DUBINS_RSR], num_words[DUBINS_RLR], num_words[DUBINS_LRL], num_words[DUBINS_INFEASIBLE]);
+    printf("batch/scalar mismatches %zu, max end pose error %g\n", num_mismatches, max_end_error);
+    if (num_unicycle > 0) {
+        printf("%zu goals also reachable by the unicycle model: dubins shorter on %zu, mean length %.3f vs %.3f\n",
+                num_unicycle, num_shorter, dubins_length / num_unicycle, unicycle_length / num_unicycle);
+    }
+    return num_mismatches ? 1 : 0;
+}
@@ -0,0 +1,472 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include "angles.h"
+#include "discrete_heading.h"
+#include "footprint.h"
+#include "logging.h"
+#include "pinv.h"
+#include "spatial_index.h"
+#include "unicycle_motions.h"
+
+// Microbenchmarks of the motion generation and geometry hot paths over
+// inputs drawn from a lattice: every (start heading, goal) pair within an
+// extent, split by the kind of motion it solves to, the yaws along the
+// resulting motions, and clicks around lattice poses. Each benchmark runs a
+// fixed batch of inputs repeatedly and reports nanoseconds per call as JSON
+// or CSV, so that runs can be diffed against a stored baseline.
+//
+// GLWidget::discretize_angle forwards to DiscreteHeading::from_angle and
+// GLWidget::hits_arrow to arrow_contains; the free functions are measured
+// so that the suite does not need Qt. Picking and box selection are measured
+// the way GLWidget does them, over a scene of 10000 goals, against the linear
+// scans they replaced.
+
+struct BenchmarkResult
+{
+    std::string name;
+    std::size_t batch_size;     ///< calls per repetition
+    int repetitions;
+    double median_ns;           ///< per call
+    double min_ns;
+    double max_ns;
+};
+
+/// Keeps results observable so that the timed loops are not optimized away
+static volatile double g_sink;
+
+struct Suite
+{
+    std::string filter;
+    double min_time;
+    int repetitions;
+    std::vector<BenchmarkResult> results;
+
+    /// Time $fn, which makes $batch_size calls per invocation and returns a
+    /// checksum, over enough invocations per repetition to run $min_time
+    template <typename Function>
+    void run(const std::string& name, std::size_t batch_size, Function fn)
+    {
+        if (!filter.empty() && name.find(filter) == std::string::npos) {
+            return;
+        }
+        if (batch_size == 0) {
+            fprintf(stderr, "skipping %s: no inputs\n", name.c_str());
+            return;
+        }
+
+        // calibrate the invocations per repetition
+        int invocations = 1;
+        for (;;) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < invocations; ++i) {
+                g_sink = g_sink + fn();
+            }
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (elapsed >= min_time || invocations >= (1 << 24)) {
+                break;
+            }
+            invocations *= 2;
+        }
+
+        std::vector<double> per_call(repetitions);
+        for (int r = 0; r < repetitions; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < invocations; ++i) {
+                g_sink = g_sink + fn();
+            }
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            per_call[r] = 1e9 * elapsed / ((double)invocations * batch_size);
+        }
+        std::sort(per_call.begin(), per_call.end());
+
+        BenchmarkResult result;
+        result.name = name;
+        result.batch_size = batch_size * invocations;
+        result.repetitions = repetitions;
+        result.median_ns = per_call[repetitions / 2];
+        result.min_ns = per_call.front();
+        result.max_ns = per_call.back();
+        results.push_back(result);
+    }
+};
+
+static void print_json(const Suite& suite, int num_angles, int extent)
+{
+    printf("{\n");
+    printf("  \"context\": { \"num_angles\": %d, \"extent\": %d, \"min_time\": %g, \"repetitions\": %d },\n",
+            num_angles, extent, suite.min_time, suite.repetitions);
+    printf("  \"benchmarks\": [\n");
+    for (std::size_t i = 0; i < suite.results.size(); ++i) {
+        const BenchmarkResult& r = suite.results[i];
+        printf("    { \"name\": \"%s\", \"calls\": %zu, \"repetitions\": %d, \"median_ns\": %.3f, \"min_ns\": %.3f, \"max_ns\": %.3f }%s\n",
+                r.name.c_str(), r.batch_size, r.repetitions, r.median_ns, r.min_ns, r.max_ns,
+                i + 1 < suite.results.size() ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+}
+
+static void print_csv(const Suite& suite)
+{
+    printf("name,calls,repetitions,median_ns,min_ns,max_ns\n");
+    for (const BenchmarkResult& r : suite.results) {
+        printf("%s,%zu,%d,%.3f,%.3f,%.3f\n", r.name.c_str(), r.batch_size, r.repetitions, r.median_ns, r.min_ns, r.max_ns);
+    }
+}
+
+static void print_usage(const char* prog)
+{
+    printf("usage: %s [options]\n", prog);
+    printf("\n");
+    printf("  -n, --num-angles N   number of discrete headings (default 16)\n");
+    printf("  -e, --extent E       draw goals from [-E, E] cells (default 5)\n");
+    printf("  -f, --filter TEXT    run only benchmarks whose name contains TEXT\n");
+    printf("  -t, --min-time S     run each repetition for at least S seconds (default 0.05)\n");
+    printf("  -r, --repetitions N  repetitions per benchmark (default 5)\n");
+    printf("      --csv            print CSV instead of JSON\n");
+    printf("  -h, --help           print this message\n");
+}
+
+int main(int argc, char* argv[])
+{
+    int num_angles = 16;
+    int extent = 5;
+    bool csv = false;
+
+    Suite suite;
+    suite.min_time = 0.05;
+    suite.repetitions = 5;
+
+    enum { OPT_CSV = 256 };
+
+    const struct option long_options[] =
+    {
+        { "num-angles", required_argument, 0, 'n' },
+        { "extent",     required_argument, 0, 'e' },
+        { "filter",     required_argument, 0, 'f' },
+        { "min-time",   required_argument, 0, 't' },
+        { "repetitions", required_argument, 0, 'r' },
+        { "csv",        no_argument,       0, OPT_CSV },
+        { "help",       no_argument,       0, 'h' },
+        { 0, 0, 0, 0 }
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "n:e:f:t:r:h", long_options, 0)) != -1) {
+        switch (opt) {
+        case 'n':
+            num_angles = atoi(optarg);
+            break;
+        case 'e':
+            extent = atoi(optarg);
+            break;
+        case 'f':
+            suite.filter = optarg;
+            break;
+        case 't':
+            suite.min_time = atof(optarg);
+            break;
+        case 'r':
+            suite.repetitions = std::max(1, atoi(optarg));
+            break;
+        case OPT_CSV:
+            csv = true;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // every (start heading, goal) pair of the lattice, by the motion it solves to
+    Pose2Array straight_starts, straight_goals;
+    Pose2Array arc_starts, arc_goals;
+    Pose2Array rejected_starts, rejected_goals;
+    std::vector<double> yaws;
+    std::vector<double> start_yaws, goal_yaws;
+    std::vector<int> start_headings, goal_headings;
+    std::vector<Eigen::Matrix2d> matrices;
+    std::vector<Pose2_cont> poses;
+    for (int a = 0; a < num_angles; ++a) {
+        const Pose2_cont start(0.0, 0.0, realize_angle(a, num_angles));
+        for (int x = -extent; x <= extent; ++x) {
+            for (int y = -extent; y <= extent; ++y) {
+                for (int g = 0; g < num_angles; ++g) {
+                    const Pose2_cont goal(x, y, realize_angle(g, num_angles));
+                    start_yaws.push_back(start.yaw);
+                    goal_yaws.push_back(goal.yaw);
+                    start_headings.push_back(a);
+                    goal_headings.push_back(g);
+
+                    UnicycleMotion motion;
+                    if (!solve_unicycle_motion(start, goal, motion)) {
+                        rejected_starts.push_back(start);
+                        rejected_goals.push_back(goal);
+                        continue;
+                    }
+                    if (motion.radius == 0.0) {
+                        straight_starts.push_back(start);
+                        straight_goals.push_back(goal);
+                        continue;
+                    }
+                    arc_starts.push_back(start);
+                    arc_goals.push_back(goal);
+
+                    // the system solve_unicycle_motion inverts for arcs
+                    Eigen::Matrix2d r;
+                    r(0, 0) = cos(start.yaw);
+                    r(0, 1) = sin(goal.yaw) - sin(start.yaw);
+                    r(1, 0) = sin(start.yaw);
+                    r(1, 1) = -(cos(goal.yaw) - cos(start.yaw));
+                    matrices.push_back(r);
+
+                    // the yaws along an arc, unwrapped past [-pi, pi] as the sampler produces them
+                    if (yaws.size() < (1 << 16) && generate_unicycle_motion(start, goal, poses, 0.25)) {
+                        for (const Pose2_cont& p : poses) {
+                            yaws.push_back(p.yaw);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // clicks within a cell of the start and of lattice goals
+    std::vector<Pose2_cont> arrows;
+    std::vector<double> click_x, click_y;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> offset(-0.75, 0.75);
+    for (std::size_t i = 0; i < arc_goals.size() && arrows.size() < 4096; i += 7) {
+        arrows.push_back(arc_goals[i]);
+        click_x.push_back(arc_goals[i].x + offset(rng));
+        click_y.push_back(arc_goals[i].y + offset(rng));
+    }
+
+    // motions at the default density, as mprimgen exports them, for sweeping
+    // the arrow along
+    std::vector<std::vector<Pose2_cont>> paths;
+    for (std::size_t i = 0; i < straight_goals.size() && paths.size() < 256; i += 7) {
+        paths.push_back(generate_unicycle_motion(straight_starts[i], straight_goals[i]));
+    }
+    for (std::size_t i = 0; i < arc_goals.size() && paths.size() < 1024; i += 7) {
+        paths.push_back(generate_unicycle_motion(arc_starts[i], arc_goals[i]));
+    }
+    const Footprint footprint = arrow_footprint();
+    std::vector<CellOffset> cells;
+
+    // a designer scene crowded with goals, and clicks and boxes over it
+    const int num_scene_goals = 10000;
+    const double scene_extent = 50.0;
+    std::uniform_real_distribution<double> scene_coord(-scene_extent, scene_extent);
+    std::uniform_real_distribution<double> scene_yaw(-M_PI, M_PI);
+    std::vector<Pose2_cont> scene_goals;
+    SpatialIndex scene_index(4.0);    // as GLWidget builds it
+    for (int i = 0; i < num_scene_goals; ++i) {
+        scene_goals.push_back(Pose2_cont(scene_coord(rng), scene_coord(rng), scene_yaw(rng)));
+        scene_index.insert(i, arrow_bounds(scene_goals.back()));
+    }
+    std::vector<double> pick_x, pick_y;
+    for (int i = 0; i < 1024; ++i) {
+        const Pose2_cont& goal = scene_goals[(i * 7919) % num_scene_goals];
+        pick_x.push_back(goal.x + offset(rng));
+        pick_y.push_back(goal.y + offset(rng));
+    }
+    // boxes a quarter of the scene across, as when selecting a cluster
+    std::vector<Bounds2> boxes;
+    std::uniform_real_distribution<double> box_corner(-scene_extent, 0.0);
+    for (int i = 0; i < 16; ++i) {
+        const double x = box_corner(rng);
+        const double y = box_corner(rng);
+        boxes.push_back(Bounds2(x, y, x + scene_extent, y + scene_extent));
+    }
+    std::vector<uint32_t> query_ids;
+
+    std::vector<Pose2_cont> buffer;
+    auto generate = [&](const Pose2Array& starts, const Pose2Array& goals)
+    {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < goals.size(); ++i) {
+            if (generate_unicycle_motion(starts[i], goals[i], buffer)) {
+                sum += buffer.back().x;
+            }
+        }
+        return sum;
+    };
+
+    suite.run("generate_unicycle_motion/straight", straight_goals.size(), [&]() { return generate(straight_starts, straight_goals); });
+    suite.run("generate_unicycle_motion/arc", arc_goals.size(), [&]() { return generate(arc_starts, arc_goals); });
+    suite.run("generate_unicycle_motion/rejected", rejected_goals.size(), [&]() { return generate(rejected_starts, rejected_goals); });
+
+    suite.run("NormalizeAngle", yaws.size(), [&]()
+    {
+        double sum = 0.0;
+        for (double yaw : yaws) {
+            sum += NormalizeAngle(yaw, -M_PI, M_PI);
+        }
+        return sum;
+    });
+
+    suite.run("ShortestAngleDiff", goal_yaws.size(), [&]()
+    {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < goal_yaws.size(); ++i) {
+            sum += ShortestAngleDiff(goal_yaws[i], start_yaws[i]);
+        }
+        return sum;
+    });
+
+    suite.run("shortest_angle_diff", goal_yaws.size(), [&]()
+    {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < goal_yaws.size(); ++i) {
+            sum += shortest_angle_diff(goal_yaws[i], start_yaws[i]);
+        }
+        return sum;
+    });
+
+    const HeadingTable& headings = HeadingTable::get(num_angles);
+    suite.run("HeadingTable::diff", goal_headings.size(), [&]()
+    {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < goal_headings.size(); ++i) {
+            sum += headings.diff(goal_headings[i], start_headings[i]);
+        }
+        return sum;
+    });
+
+    suite.run("pinv", matrices.size(), [&]()
+    {
+        double sum = 0.0;
+        Eigen::Matrix2d inverse;
+        for (const Eigen::Matrix2d& m : matrices) {
+            if (pinv(m, inverse)) {
+                sum += inverse(0, 0);
+            }
+        }
+        return sum;
+    });
+
+    suite.run("discretize_angle", yaws.size(), [&]()
+    {
+        double sum = 0.0;
+        for (double yaw : yaws) {
+            sum += discretize_angle(yaw, num_angles);
+        }
+        return sum;
+    });
+
+    suite.run("DiscreteHeading::from_angle", yaws.size(), [&]()
+    {
+        double sum = 0.0;
+        for (double yaw : yaws) {
+            sum += DiscreteHeading::from_angle(yaw, num_angles).index();
+        }
+        return sum;
+    });
+
+    suite.run("HeadingTable::discretize", yaws.size(), [&]()
+    {
+        double sum = 0.0;
+        for (double yaw : yaws) {
+            sum += headings.discretize(yaw);
+        }
+        return sum;
+    });
+
+    suite.run("hits_arrow", arrows.size(), [&]()
+    {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < arrows.size(); ++i) {
+            sum += arrow_contains(arrows[i], click_x[i], click_y[i]);
+        }
+        return sum;
+    });
+
+    suite.run("swept_cells", paths.size(), [&]()
+    {
+        double sum = 0.0;
+        for (const std::vector<Pose2_cont>& path : paths) {
+            swept_cells(footprint, path.data(), path.size(), cells);
+            sum += cells.size();
+        }
+        return sum;
+    });
+
+    // what a debug message in a hot path costs at the default runtime level
+    suite.run("LOG_DEBUG/disabled", yaws.size(), [&]()
+    {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < yaws.size(); ++i) {
+            LOG_DEBUG("yaw %zu = %0.3f", i, yaws[i]);
+            sum += yaws[i];
+        }
+        return sum;
+    });
+
+    suite.run("pick_goal/linear", pick_x.size(), [&]()
+    {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < pick_x.size(); ++i) {
+            for (const Pose2_cont& goal : scene_goals) {
+                sum += arrow_contains(goal, pick_x[i], pick_y[i]);
+            }
+        }
+        return sum;
+    });
+
+    suite.run("pick_goal/index", pick_x.size(), [&]()
+    {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < pick_x.size(); ++i) {
+            query_ids.clear();
+            scene_index.query(pick_x[i], pick_y[i], query_ids);
+            for (uint32_t id : query_ids) {
+                sum += arrow_contains(scene_goals[id], pick_x[i], pick_y[i]);
+            }
+        }
+        return sum;
+    });
+
+    suite.run("select_in_box/linear", boxes.size(), [&]()
+    {
+        double sum = 0.0;
+        for (const Bounds2& box : boxes) {
+            for (const Pose2_cont& goal : scene_goals) {
+                sum += box.contains(goal.x, goal.y);
+            }
+        }
+        return sum;
+    });
+
+    suite.run("select_in_box/index", boxes.size(), [&]()
+    {
+        double sum = 0.0;
+        for (const Bounds2& box : boxes) {
+            query_ids.clear();
+            scene_index.query(box, query_ids);
+            for (uint32_t id : query_ids) {
+                sum += box.contains(scene_goals[id].x, scene_goals[id].y);
+            }
+        }
+        return sum;
+    });
+
+    if (csv) {
+        print_csv(suite);
+    }
+    else {
+        print_json(suite, num_angles, extent);
+    }
+    return 0;
+}
@@ -0,0 +1,247 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include "heuristic_table.h"
+#include "lattice_planner.h"
+#include "occupancy_grid.h"
+#include "primitive_library.h"
+
+// Plans the same queries on a corpus of random and maze occupancy grids with
+// each primitive set given on the command line, and reports the success
+// rate, expansions, runtime and path cost of each set on each kind of grid.
+// Costs are compared over the queries every set solved.
+
+struct Query
+{
+    int grid;
+    int start_x, start_y;
+    int goal_x, goal_y;
+    double start_heading;   ///< fraction of a turn, discretized per set
+    double goal_heading;
+};
+
+struct PrimitiveSetUnderTest
+{
+    std::string name;
+    PrimitiveLibrary library;
+    HeuristicTable heuristic;
+    std::unique_ptr<LatticePlanner> planner;
+};
+
+struct SetStats
+{
+    SetStats() : num_solved(0), num_expansions(0), elapsed(0.0), common_cost(0.0) { }
+    std::size_t num_solved;
+    std::size_t num_expansions;
+    double elapsed;
+    double common_cost;
+};
+
+static void print_usage(const char* prog)
+{
+    printf("usage: %s [options] LIBRARY[:HEURISTIC]...\n", prog);
+    printf("\n");
+    printf("  -n, --grids N        grids of each kind (default 8)\n");
+    printf("  -q, --queries N      queries per grid (default 8)\n");
+    printf("  -s, --size N         grid width and height in cells (default 96)\n");
+    printf("  -d, --density P      occupied fraction of random grids (default 0.1)\n");
+    printf("  -w, --corridor N     maze corridor width in cells (default 5)\n");
+    printf("  -x, --max-expansions N\n");
+    printf("                       give up on a query after N expansions (default 2000000)\n");
+    printf("      --seed N         random seed (default 1)\n");
+}
+
+/// Return whether ($x, $y) and its eight neighbors are free
+static bool clear_around(const OccupancyGrid& grid, int x, int y)
+{
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            if (grid.occupied(x + dx, y + dy)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void random_free_cell(const OccupancyGrid& grid, std::mt19937& rng, int& x, int& y)
+{
+    std::uniform_int_distribution<int> ux(1, grid.width - 2);
+    std::uniform_int_distribution<int> uy(1, grid.height - 2);
+    do {
+        x = ux(rng);
+        y = uy(rng);
+    }
+    while (!clear_around(grid, x, y));
+}
+
+int main(int argc, char* argv[])
+{
+    int num_grids = 8;
+    int num_queries = 8;
+    int size = 96;
+    double density = 0.1;
+    int corridor_width = 5;
+    unsigned seed = 1;
+    PlannerParams params;
+    params.max_expansions = 2000000;
+
+    enum { OPT_SEED = 256 };
+
+    const struct option long_options[] =
+    {
+        { "grids",      required_argument, 0, 'n' },
+        { "queries",    required_argument, 0, 'q' },
+        { "size",       required_argument, 0, 's' },
+        { "density",    required_argument, 0, 'd' },
+        { "corridor",   required_argument, 0, 'w' },
+        { "max-expansions", required_argument, 0, 'x' },
+        { "seed",       required_argument, 0, OPT_SEED },
+        { "help",       no_argument,       0, 'h' },
+        { 0, 0, 0, 0 }
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "n:q:s:d:w:x:h", long_options, 0)) != -1) {
+        switch (opt) {
+        case 'n':
+            num_grids = atoi(optarg);
+            break;
+        case 'q':
+            num_queries = atoi(optarg);
+            break;
+        case 's':
+            size = atoi(optarg);
+            break;
+        case 'd':
+            density = atof(optarg);
+            break;
+        case 'w':
+            corridor_width = atoi(optarg);
+            break;
+        case 'x':
+            params.max_expansions = strtoul(optarg, 0, 10);
+            break;
+        case OPT_SEED:
+            seed = (unsigned)atoi(optarg);
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (optind >= argc || size < 8) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<PrimitiveSetUnderTest>> sets;
+    for (int i = optind; i < argc; ++i) {
+        std::unique_ptr<PrimitiveSetUnderTest> set(new PrimitiveSetUnderTest);
+        std::string arg = argv[i];
+        std::string::size_type colon = arg.find(':');
+        std::string library_path = arg.substr(0, colon);
+        set->name = arg;
+        if (!set->library.open(library_path)) {
+            fprintf(stderr, "Failed to open primitive library %s\n", library_path.c_str());
+            return 1;
+        }
+        if (colon != std::string::npos) {
+            std::string heuristic_path = arg.substr(colon + 1);
+            if (!set->heuristic.open(heuristic_path) || set->heuristic.num_angles() != set->library.num_angles()) {
+                fprintf(stderr, "Failed to open heuristic table %s for %s\n", heuristic_path.c_str(), library_path.c_str());
+                return 1;
+            }
+        }
+        set->planner.reset(new LatticePlanner(set->library, set->heuristic.is_open() ? &set->heuristic : 0));
+        sets.push_back(std::move(set));
+    }
+
+    const char* kinds[] = { "random", "maze" };
+    for (int kind = 0; kind < 2; ++kind) {
+        std::mt19937 rng(seed + kind);
+        std::vector<OccupancyGrid> grids(num_grids);
+        std::vector<Query> queries;
+        std::uniform_real_distribution<double> heading(0.0, 1.0);
+        for (int g = 0; g < num_grids; ++g) {
+            if (kind == 0) {
+                make_random_grid(size, size, density, rng(), grids[g]);
+            }
+            else {
+                make_maze_grid(size, size, corridor_width, rng(), grids[g]);
+            }
+            for (int q = 0; q < num_queries; ++q) {
+                Query query;
+                query.grid = g;
+                random_free_cell(grids[g], rng, query.start_x, query.start_y);
+                random_free_cell(grids[g], rng, query.goal_x, query.goal_y);
+                query.start_heading = heading(rng);
+                query.goal_heading = heading(rng);
+                queries.push_back(query);
+            }
+        }
+
+        std::vector<SetStats> stats(sets.size());
+        std::vector<std::vector<int64_t>> costs(sets.size(), std::vector<int64_t>(queries.size(), -1));
+        PlanResult result;
+        for (std::size_t s = 0; s < sets.size(); ++s) {
+            LatticePlanner& planner = *sets[s]->planner;
+            const int n = planner.num_angles();
+            for (std::size_t q = 0; q < queries.size(); ++q) {
+                const Query& query = queries[q];
+                Pose2_disc start(query.start_x, query.start_y, (int)(query.start_heading * n) % n);
+                Pose2_disc goal(query.goal_x, query.goal_y, (int)(query.goal_heading * n) % n);
+
+                auto start_time = std::chrono::steady_clock::now();
+                bool solved = planner.plan(grids[query.grid], start, goal, params, result);
+                auto end_time = std::chrono::steady_clock::now();
+
+                stats[s].elapsed += std::chrono::duration<double>(end_time - start_time).count();
+                stats[s].num_expansions += result.num_expansions;
+                if (solved) {
+                    ++stats[s].num_solved;
+                    costs[s][q] = result.cost;
+                }
+            }
+        }
+
+        std::size_t num_common = 0;
+        for (std::size_t q = 0; q < queries.size(); ++q) {
+            bool common = true;
+            for (std::size_t s = 0; s < sets.size(); ++s) {
+                common &= costs[s][q] >= 0;
+            }
+            if (!common) {
+                continue;
+            }
+            ++num_common;
+            for (std::size_t s = 0; s < sets.size(); ++s) {
+                stats[s].common_cost += (double)costs[s][q] / PRIMITIVE_COST_SCALE;
+            }
+        }
+
+        printf("%s grids: %d x %d cells, %zu queries, %zu solved by every set\n", kinds[kind], size, size, queries.size(), num_common);
+        printf("%-40s %8s %14s %12s %12s\n", "set", "success", "expansions/q", "ms/query", "mean cost");
+        for (std::size_t s = 0; s < sets.size(); ++s) {
+            const double nq = (double)queries.size();
+            printf("%-40s %7.1f%% %14.0f %12.3f %12.3f\n",
+                    sets[s]->name.c_str(),
+                    100.0 * stats[s].num_solved / nq,
+                    stats[s].num_expansions / nq,
+                    1e3 * stats[s].elapsed / nq,
+                    num_common ? stats[s].common_cost / num_common : 0.0);
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "angles.h"
+#include "unicycle_motions.h"
+
+// Compares sample_unicycle_motion against sample_unicycle_motion_direct over
+// every feasible arc primitive of a lattice, reporting throughput and the
+// largest difference between the two. Also checks the lazy sampler and the
+// parametric end pose against them.
+
+typedef void (*SampleFunction)(const UnicycleMotion&, int, Pose2_cont*);
+
+static double time_sampling(
+    SampleFunction sample,
+    const std::vector<UnicycleMotion>& motions,
+    const std::vector<int>& num_samples,
+    std::vector<Pose2_cont>& buffer,
+    int repetitions)
+{
+    double checksum = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; ++r) {
+        for (std::size_t i = 0; i < motions.size(); ++i) {
+            sample(motions[i], num_samples[i], &buffer[0]);
+            checksum += buffer[num_samples[i] - 1].x;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    // keep the loop from being optimized away
+    if (checksum == 12345.678) {
+        printf("\n");
+    }
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    int num_angles = argc > 1 ? atoi(argv[1]) : 64;
+    int extent = argc > 2 ? atoi(argv[2]) : 15;
+    int repetitions = argc > 3 ? atoi(argv[3]) : 3;
+
+    Pose2Array starts;
+    Pose2Array goals;
+    for (int a = 0; a < num_angles; ++a) {
+        for (int x = -extent; x <= extent; ++x) {
+            for (int y = -extent; y <= extent; ++y) {
+                for (int g = 0; g < num_angles; ++g) {
+                    starts.push_back(Pose2_cont(0.0, 0.0, realize_angle(a, num_angles)));
+                    goals.push_back(Pose2_cont(x, y, realize_angle(g, num_angles)));
+                }
+            }
+        }
+    }
+
+    UnicycleMotionBatch batch;
+    solve_unicycle_motions(starts, goals, batch);
+
+    std::vector<UnicycleMotion> motions;
+    std::vector<std::size_t> motion_index;
+    std::vector<int> num_samples;
+    std::size_t num_poses = 0;
+    int max_samples = 0;
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        if (batch.type[i] != UNICYCLE_ARC) {
+            continue;
+        }
+        UnicycleMotion motion = batch.motion(starts, i);
+        int n = num_unicycle_motion_samples(motion);
+        if (n < 2) {
+            continue;
+        }
+        motions.push_back(motion);
+        motion_index.push_back(i);
+        num_samples.push_back(n);
+        num_poses += n;
+        max_samples = std::max(max_samples, n);
+    }
+
+    std::vector<Pose2_cont> buffer(max_samples);
+    std::vector<Pose2_cont> reference(max_samples);
+
+    double max_position_error = 0.0;
+    double max_relative_error = 0.0;
+    double max_yaw_error = 0.0;
+    for (std::size_t i = 0; i < motions.size(); ++i) {
+        sample_unicycle_motion(motions[i], num_samples[i], &buffer[0]);
+        sample_unicycle_motion_direct(motions[i], num_samples[i], &reference[0]);
+        for (int j = 0; j < num_samples[i]; ++j) {
+            double error = std::max(fabs(buffer[j].x - reference[j].x), fabs(buffer[j].y - reference[j].y));
+            max_position_error = std::max(max_position_error, error);
+            max_relative_error = std::max(max_relative_error, error / fabs(motions[i].radius));
+            max_yaw_error = std::max(max_yaw_error, fabs(buffer[j].yaw - reference[j].yaw));
+        }
+    }
+
+    // the sampler must reproduce the bulk kernel exactly, and the parametric
+    // end pose must land on the goal
+    std::size_t num_sampler_mismatches = 0;
+    double max_end_error = 0.0;
+    double max_spacing_ratio = 0.0;
+    const double resolution = 0.05;
+    for (std::size_t i = 0; i < motions.size(); ++i) {
+        sample_unicycle_motion(motions[i], num_samples[i], &buffer[0]);
+        UnicycleMotionSampler sampler(motions[i], num_samples[i]);
+        for (int j = 0; !sampler.done(); ++j) {
+            if (!(sampler.next() == buffer[j])) {
+                ++num_sampler_mismatches;
+            }
+        }
+
+        Pose2_cont end = unicycle_motion_end(motions[i]);
+        Pose2_cont goal = goals[motion_index[i]];
+        max_end_error = std::max(max_end_error, std::max(fabs(end.x - goal.x), fabs(end.y - goal.y)));
+
+        UnicycleMotionSampler fine(motions[i], num_unicycle_motion_samples(motions[i], resolution));
+        Pose2_cont prev = fine.next();
+        while (!fine.done()) {
+            Pose2_cont p = fine.next();
+            max_spacing_ratio = std::max(max_spacing_ratio, std::hypot(p.x - prev.x, p.y - prev.y) / resolution);
+            prev = p;
+        }
+    }
+
+    double direct_time = time_sampling(sample_unicycle_motion_direct, motions, num_samples, reference, repetitions);
+    double kernel_time = time_sampling(sample_unicycle_motion, motions, num_samples, buffer, repetitions);
+
+    const double total_poses = (double)num_poses * repetitions;
+    printf("%zu arc motions, %zu poses, %d repetitions\n", motions.size(), num_poses, repetitions);
+    printf("direct:      %8.3f s  %6.2f ns/pose\n", direct_time, 1e9 * direct_time / total_poses);
+    printf("incremental: %8.3f s  %6.2f ns/pose\n", kernel_time, 1e9 * kernel_time / total_poses);
+    printf("speedup:     %8.2fx\n", direct_time / kernel_time);
+    printf("max position error %g (%g x radius), max yaw error %g\n", max_position_error, max_relative_error, max_yaw_error);
+    printf("sampler mismatches %zu, max end pose error %g, max spacing at resolution %g: %g x resolution\n",
+            num_sampler_mismatches, max_end_error, resolution, max_spacing_ratio);
+    return 0;
+}
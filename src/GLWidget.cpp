@@ -1,12 +1,67 @@
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <cstdio>
-#include <Eigen/Dense>
 #include <GL/gl.h>
 #include <GL/glu.h>
 #include "GLWidget.h"
+#include "angles.h"
+#include "discrete_heading.h"
+#include "footprint.h"
+#include "lattice_symmetry.h"
 #include "logging.h"
+#include "PrimitiveRenderer.h"
 #include "unicycle_motions.h"
 
+/// Half the width of the world the camera can move over, in cells
+static const int WORLD_EXTENT = 1000;
+
+/// Half the width of the area shown at startup
+static const double INITIAL_VIEW_EXTENT = 15.0;
+
+/// Closest zoom, in pixels per cell
+static const double MAX_PIXELS_PER_CELL = 400.0;
+
+/// Grid lines closer than this many pixels are left out
+static const double MIN_GRID_SPACING = 6.0;
+
+/// Curves are drawn within this many pixels of their poses
+static const double CURVE_TOLERANCE = 0.25;
+
+/// Farthest any part of an arrow is from its pose
+static const double ARROW_RADIUS = 0.6;
+
+/// Size of the outlines of the discrete poses a drag snaps to, relative to an arrow
+static const double GUIDELINE_SCALE = 1.5;
+
+/// Radius of the reachability overlay around the start
+static const int COVERAGE_RADIUS = 30;
+
+/// Width of the goal index's buckets in cells. A few arrows wide keeps box
+/// selections to few buckets while a click still checks only a handful.
+static const double GOAL_INDEX_CELL_SIZE = 4.0;
+
+/// Shortest time between stats_changed() signals
+static const std::chrono::milliseconds STATS_REPORT_INTERVAL(250);
+
+/// Layout of the stats overlay, in pixels
+static const int STATS_MARGIN = 8;
+static const int STATS_WIDTH = 300;
+static const int STATS_LINE_HEIGHT = 14;
+
+/// Frame time that fills the overlay's bar: one refresh at 60 Hz
+static const double STATS_BAR_MS = 1000.0 / 60.0;
+
+static const float STATS_STAGE_COLORS[NUM_FRAME_STAGES][3] =
+{
+    { 0.9f, 0.6f, 0.0f },   // upload
+    { 0.0f, 0.7f, 0.2f },   // coverage
+    { 0.5f, 0.5f, 0.5f },   // grid
+    { 1.0f, 0.0f, 1.0f },   // curves
+    { 1.0f, 0.0f, 0.0f },   // arrows
+    { 0.2f, 0.4f, 1.0f },   // other
+};
+
 static int discretize(double d, double res)
 {
     return (int)(d / res);
@@ -35,98 +90,291 @@ GLWidget::GLWidget(const QGLFormat& format, QWidget* parent, const QGLWidget* sh
     construct();
 }
 
+GLWidget::~GLWidget()
+{
+    motion_worker_.set_result_callback(std::function<void()>());
+
+    // the buffers belong to this widget's context
+    makeCurrent();
+    renderer_->release();
+}
+
 void GLWidget::construct()
 {
     disc_mode_ = true;
-    min_ = Pose2_disc(-15, -15, 0);
-    max_ = Pose2_disc(15, 15, 360);
+    min_ = Pose2_disc(-WORLD_EXTENT, -WORLD_EXTENT, 0);
+    max_ = Pose2_disc(WORLD_EXTENT, WORLD_EXTENT, 360);
+
+    view_center_ = QPointF(0.0, 0.0);
+    view_scale_ = 0.0;
 
     start_ = Pose2_cont(0.0, 0.0, 0.0);
-    goals_.push_back(Pose2_cont(10.0, 0.0, 0.0));
+    goal_index_ = SpatialIndex(GOAL_INDEX_CELL_SIZE);
+    add_goal(Pose2_cont(10.0, 0.0, 0.0));
+    clear_selection();
+    rubber_band_ = false;
 
     left_button_down_ = false;
     right_button_down_ = false;
+    middle_button_down_ = false;
     num_angles_ = 16;
+
+    coverage_overlay_ = false;
+    coverage_steps_ = 3;
+    coverage_dirty_ = true;
+    scene_dirty_ = true;
+    scene_scale_ = 0.0;
+    renderer_.reset(new PrimitiveRenderer);
+    stats_overlay_ = false;
+    outlines_dirty_ = true;
+
+    generator_ = create_motion_generator(motion_generator_names().front(), generator_params_);
+
+    // repaint whenever the worker finishes; update() must be called on the
+    // GUI thread
+    motions_dirty_ = true;
+    motion_worker_.set_result_callback([this]()
+    {
+        QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+    });
+}
+
+void GLWidget::set_generator(const QString& name)
+{
+    if (name.toStdString() != generator_->name()) {
+        replace_generator(name.toStdString());
+    }
+}
+
+void GLWidget::set_turning_radius(double radius)
+{
+    if (radius > 0.0 && radius != generator_params_.turning_radius) {
+        generator_params_.turning_radius = radius;
+        replace_generator(generator_->name());
+    }
+}
+
+void GLWidget::replace_generator(const std::string& name)
+{
+    std::unique_ptr<MotionGenerator> generator = create_motion_generator(name, generator_params_);
+    if (!generator) {
+        return;
+    }
+
+    // the worker makes its own copy of the generator from the next request
+    generator_ = std::move(generator);
+    motions_dirty_ = true;
+    update();
+}
+
+void GLWidget::move_start(const Pose2_cont& pose)
+{
+    if (pose != start_) {
+        // every motion depends on the start; the worker regenerates them all
+        start_ = pose;
+        motions_dirty_ = true;
+        scene_dirty_ = true;
+        outlines_dirty_ = true;
+    }
+}
+
+void GLWidget::move_goal(GoalHandle goal, const Pose2_cont& pose)
+{
+    const Pose2_cont old_pose = goals_.pose(goal);
+    if (pose != old_pose) {
+        stale_goals_.push_back(old_pose);
+        goals_.set_pose(goal, pose);
+        goal_index_.update(goal.slot, arrow_bounds(pose));
+        motions_dirty_ = true;
+        scene_dirty_ = true;
+        outlines_dirty_ = true;
+    }
+}
+
+GoalHandle GLWidget::add_goal(const Pose2_cont& pose)
+{
+    GoalHandle goal = goals_.insert(pose);
+    goal_index_.insert(goal.slot, arrow_bounds(pose));
+    motions_dirty_ = true;
+    scene_dirty_ = true;
+    return goal;
+}
+
+void GLWidget::remove_goal(GoalHandle goal)
+{
+    stale_goals_.push_back(goals_.pose(goal));
+    goal_index_.remove(goal.slot);
+    goals_.erase(goal);
+    motions_dirty_ = true;
+    scene_dirty_ = true;
+    outlines_dirty_ = true;
 }
 
 void GLWidget::initializeGL()
 {
     glClearColor(1.0f, 0.98f, 0.98f, 1.0f);
     glLineWidth(2.0f);
+
+    renderer_->initialize();
+    scene_dirty_ = true;
+    outlines_dirty_ = true;
+    coverage_dirty_ = true;
 }
 
 void GLWidget::paintGL()
 {
+    stats_recorder_.begin_frame();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    apply_view();
     glLoadIdentity();
 
-    draw_grid();
+    // upload the scene again when it changed, when the view leaves the area
+    // it covers, or when the zoom has moved far from the scale it was
+    // decimated for
+    if (motions_dirty_) {
+        request_motions();
+    }
+    if (motion_worker_.poll(motions_)) {
+        scene_dirty_ = true;
+        coverage_dirty_ = true;
+        stats_recorder_.motions_received(motions_.version, 1000.0 * motions_.generation_time, motions_.num_generated);
+        frame_stats_.num_primitives = 0;
+        for (std::size_t i = 0; i < motions_.size(); ++i) {
+            frame_stats_.num_primitives += motions_.num_poses(i) > 0;
+        }
+        frame_stats_.num_poses = motions_.poses.size();
+    }
+    end_stage(FRAME_STAGE_OTHER);
 
-    if (disc_mode_)
+    const Bounds2 view = view_bounds();
+    if (scene_dirty_ || !scene_area_.contains(view) ||
+        view_scale_ < 0.5 * scene_scale_ || view_scale_ > 2.0 * scene_scale_)
     {
-        draw_guidelines();
+        upload_scene(view);
     }
+    end_stage(FRAME_STAGE_UPLOAD);
 
-    for (const Pose2_cont goal : goals_) {
-        std::vector<Pose2_cont> motion = generate_unicycle_motion(start_, goal);
-        draw_line(motion);
+    if (coverage_overlay_) {
+        draw_coverage();
+        end_stage(FRAME_STAGE_COVERAGE);
     }
 
-    // draw the start
-    draw_arrow(start_.x, start_.y, start_.yaw, 0.0, 1.0, 0.0);
+    renderer_->draw_grid();
+    end_stage(FRAME_STAGE_GRID);
 
-    // draw the goal
-    for (const Pose2_cont goal : goals_) {
-        draw_arrow(goal.x, goal.y, goal.yaw, 1.0, 0.0, 0.0);
-    }
+    renderer_->draw_motions(1.0f, 0.0f, 1.0f);
+    end_stage(FRAME_STAGE_CURVES);
+    renderer_->draw_arrows();
+    end_stage(FRAME_STAGE_ARROWS);
 
     // draw the selection
     draw_selection();
 
+    // the overlay shows the stats up to the last repaint
+    frame_stats_.num_goals = goals_.size();
+    frame_stats_.num_vertices = renderer_->num_motion_vertices();
+    frame_stats_.num_arrows = renderer_->num_arrows();
+    if (stats_overlay_) {
+        draw_stats();
+    }
+
     glFlush();
     swapBuffers();
+    stats_recorder_.end_frame(frame_stats_);
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now - stats_reported_ >= STATS_REPORT_INTERVAL) {
+        stats_reported_ = now;
+        emit stats_changed();
+    }
 }
 
 void GLWidget::mousePressEvent(QMouseEvent *event)
 {
+    stats_recorder_.input();
+    if (event->button() == Qt::MidButton) {
+        middle_button_down_ = true;
+        pan_last_pos_ = event->pos();
+        return;
+    }
+
     QPointF world_point = viewport_to_world(event->posF());
 
-    // select the target pose
+    // select the target pose; shift adds to the selection
     if (event->button() == Qt::LeftButton || event->button() == Qt::RightButton) {
-        clear_selection();
-        select_at(world_point);
+        const bool extend = (event->modifiers() & Qt::ShiftModifier) != 0;
+        GoalHandle goal = pick_goal(world_point);
+        if (!extend && !goal.null() && is_selected(goal)) {
+            // keep the selection so that every selected goal moves together
+            selection_.selected_goal = goal;
+        }
+        else {
+            if (!extend) {
+                clear_selection();
+            }
+            select_at(world_point);
+            if (!selection_.start_selected && goal.null() && event->button() == Qt::LeftButton) {
+                rubber_band_ = true;
+                rubber_band_start_ = world_point;
+                rubber_band_end_ = world_point;
+            }
+        }
         if (selection_.goal_selected || selection_.start_selected) {
             emit gui_changed();
         }
     }
 
+    // the guidelines show while a button is down
     if (event->button() == Qt::LeftButton) {
         left_button_down_ = true;
         left_button_down_pos_ = world_point;
+        outlines_dirty_ = true;
         update();
     }
     else if (event->button() == Qt::RightButton) {
         right_button_down_ = true;
         right_button_down_pos_ = world_point;
+        outlines_dirty_ = true;
         update();
     }
 }
 
 void GLWidget::mouseMoveEvent(QMouseEvent *event)
 {
+    stats_recorder_.input();
+    if (middle_button_down_) {
+        // drag the world along with the cursor
+        const double dx = (event->pos().x() - pan_last_pos_.x()) * view_scale_;
+        const double dy = (event->pos().y() - pan_last_pos_.y()) * view_scale_;
+        view_center_ = QPointF(
+                std::min(std::max(view_center_.x() - dx, (double)min_.x), (double)max_.x),
+                std::min(std::max(view_center_.y() + dy, (double)min_.y), (double)max_.y));
+        pan_last_pos_ = event->pos();
+        update();
+        return;
+    }
+
     QPointF world_point = viewport_to_world(event->posF());
 
-    if (left_button_down_) {
+    if (rubber_band_) {
+        rubber_band_end_ = world_point;
+    }
+    else if (left_button_down_) {
         // translate the selected pose
         if (selection_.start_selected) {
-            start_.x = world_point.x();
-            start_.y = world_point.y();
-            DEBUG_PRINT("Moved the start to (%0.3f, %0.3f)", world_point.x(), world_point.y());
+            move_start(Pose2_cont(world_point.x(), world_point.y(), start_.yaw));
+            LOG_DEBUG("Moved the start to (%0.3f, %0.3f)", world_point.x(), world_point.y());
         }
         else if (selection_.goal_selected) {
-            selection_.selected_goal->x = world_point.x();
-            selection_.selected_goal->y = world_point.y();
-            DEBUG_PRINT("Moved the selected goal to (%0.3f, %0.3f)", world_point.x(), world_point.y());
+            // the goal under the cursor follows it and the rest keep their offsets
+            const Pose2_cont selected = goals_.pose(selection_.selected_goal);
+            const double dx = world_point.x() - selected.x;
+            const double dy = world_point.y() - selected.y;
+            for (GoalHandle goal : selection_.goals) {
+                const Pose2_cont pose = goals_.pose(goal);
+                move_goal(goal, Pose2_cont(pose.x + dx, pose.y + dy, pose.yaw));
+            }
+            LOG_DEBUG("Moved %zu selected goals by (%0.3f, %0.3f)", selection_.goals.size(), dx, dy);
         }
     }
     if (right_button_down_) {
@@ -136,12 +384,15 @@ void GLWidget::mouseMoveEvent(QMouseEvent *event)
         double angle = atan2(dy, dx);
 
         if (selection_.start_selected) {
-            start_.yaw = angle;
-            DEBUG_PRINT("Moved the start yaw to %0.3f", angle);
+            move_start(Pose2_cont(start_.x, start_.y, angle));
+            LOG_DEBUG("Moved the start yaw to %0.3f", angle);
         }
         else if (selection_.goal_selected) {
-            selection_.selected_goal->yaw = angle;
-            DEBUG_PRINT("Moved the selected goal yaw to %0.3f", angle);
+            for (GoalHandle goal : selection_.goals) {
+                const Pose2_cont pose = goals_.pose(goal);
+                move_goal(goal, Pose2_cont(pose.x, pose.y, angle));
+            }
+            LOG_DEBUG("Moved the selected goal yaws to %0.3f", angle);
         }
     }
 
@@ -150,13 +401,25 @@ void GLWidget::mouseMoveEvent(QMouseEvent *event)
 
 void GLWidget::mouseReleaseEvent(QMouseEvent *event)
 {
-    DEBUG_PRINT("Mouse release event");
+    stats_recorder_.input();
+    LOG_DEBUG("Mouse release event");
+    if (event->button() == Qt::MidButton) {
+        middle_button_down_ = false;
+        return;
+    }
+
+    if (rubber_band_ && event->button() == Qt::LeftButton) {
+        rubber_band_ = false;
+        select_in_box(rubber_band_start_, viewport_to_world(event->posF()));
+        emit gui_changed();
+    }
+
     if (disc_mode_) {
         // snap to nearest discrete pose
-        DEBUG_PRINT("Snapping to discrete poses");
-        start_ = discretize(start_);
-        for (Pose2_cont& pose : goals_) {
-            pose = discretize(pose);
+        LOG_DEBUG("Snapping to discrete poses");
+        move_start(discretize(start_));
+        for (std::size_t i = 0; i < goals_.size(); ++i) {
+            move_goal(goals_.handle(i), discretize(goals_[i]));
         }
 
         emit gui_changed();
@@ -168,6 +431,7 @@ void GLWidget::mouseReleaseEvent(QMouseEvent *event)
     else if (event->button() == Qt::RightButton) {
         right_button_down_ = false;
     }
+    outlines_dirty_ = true;
 
     update();
 }
@@ -177,74 +441,28 @@ bool GLWidget::hits_start(const QPointF& point) const
     return hits_arrow(start_, point);
 }
 
-bool GLWidget::hits_goal(std::list<Pose2_cont>::iterator goal_it, const QPointF& point) const
-{
-    return hits_arrow(*goal_it, point);
-}
-
 bool GLWidget::hits_arrow(const Pose2_cont& pose, const QPointF& point) const
 {
-    bool selected = false;
-
-    Eigen::Vector3d pv(point.x(), point.y(), 0.0);
-
-    Eigen::Affine3d transform = Eigen::Translation3d(pose.x, pose.y, 0.0) * Eigen::AngleAxisd(pose.yaw, Eigen::Vector3d::UnitZ());
-
-    {
-        Eigen::Vector3d a(0.166, 0.3, 0.0);
-        Eigen::Vector3d b(0.166, -0.3, 0.0);
-        Eigen::Vector3d c(0.5, 0.0, 0.0);
-
-        a = transform * a;
-        b = transform * b;
-        c = transform * c;
-
-        selected |= point_in_triangle(pv, a, b, c);
-    }
-
-    {
-        Eigen::Vector3d a(-0.5, -0.15, 0.0);
-        Eigen::Vector3d b(0.166, -0.15, 0.0);
-        Eigen::Vector3d c(-0.15, 0.15, 0.0);
-
-        a = transform * a;
-        b = transform * b;
-        c = transform * c;
-
-        selected |= point_in_triangle(pv, a, b, c);
-    }
-
-    {
-        Eigen::Vector3d a(0.166, -0.15, 0.0);
-        Eigen::Vector3d b(0.166,  0.15, 0.0);
-        Eigen::Vector3d c(-0.5, 0.15, 0.0);
-
-        a = transform * a;
-        b = transform * b;
-        c = transform * c;
-
-        selected |= point_in_triangle(pv, a, b, c);
-    }
-
-    return selected;
+    return arrow_contains(pose, point.x(), point.y());
 }
 
 void GLWidget::toggle_disc_mode()
 {
     disc_mode_ = !(disc_mode_);
 
-    DEBUG_PRINT("Toggle Discrete Mode: %s!", (disc_mode_ ? "On" : "Off"));
+    LOG_DEBUG("Toggle Discrete Mode: %s!", (disc_mode_ ? "On" : "Off"));
 
     // continuous -> discrete mode
     if (disc_mode_) {
-        start_ = discretize(start_);
-        for (Pose2_cont& pose : goals_) {
-            pose = discretize(pose);
+        move_start(discretize(start_));
+        for (std::size_t i = 0; i < goals_.size(); ++i) {
+            move_goal(goals_.handle(i), discretize(goals_[i]));
         }
     }
 
     left_button_down_ = false;
     right_button_down_ = false;
+    outlines_dirty_ = true;
 
     update();
     emit gui_changed();
@@ -252,7 +470,7 @@ void GLWidget::toggle_disc_mode()
 
 void GLWidget::add_discrete_goal()
 {
-    goals_.push_back(Pose2_cont(0.0, 0.0, 0.0));
+    add_goal(Pose2_cont(0.0, 0.0, 0.0));
     emit gui_changed();
     update();
 }
@@ -260,8 +478,10 @@ void GLWidget::add_discrete_goal()
 void GLWidget::remove_discrete_goal()
 {
     if (selection_.goal_selected) {
-        goals_.erase(selection_.selected_goal);
-        selection_.goal_selected = false;
+        for (GoalHandle goal : selection_.goals) {
+            remove_goal(goal);
+        }
+        clear_selection();
         update();
         emit gui_changed();
     }
@@ -269,234 +489,439 @@ void GLWidget::remove_discrete_goal()
 
 void GLWidget::set_num_angles(int num_angles)
 {
-    DEBUG_PRINT("Set Num Angles to %d!", num_angles);
+    LOG_DEBUG("Set Num Angles to %d!", num_angles);
     num_angles_ = num_angles;
+    coverage_dirty_ = true;
+    outlines_dirty_ = true;
     update();
 }
 
+void GLWidget::set_coverage_overlay(bool enabled)
+{
+    coverage_overlay_ = enabled;
+    update();
+}
+
+void GLWidget::set_stats_overlay(bool enabled)
+{
+    stats_overlay_ = enabled;
+    update();
+}
+
+void GLWidget::set_coverage_steps(int steps)
+{
+    if (steps != coverage_steps_) {
+        coverage_steps_ = steps;
+        coverage_dirty_ = true;
+        update();
+    }
+}
+
 void GLWidget::set_disc_start_angle(int angle)
 {
-    printf("Set Discrete Start Angle to %d!\n", angle);
-    start_.yaw = realize_angle(angle, num_angles_);
+    LOG_DEBUG("Set Discrete Start Angle to %d!", angle);
+    move_start(Pose2_cont(start_.x, start_.y, realize_angle(angle, num_angles_)));
     update();
 }
 
 void GLWidget::set_disc_start_x(int disc_x)
 {
-    start_.x = (double)disc_x;
+    move_start(Pose2_cont((double)disc_x, start_.y, start_.yaw));
     update();
 }
 
 void GLWidget::set_disc_start_y(int disc_y)
 {
-    start_.y = (double)disc_y;
+    move_start(Pose2_cont(start_.x, (double)disc_y, start_.yaw));
     update();
 }
 
 void GLWidget::set_disc_goal_angle(int angle)
 {
-    printf("Set Discrete Goal Angle to %d!\n", angle);
+    LOG_DEBUG("Set Discrete Goal Angle to %d!", angle);
     assert(selection_.goal_selected);
-    selection_.selected_goal->yaw = realize_angle(angle, num_angles_);
+    const Pose2_cont goal = goals_.pose(selection_.selected_goal);
+    move_goal(selection_.selected_goal, Pose2_cont(goal.x, goal.y, realize_angle(angle, num_angles_)));
     update();
 }
 
 void GLWidget::set_disc_goal_x(int disc_x)
 {
     assert(selection_.goal_selected);
-    selection_.selected_goal->x = (double)disc_x;
+    const Pose2_cont goal = goals_.pose(selection_.selected_goal);
+    move_goal(selection_.selected_goal, Pose2_cont((double)disc_x, goal.y, goal.yaw));
     update();
 }
 
 void GLWidget::set_disc_goal_y(int disc_y)
 {
     assert(selection_.goal_selected);
-    selection_.selected_goal->y = (double)disc_y;
+    const Pose2_cont goal = goals_.pose(selection_.selected_goal);
+    move_goal(selection_.selected_goal, Pose2_cont(goal.x, (double)disc_y, goal.yaw));
     update();
 }
 
+void GLWidget::wheelEvent(QWheelEvent *event)
+{
+    stats_recorder_.input();
+    // one notch of a standard wheel is 120 units; four notches double the zoom
+    zoom_view(pow(2.0, -event->delta() / 480.0), QPointF(event->pos().x(), event->pos().y()));
+}
+
 void GLWidget::resizeGL(int width, int height)
 {
     glViewport(0, 0, width, height);
+
+    // the projection follows the camera; see apply_view()
+    if (view_scale_ == 0.0 && width > 0 && height > 0) {
+        fit_view(Bounds2(-INITIAL_VIEW_EXTENT, -INITIAL_VIEW_EXTENT, INITIAL_VIEW_EXTENT, INITIAL_VIEW_EXTENT));
+    }
+}
+
+Bounds2 GLWidget::view_bounds() const
+{
+    const double half_width = 0.5 * width() * view_scale_;
+    const double half_height = 0.5 * height() * view_scale_;
+    return Bounds2(
+            view_center_.x() - half_width, view_center_.y() - half_height,
+            view_center_.x() + half_width, view_center_.y() + half_height);
+}
+
+void GLWidget::fit_view(const Bounds2& area)
+{
+    view_center_ = QPointF(0.5 * (area.min_x + area.max_x), 0.5 * (area.min_y + area.max_y));
+    view_scale_ = std::max((area.max_x - area.min_x) / std::max(width(), 1), (area.max_y - area.min_y) / std::max(height(), 1));
+    update();
+}
+
+void GLWidget::zoom_view(double factor, const QPointF& viewport_coord)
+{
+    // zoom out no further than the whole world
+    const double min_scale = 1.0 / MAX_PIXELS_PER_CELL;
+    const double max_scale = (max_.x - min_.x) / std::max(std::min(width(), height()), 1);
+    const double scale = std::min(std::max(view_scale_ * factor, min_scale), max_scale);
+
+    // keep the world point under the cursor where it is
+    const QPointF anchor = viewport_to_world(viewport_coord);
+    const double ratio = scale / view_scale_;
+    view_center_ = QPointF(
+            anchor.x() + (view_center_.x() - anchor.x()) * ratio,
+            anchor.y() + (view_center_.y() - anchor.y()) * ratio);
+    view_scale_ = scale;
+    update();
+}
+
+void GLWidget::apply_view()
+{
+    const Bounds2 view = view_bounds();
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    gluOrtho2D((GLdouble)min_.x, (GLdouble)max_.x, (GLdouble)min_.y, (GLdouble)max_.y);
+    gluOrtho2D(view.min_x, view.max_x, view.min_y, view.max_y);
     glMatrixMode(GL_MODELVIEW);
 }
 
 QPointF GLWidget::viewport_to_world(const QPointF& viewport_coord) const
 {
-    const double world_width = max_.x - min_.x;
-    const double world_height = max_.y - min_.y;
-    const double world_x = world_width * viewport_coord.x() / width() + min_.x;
-    const double world_y = world_height * (1.0 - viewport_coord.y() / height()) + min_.y;
+    const Bounds2 view = view_bounds();
+    const double world_x = view.min_x + viewport_coord.x() * view_scale_;
+    const double world_y = view.max_y - viewport_coord.y() * view_scale_;
     return QPointF(world_x, world_y);
 }
 
-void GLWidget::draw_grid()
+void GLWidget::request_motions()
+{
+    MotionRequest& request = motion_request_;
+    request.generator = generator_->name();
+    request.generator_params = generator_params_;
+    request.resolution = 0.0;
+    request.start = start_;
+    request.goals = goals_.poses();
+    request.stale_goals.clear();
+    request.stale_goals.swap(stale_goals_);
+
+    stats_recorder_.motions_requested(motion_worker_.submit(request));
+    motions_dirty_ = false;
+}
+
+void GLWidget::update_coverage()
 {
-    // draw the grid
-    glBegin(GL_LINES);
-    glColor3f(0.8f, 0.8f, 0.8f);
-    for (int x = min_.x; x <= max_.x; ++x) {
-        if (x != 0 && (x % 5)) {
-            glVertex2d((double)x, min_.y);
-            glVertex2d((double)x, max_.y);
+    if (!coverage_pool_) {
+        coverage_pool_.reset(new WorkStealingPool);
+    }
+
+    // the coverage follows the motions on screen, which may lag the edits
+    const Pose2_cont& start = motions_.start;
+    const int start_angle = discretize_angle(start.yaw, num_angles_);
+
+    // the designed primitives only start at the start heading; every heading
+    // that a lattice symmetry maps it onto gets their images
+    LatticeEdges edges(num_angles_);
+    for (std::size_t i = 0; i < motions_.size(); ++i) {
+        if (motions_.num_poses(i) == 0) {
+            continue;
+        }
+        const Pose2_cont goal = motions_.goals[i];
+        Pose2_disc end((int)std::round(goal.x - start.x), (int)std::round(goal.y - start.y), discretize_angle(goal.yaw, num_angles_));
+        if (end.x == 0 && end.y == 0) {
+            continue;
+        }
+        for (int a = 0; a < num_angles_; ++a) {
+            LatticeTransform t;
+            if (find_lattice_transform(start_angle, a, num_angles_, t)) {
+                Pose2_disc e = transform_pose(t, end, num_angles_);
+                LatticeEdge edge = { e.x, e.y, e.yaw, 0 };
+                edges[a].push_back(edge);
+            }
         }
     }
-    for (int y = min_.y; y <= max_.y; ++y) {
-        if (y != 0 && (y % 5)) {
-            glVertex2d(min_.x, y);
-            glVertex2d(max_.x, y);
+
+    ReachabilityParams params;
+    params.radius = COVERAGE_RADIUS;
+    params.max_steps = coverage_steps_;
+    lattice_reachability(edges, start_angle, params, *coverage_pool_, coverage_);
+
+    // shade each cell by the fraction of headings reached there, around the
+    // start the motions were generated from
+    const int sx = (int)std::round(start.x);
+    const int sy = (int)std::round(start.y);
+    coverage_cells_.clear();
+    for (int dy = -COVERAGE_RADIUS; dy <= COVERAGE_RADIUS; ++dy) {
+        for (int dx = -COVERAGE_RADIUS; dx <= COVERAGE_RADIUS; ++dx) {
+            if (!coverage_.reached.contains(dx, dy)) {
+                continue;
+            }
+            const std::size_t i = coverage_.cell_index(dx, dy);
+            float cell[] = { (float)(sx + dx), (float)(sy + dy), 1.0f, 0.0f, 0.0f, 0.12f };
+            if (coverage_.cell_steps[i] != REACH_UNREACHED) {
+                const float fraction = (float)coverage_.cell_headings[i] / num_angles_;
+                cell[2] = 0.0f;
+                cell[3] = 0.7f;
+                cell[4] = 0.2f;
+                cell[5] = 0.1f + 0.4f * fraction;
+            }
+            coverage_cells_.insert(coverage_cells_.end(), cell, cell + 6);
         }
     }
+    renderer_->set_cells(coverage_cells_.data(), coverage_cells_.size() / 6);
+    coverage_dirty_ = false;
+}
+
+void GLWidget::draw_coverage()
+{
+    if (coverage_dirty_) {
+        update_coverage();
+    }
+    renderer_->draw_cells();
+}
 
-    glColor3f(0.5f, 0.5f, 0.5f);
-    for (int x = min_.x; x <= max_.x; ++x) {
-        if ((x % 5) == 0) {
-            glVertex2d((double)x, min_.y);
-            glVertex2d((double)x, max_.y);
+void GLWidget::upload_scene(const Bounds2& view)
+{
+    // cover the view and half its size again on every side
+    const Bounds2 area = view.inflated(0.5 * std::max(view.max_x - view.min_x, view.max_y - view.min_y));
+    if (!area.contains(scene_area_) || !scene_area_.contains(area)) {
+        outlines_dirty_ = true;     // they are culled to the same area
+    }
+    scene_area_ = area;
+    scene_scale_ = view_scale_;
+
+    // grid lines every 1, 5, 25, ... cells, whichever are far enough apart to see
+    int step = 1;
+    while (step < max_.x - min_.x && step / view_scale_ < MIN_GRID_SPACING) {
+        step *= 5;
+    }
+    const Bounds2 grid_area(
+            std::max(scene_area_.min_x, (double)min_.x), std::max(scene_area_.min_y, (double)min_.y),
+            std::min(scene_area_.max_x, (double)max_.x), std::min(scene_area_.max_y, (double)max_.y));
+    renderer_->set_grid(grid_area, step);
+
+    // the motions are the worker's last result and the arrows the current
+    // poses, so the arrows follow a drag while the motions catch up
+    const double tolerance = CURVE_TOLERANCE * view_scale_;
+    const Bounds2 arrow_area = scene_area_.inflated(ARROW_RADIUS);
+    renderer_->begin_scene();
+    for (std::size_t i = 0; i < motions_.size(); ++i) {
+        if (scene_area_.intersects(motions_.bounds[i])) {
+            renderer_->add_motion(motions_.motion(i), motions_.num_poses(i), tolerance);
         }
     }
-    for (int y = min_.y; y <= max_.y; ++y) {
-        if (y % 5 == 0) {
-            glVertex2d(min_.x, y);
-            glVertex2d(max_.x, y);
+    if (arrow_area.contains(start_.x, start_.y)) {
+        renderer_->add_arrow(start_, 0.0f, 1.0f, 0.0f);
+    }
+    for (const Pose2_cont& goal : goals_) {
+        if (arrow_area.contains(goal.x, goal.y)) {
+            renderer_->add_arrow(goal, 1.0f, 0.0f, 0.0f);
         }
     }
-
-    glColor3f(0.0f, 0.0f, 0.0f);
-    glVertex2d(0, min_.y);
-    glVertex2d(0, max_.y);
-    glVertex2d(min_.x, 0);
-    glVertex2d(max_.x, 0);
-    glEnd();
+    renderer_->end_scene();
+    scene_dirty_ = false;
 }
 
 void GLWidget::draw_selection()
 {
-    if (selection_.start_selected) {
-        draw_arrow_wireframe(start_.x, start_.y, start_.yaw, 0.0, 0.0, 1.0);
+    if (outlines_dirty_) {
+        upload_outlines();
     }
-    else if (selection_.goal_selected) {
-        draw_arrow_wireframe(selection_.selected_goal->x, selection_.selected_goal->y, selection_.selected_goal->yaw, 0.0, 0.0, 1.0);
+    renderer_->draw_outlines();
+
+    if (rubber_band_) {
+        glColor3f(0.0f, 0.0f, 1.0f);
+        glBegin(GL_LINE_LOOP);
+        glVertex2d(rubber_band_start_.x(), rubber_band_start_.y());
+        glVertex2d(rubber_band_end_.x(), rubber_band_start_.y());
+        glVertex2d(rubber_band_end_.x(), rubber_band_end_.y());
+        glVertex2d(rubber_band_start_.x(), rubber_band_end_.y());
+        glEnd();
     }
 }
 
-void GLWidget::draw_guidelines()
+void GLWidget::end_stage(FrameStage stage)
 {
-    glColor3f(0.0f, 0.0f, 1.0f);
-
-    if (left_button_down_ || right_button_down_) {
-        if (selection_.start_selected) {
-            Pose2_cont disc_start = discretize(start_);
-            draw_arrow_wireframe(disc_start.x, disc_start.y, disc_start.yaw, 0.5, 0.5, 1.0, 1.5);
-        }
-        if (selection_.goal_selected) {
-            Pose2_cont disc_goal = discretize(*selection_.selected_goal);
-            draw_arrow_wireframe(disc_goal.x, disc_goal.y, disc_goal.yaw, 0.5, 0.5, 1.0, 1.5);
-        }
+    if (stats_overlay_) {
+        glFinish();
     }
+    stats_recorder_.end_stage(stage);
 }
 
-void GLWidget::draw_arrow(double x, double y, double yaw, double r, double g, double b, double scale)
+void GLWidget::draw_stats()
 {
+    const FrameStats& stats = frame_stats_;
+    const int num_lines = NUM_FRAME_STAGES + 6;
+    const int left = STATS_MARGIN;
+    const int top = STATS_MARGIN;
+    const int bar_top = top + STATS_MARGIN + num_lines * STATS_LINE_HEIGHT;
+    const int bar_height = STATS_LINE_HEIGHT;
+    const int bottom = bar_top + bar_height + STATS_MARGIN;
+
+    // draw in pixels from the top left corner
+    glMatrixMode(GL_PROJECTION);
     glPushMatrix();
-    glColor3f(r, g, b);
     glLoadIdentity();
-    glTranslated(x, y, 0);
-    glRotated(yaw * 180.0 / M_PI, 0.0, 0.0, 1.0);
-    glScaled(scale, scale, scale);
-    glBegin(GL_TRIANGLES);
-    glVertex2d(-0.5, 0.15);
-    glVertex2d(-0.5, -0.15);
-    glVertex2d(0.666 - 0.5, -0.15);
-
-    glVertex2d(0.666 - 0.5, -0.15);
-    glVertex2d(0.666 - 0.5, 0.15);
-    glVertex2d(-0.5, 0.15);
-
-    glVertex2d(0.666 - 0.5, 0.3);
-    glVertex2d(0.666 - 0.5, -0.3);
-    glVertex2d(0.5, 0.0);
-    glEnd();
-    glPopMatrix();
-}
-
-void GLWidget::draw_arrow_wireframe(double x, double y, double yaw, double r, double g, double b, double scale)
-{
+    gluOrtho2D(0.0, width(), height(), 0.0);
+    glMatrixMode(GL_MODELVIEW);
     glPushMatrix();
-    glColor3f(r, g, b);
     glLoadIdentity();
-    glTranslated(x, y, 0);
-    glRotated(yaw * 180.0 / M_PI, 0.0, 0.0, 1.0);
-    glScaled(scale, scale, scale);
-    glBegin(GL_LINE_LOOP);
-    glVertex2d(-0.5, 0.15);
-    glVertex2d(-0.5, -0.15);
-    glVertex2d(0.666 - 0.5, -0.15);
-    glVertex2d(0.666 - 0.5, -0.3);
-    glVertex2d(0.5, 0.0);
-    glVertex2d(0.666 - 0.5, 0.3);
-    glVertex2d(0.666 - 0.5, 0.15);
-    glVertex2d(-0.5, 0.15);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBegin(GL_QUADS);
+    glColor4f(1.0f, 1.0f, 1.0f, 0.85f);
+    glVertex2i(left, top);
+    glVertex2i(left + STATS_WIDTH, top);
+    glVertex2i(left + STATS_WIDTH, bottom);
+    glVertex2i(left, bottom);
+
+    // a swatch beside each stage's line, and the stages side by side in a
+    // bar that is full at STATS_BAR_MS
+    const int bar_left = left + STATS_MARGIN;
+    const double bar_scale = (STATS_WIDTH - 2 * STATS_MARGIN) / STATS_BAR_MS;
+    double bar_x = bar_left;
+    for (int s = 0; s < NUM_FRAME_STAGES; ++s) {
+        glColor3fv(STATS_STAGE_COLORS[s]);
+        const int y = top + STATS_MARGIN + (s + 1) * STATS_LINE_HEIGHT + 3;
+        glVertex2i(bar_left, y);
+        glVertex2i(bar_left + 8, y);
+        glVertex2i(bar_left + 8, y + 8);
+        glVertex2i(bar_left, y + 8);
+
+        const double end_x = std::min(bar_x + bar_scale * stats.stage_ms[s], (double)(left + STATS_WIDTH - STATS_MARGIN));
+        glVertex2d(bar_x, bar_top);
+        glVertex2d(end_x, bar_top);
+        glVertex2d(end_x, bar_top + bar_height);
+        glVertex2d(bar_x, bar_top + bar_height);
+        bar_x = end_x;
+    }
     glEnd();
+    glDisable(GL_BLEND);
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
     glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+
+    // renderText places the baseline at y
+    char line[128];
+    int y = top + STATS_MARGIN + STATS_LINE_HEIGHT - 3;
+    glColor3f(0.0f, 0.0f, 0.0f);
+    snprintf(line, sizeof(line), "frame %.2f ms, max %.2f ms over %zu",
+            stats.frame_ms, stats.max_frame_ms, stats.num_frames);
+    renderText(left + STATS_MARGIN, y, QString(line));
+    for (int s = 0; s < NUM_FRAME_STAGES; ++s) {
+        y += STATS_LINE_HEIGHT;
+        snprintf(line, sizeof(line), "%-8s %.2f ms", frame_stage_name((FrameStage)s), stats.stage_ms[s]);
+        renderText(left + 2 * STATS_MARGIN + 8, y, QString(line));
+    }
+    y += STATS_LINE_HEIGHT;
+    snprintf(line, sizeof(line), "generation %.2f ms, %zu generated (worker)", stats.generation_ms, stats.num_generated);
+    renderText(left + STATS_MARGIN, y, QString(line));
+    y += STATS_LINE_HEIGHT;
+    snprintf(line, sizeof(line), "input latency %.2f ms, max %.2f ms", stats.latency_ms, stats.max_latency_ms);
+    renderText(left + STATS_MARGIN, y, QString(line));
+    y += STATS_LINE_HEIGHT;
+    snprintf(line, sizeof(line), "motion latency %.2f ms", stats.motion_latency_ms);
+    renderText(left + STATS_MARGIN, y, QString(line));
+    y += STATS_LINE_HEIGHT;
+    snprintf(line, sizeof(line), "%zu goals, %zu primitives, %zu poses", stats.num_goals, stats.num_primitives, stats.num_poses);
+    renderText(left + STATS_MARGIN, y, QString(line));
+    y += STATS_LINE_HEIGHT;
+    snprintf(line, sizeof(line), "%zu vertices, %zu arrows drawn", stats.num_vertices, stats.num_arrows);
+    renderText(left + STATS_MARGIN, y, QString(line));
 }
 
-void GLWidget::draw_line(const std::vector<Pose2_cont>& motion)
+void GLWidget::upload_outlines()
 {
-    glColor3f(1.0f, 0.0f, 1.0f);
-    glBegin(GL_LINE_STRIP);
-    for (const Pose2_cont& pose : motion) {
-        glVertex2d(pose.x, pose.y);
+    // the selected poses and, while they are dragged in discrete mode, the
+    // discrete poses they will snap to. A box selection can hold thousands
+    // of goals, so only those around the view are outlined.
+    const Bounds2 area = scene_area_.inflated(GUIDELINE_SCALE * ARROW_RADIUS);
+    const bool guidelines = disc_mode_ && (left_button_down_ || right_button_down_);
+    renderer_->begin_outlines();
+    if (selection_.start_selected) {
+        if (guidelines) {
+            renderer_->add_outline(discretize(start_), 0.5f, 0.5f, 1.0f, GUIDELINE_SCALE);
+        }
+        renderer_->add_outline(start_, 0.0f, 0.0f, 1.0f);
     }
-    glEnd();
+    else if (selection_.goal_selected) {
+        // the guidelines first, so that the selection draws over them
+        for (int pass = guidelines ? 0 : 1; pass < 2; ++pass) {
+            for (GoalHandle goal : selection_.goals) {
+                const Pose2_cont pose = goals_.pose(goal);
+                if (!area.contains(pose.x, pose.y)) {
+                    continue;
+                }
+                if (pass == 0) {
+                    renderer_->add_outline(discretize(pose), 0.5f, 0.5f, 1.0f, GUIDELINE_SCALE);
+                }
+                else {
+                    renderer_->add_outline(pose, 0.0f, 0.0f, 1.0f);
+                }
+            }
+        }
+    }
+    renderer_->end_outlines();
+    outlines_dirty_ = false;
 }
 
 double GLWidget::realize_angle(int index, int num_angles)
 {
-    return index * (2.0 * M_PI) / num_angles;
+    return DiscreteHeading(index, num_angles).angle();
 }
 
 int GLWidget::discretize_angle(double angle, int num_angles) const
 {
-    double thetaBinSize = 2.0 * M_PI / num_angles;
-    return (int)(normalize_angle(angle + thetaBinSize / 2.0) / (2.0 * M_PI) * (num_angles));
+    return DiscreteHeading::from_angle(angle, num_angles).index();
 }
 
 double GLWidget::normalize_angle(double angle) const
 {
-    // get to the range from -2PI, 2PI
-    if (fabs(angle) > 2 * M_PI) {
-        angle = angle - ((int)(angle / (2 * M_PI))) * 2 * M_PI;
-    }
-
-    // get to the range 0, 2PI
-    if (angle < 0) {
-        angle += 2 * M_PI;
-    }
-
-    return angle;
-}
-
-bool GLWidget::same_side(const Eigen::Vector3d& p1, const Eigen::Vector3d& p2, const Eigen::Vector3d& a, const Eigen::Vector3d& b) const
-{
-    Eigen::Vector3d cp1 = (b - a).cross(p1 - a);
-    Eigen::Vector3d cp2 = (b - a).cross(p2 - a);
-    return (cp1.dot(cp2) >= 0) ;
-}
-
-bool GLWidget::point_in_triangle(const Eigen::Vector3d& p, const Eigen::Vector3d& a, const Eigen::Vector3d& b, const Eigen::Vector3d& c) const
-{
-    return same_side(p, a, b, c) && same_side(p, b, a, c) && same_side(p, c, a, b);
+    return ::normalize_angle(angle);
 }
 
 Pose2_cont GLWidget::discretize(const Pose2_cont& pose)
 {
     double disc_x = std::round(pose.x);
     double disc_y = std::round(pose.y);
-    double disc_angle = realize_angle(discretize_angle(pose.yaw, num_angles_), num_angles_);
+    double disc_angle = DiscreteHeading::from_angle(pose.yaw, num_angles_).angle();
 
     return Pose2_cont(disc_x, disc_y, disc_angle);
 }
@@ -505,24 +930,103 @@ void GLWidget::clear_selection()
 {
     selection_.start_selected = false;
     selection_.goal_selected = false;
-    selection_.selected_goal = goals_.end();
+    selection_.selected_goal = GoalHandle();
+    selection_.goals.clear();
+    outlines_dirty_ = true;
 }
 
 void GLWidget::select_at(const QPointF& point)
 {
     if (hits_start(point)) {
-        DEBUG_PRINT("Selected the start");
+        // the start is edited on its own
+        LOG_DEBUG("Selected the start");
+        clear_selection();
         selection_.start_selected = true;
+        outlines_dirty_ = true;
+        return;
     }
-    else {
-        int idx = 0;
-        for (std::list<Pose2_cont>::iterator i = goals_.begin(); i != goals_.end(); ++i) {
-            if (hits_goal(i, point)) {
-                DEBUG_PRINT("Selected goal %d", idx);
-                selection_.goal_selected = true;
-                selection_.selected_goal = i;
-            }
-            ++idx;
+
+    GoalHandle goal = pick_goal(point);
+    if (!goal.null()) {
+        LOG_DEBUG("Selected goal %u", goal.slot);
+        select_goal(goal);
+    }
+}
+
+GoalHandle GLWidget::pick_goal(const QPointF& point)
+{
+    query_ids_.clear();
+    goal_index_.query(point.x(), point.y(), query_ids_);
+
+    GoalHandle picked;
+    double picked_dist_sq = 0.0;
+    for (uint32_t slot : query_ids_) {
+        const GoalHandle goal = goals_.slot_handle(slot);
+        const Pose2_cont pose = goals_.pose(goal);
+        if (!hits_arrow(pose, point)) {
+            continue;
+        }
+        const double dx = pose.x - point.x();
+        const double dy = pose.y - point.y();
+        const double dist_sq = dx * dx + dy * dy;
+        if (picked.null() || dist_sq < picked_dist_sq) {
+            picked = goal;
+            picked_dist_sq = dist_sq;
+        }
+    }
+    return picked;
+}
+
+void GLWidget::select_goal(GoalHandle goal)
+{
+    selection_.start_selected = false;
+    if (!is_selected(goal)) {
+        selection_.goals.push_back(goal);
+    }
+    selection_.goal_selected = true;
+    selection_.selected_goal = goal;
+    outlines_dirty_ = true;
+}
+
+bool GLWidget::is_selected(GoalHandle goal) const
+{
+    return std::find(selection_.goals.begin(), selection_.goals.end(), goal) != selection_.goals.end();
+}
+
+void GLWidget::select_in_box(const QPointF& a, const QPointF& b)
+{
+    const Bounds2 box(
+            std::min(a.x(), b.x()), std::min(a.y(), b.y()),
+            std::max(a.x(), b.x()), std::max(a.y(), b.y()));
+
+    query_ids_.clear();
+    goal_index_.query(box, query_ids_);
+
+    // mark the goals already selected rather than searching the selection
+    // for each of possibly thousands of new ones
+    std::vector<uint8_t> selected(goals_.num_slots(), 0);
+    for (GoalHandle goal : selection_.goals) {
+        selected[goal.slot] = 1;
+    }
+
+    std::size_t num_added = 0;
+    for (uint32_t slot : query_ids_) {
+        const GoalHandle goal = goals_.slot_handle(slot);
+        const Pose2_cont pose = goals_.pose(goal);
+        if (selected[slot] || !box.contains(pose.x, pose.y)) {
+            continue;
+        }
+        selection_.goals.push_back(goal);
+        ++num_added;
+    }
+
+    if (!selection_.goals.empty()) {
+        selection_.start_selected = false;
+        selection_.goal_selected = true;
+        if (selection_.selected_goal.null()) {
+            selection_.selected_goal = selection_.goals.front();
         }
     }
+    outlines_dirty_ = true;
+    LOG_DEBUG("Box selected %zu goals", num_added);
 }
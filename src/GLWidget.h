@@ -1,11 +1,20 @@
 #ifndef GLWidget_h
 #define GLWidget_h
 
-#include <list>
+#include <chrono>
+#include <memory>
 #include <vector>
-#include <Eigen/Dense>
 #include <QtOpenGL>
+#include "frame_stats.h"
+#include "goal_set.h"
+#include "motion_generator.h"
+#include "motion_worker.h"
 #include "Pose2.h"
+#include "reachability.h"
+#include "spatial_index.h"
+#include "work_stealing_pool.h"
+
+class PrimitiveRenderer;
 
 class GLWidget : public QGLWidget
 {
@@ -16,6 +25,7 @@ public:
     GLWidget(QWidget* parent = 0);
     GLWidget(QGLContext* context, QWidget* parent = 0, const QGLWidget* shareWidget = 0, Qt::WindowFlags f = 0);
     GLWidget(const QGLFormat& format, QWidget* parent = 0, const QGLWidget* shareWidget = 0, Qt::WindowFlags f = 0);
+    ~GLWidget();
 
     QSize sizeHint() const { return QSize(800, 800); }
 
@@ -31,15 +41,27 @@ public:
     void mousePressEvent(QMouseEvent *event);
     void mouseMoveEvent(QMouseEvent *event);
     void mouseReleaseEvent(QMouseEvent *event);
+    void wheelEvent(QWheelEvent *event);
+
+    const Pose2_cont& start() const { return start_; }
+    const GoalSet& goals() const { return goals_; }
+    int num_angles() const { return num_angles_; }
+
+    /// The curve generator that connects the start to every goal
+    const MotionGenerator& generator() const { return *generator_; }
+
+    /// Where recent repaints spent their time; updated after every repaint
+    /// and announced by stats_changed() a few times a second at most
+    const FrameStats& frame_stats() const { return frame_stats_; }
 
     int start_x() const { return (int)start_.x; }
     int start_y() const { return (int)start_.y; }
     int start_yaw() const { return discretize_angle(start_.yaw, num_angles_); }
 
     bool goal_selected() const { return selection_.goal_selected; }
-    int goal_x() const { return (int)selection_.selected_goal->x; }
-    int goal_y() const { return (int)selection_.selected_goal->y; }
-    int goal_yaw() const { return discretize_angle(selection_.selected_goal->yaw, num_angles_); }
+    int goal_x() const { return (int)goals_.pose(selection_.selected_goal).x; }
+    int goal_y() const { return (int)goals_.pose(selection_.selected_goal).y; }
+    int goal_yaw() const { return discretize_angle(goals_.pose(selection_.selected_goal).yaw, num_angles_); }
 
 public slots:
 
@@ -53,10 +75,16 @@ public slots:
     void set_disc_goal_angle(int);
     void set_disc_goal_x(int);
     void set_disc_goal_y(int);
+    void set_generator(const QString& name);
+    void set_turning_radius(double radius);
+    void set_coverage_overlay(bool enabled);
+    void set_coverage_steps(int steps);
+    void set_stats_overlay(bool enabled);
 
 signals:
 
     void gui_changed();
+    void stats_changed();
 
 private:
 
@@ -64,6 +92,7 @@ private:
 
     bool left_button_down_;
     bool right_button_down_;
+    bool middle_button_down_;
 
     QPointF start_tail_;
     QPointF goal_tail_;
@@ -74,8 +103,64 @@ private:
     Pose2_disc min_;
     Pose2_disc max_;
 
+    /// The camera: the world point at the center of the widget and the
+    /// world distance covered by one pixel; 0 until the first resize
+    QPointF view_center_;
+    double view_scale_;
+    QPoint pan_last_pos_;
+
     Pose2_cont start_;
-    std::list<Pose2_cont> goals_;
+    GoalSet goals_;
+
+    /// The goal arrows by slot, for picking and box selection
+    SpatialIndex goal_index_;
+    std::vector<uint32_t> query_ids_;
+
+    std::unique_ptr<MotionGenerator> generator_;
+    MotionGeneratorParams generator_params_;
+
+    /// Motions are generated off the GUI thread. Edits mark them dirty and
+    /// the next repaint submits a request, superseding any still running;
+    /// until its result arrives the last completed one is drawn.
+    MotionWorker motion_worker_;
+    MotionRequest motion_request_;
+    MotionSet motions_;
+    bool motions_dirty_;
+    std::vector<Pose2_cont> stale_goals_;   ///< poses of goals moved or removed since the last request
+
+    /// The grid, motions and arrows in vertex buffers, culled to the area
+    /// around the view and uploaded again only when that area or the scene
+    /// changes
+    std::unique_ptr<PrimitiveRenderer> renderer_;
+    bool scene_dirty_;
+
+    /// The selection's outlines are uploaded again only when the selection,
+    /// the selected poses or the scene area change, so a large selection
+    /// costs one draw call on other repaints
+    bool outlines_dirty_;
+
+    /// The area and scale the uploaded scene was culled and decimated for.
+    /// The scene covers more than the view so that panning a little or
+    /// zooming a little does not upload it again.
+    Bounds2 scene_area_;
+    double scene_scale_;
+
+    /// States reachable from the start by chaining the designed primitives,
+    /// carried to every heading in the start heading's orbit by lattice symmetry
+    bool coverage_overlay_;
+    int coverage_steps_;
+    bool coverage_dirty_;
+    ReachabilityResult coverage_;
+    std::vector<float> coverage_cells_;    ///< x, y, r, g, b, a per cell, for the renderer
+    std::unique_ptr<WorkStealingPool> coverage_pool_;
+
+    /// Repaint timing. While the overlay is shown each stage waits for the
+    /// GPU to finish so that its time includes the drawing; otherwise the
+    /// stages are charged only for issuing their commands.
+    FrameStatsRecorder stats_recorder_;
+    FrameStats frame_stats_;
+    bool stats_overlay_;
+    std::chrono::steady_clock::time_point stats_reported_;
 
     QPointF left_button_down_pos_;
     QPointF right_button_down_pos_;
@@ -84,38 +169,71 @@ private:
     {
         bool start_selected;
         bool goal_selected;
-        std::list<Pose2_cont>::iterator selected_goal;
+        GoalHandle selected_goal;       ///< the goal the controls edit
+        std::vector<GoalHandle> goals;  ///< every selected goal, selected_goal among them
     } selection_;
 
+    /// The box being dragged out to select goals, in world coordinates
+    bool rubber_band_;
+    QPointF rubber_band_start_;
+    QPointF rubber_band_end_;
+
     int num_angles_;
 
     void construct();
 
+    void replace_generator(const std::string& name);
+
+    void move_start(const Pose2_cont& pose);
+    void move_goal(GoalHandle goal, const Pose2_cont& pose);
+
+    GoalHandle add_goal(const Pose2_cont& pose);
+    void remove_goal(GoalHandle goal);
+
+    /// Return the goal whose arrow covers $point, the one whose pose is
+    /// nearest when several do, or the null handle if there is none
+    GoalHandle pick_goal(const QPointF& point);
+
     bool hits_start(const QPointF& point) const;
-    bool hits_goal(std::list<Pose2_cont>::iterator goal_idx, const QPointF& point) const;
     bool hits_arrow(const Pose2_cont& pose, const QPointF& point) const;
 
     QPointF viewport_to_world(const QPointF& viewport_coord) const;
 
-    void draw_grid();
-    void draw_guidelines();
+    /// Return the world area visible in the widget
+    Bounds2 view_bounds() const;
+    void fit_view(const Bounds2& area);
+    void zoom_view(double factor, const QPointF& viewport_coord);
+    void apply_view();
+
+    void request_motions();
+    void update_coverage();
+
+    void upload_scene(const Bounds2& view);
+
+    /// Charge the time since the last stage ended to $stage
+    void end_stage(FrameStage stage);
+
+    void draw_coverage();
     void draw_selection();
-    void draw_arrow(double x, double y, double yaw, double r, double g, double b, double scale = 1.0);
-    void draw_arrow_wireframe(double x, double y, double yaw, double r, double g, double b, double scale = 1.0);
-    void draw_line(const std::vector<Pose2_cont>& motion);
+    void draw_stats();
+
+    /// Rebuild the outlines of the selection
+    void upload_outlines();
 
     double realize_angle(int disc_angle, int num_angles);
 
     double normalize_angle(double angle) const;
     int discretize_angle(double angle, int num_angles) const;
 
-    bool same_side(const Eigen::Vector3d& p1, const Eigen::Vector3d& p2, const Eigen::Vector3d& a, const Eigen::Vector3d& b) const;
-    bool point_in_triangle(const Eigen::Vector3d& p, const Eigen::Vector3d& a, const Eigen::Vector3d& b, const Eigen::Vector3d& c) const;
-
     Pose2_cont discretize(const Pose2_cont& pose);
 
     void clear_selection();
     void select_at(const QPointF& point);
+    void select_goal(GoalHandle goal);
+    bool is_selected(GoalHandle goal) const;
+
+    /// Add every goal whose pose lies in the box between $a and $b to the selection
+    void select_in_box(const QPointF& a, const QPointF& b);
 };
 
 #endif
@@ -0,0 +1,186 @@
+#include "MotionCache.h"
+#include <functional>
+#include <utility>
+#include "motion_generator.h"
+#include "unicycle_motions.h"
+
+static const std::size_t MIN_CAPACITY = 64;
+
+static inline void hash_combine(std::size_t& seed, double value)
+{
+    seed ^= std::hash<double>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+MotionCache::MotionCache() :
+    slots_(MIN_CAPACITY),
+    size_(0),
+    num_used_(0),
+    num_generated_(0),
+    resolution_(0.0),
+    generator_(0)
+{
+}
+
+std::size_t MotionCache::hash(const Pose2_cont& start, const Pose2_cont& goal)
+{
+    std::size_t seed = 0;
+    hash_combine(seed, start.x);
+    hash_combine(seed, start.y);
+    hash_combine(seed, start.yaw);
+    hash_combine(seed, goal.x);
+    hash_combine(seed, goal.y);
+    hash_combine(seed, goal.yaw);
+    return seed;
+}
+
+std::size_t MotionCache::find(const Pose2_cont& start, const Pose2_cont& goal) const
+{
+    // capacity is a power of two and at least one slot is always EMPTY
+    const std::size_t mask = slots_.size() - 1;
+    for (std::size_t i = hash(start, goal) & mask; ; i = (i + 1) & mask) {
+        const Slot& slot = slots_[i];
+        if (slot.state == EMPTY) {
+            return slots_.size();
+        }
+        if (slot.state == FULL && slot.start == start && slot.goal == goal) {
+            return i;
+        }
+    }
+}
+
+const MotionCache::Motion& MotionCache::motion(const Pose2_cont& start, const Pose2_cont& goal)
+{
+    return slots_[lookup(start, goal)].motion;
+}
+
+const Bounds2& MotionCache::bounds(const Pose2_cont& start, const Pose2_cont& goal)
+{
+    return slots_[lookup(start, goal)].bounds;
+}
+
+std::size_t MotionCache::lookup(const Pose2_cont& start, const Pose2_cont& goal)
+{
+    std::size_t found = find(start, goal);
+    if (found != slots_.size()) {
+        return found;
+    }
+
+    const std::size_t i = insert(start, goal);
+    Slot& slot = slots_[i];
+    if (generator_) {
+        generator_->generate(start, goal, slot.motion, resolution_);
+    }
+    else {
+        generate_unicycle_motion(start, goal, slot.motion, resolution_);
+    }
+    compute_bounds(slot);
+    ++num_generated_;
+    return i;
+}
+
+std::size_t MotionCache::insert(const Pose2_cont& start, const Pose2_cont& goal)
+{
+    // keep the load, tombstones included, at or below 1/2
+    if (2 * (num_used_ + 1) > slots_.size()) {
+        rehash(4 * (size_ + 1) > slots_.size() ? 2 * slots_.size() : slots_.size());
+    }
+
+    const std::size_t mask = slots_.size() - 1;
+    std::size_t i = hash(start, goal) & mask;
+    while (slots_[i].state == FULL) {
+        i = (i + 1) & mask;
+    }
+
+    Slot& slot = slots_[i];
+    if (slot.state == EMPTY) {
+        ++num_used_;
+    }
+    slot.start = start;
+    slot.goal = goal;
+    slot.state = FULL;
+    ++size_;
+    return i;
+}
+
+void MotionCache::compute_bounds(Slot& slot)
+{
+    slot.bounds = Bounds2();
+    for (const Pose2_cont& pose : slot.motion) {
+        slot.bounds.add(pose.x, pose.y);
+    }
+}
+
+void MotionCache::store(const Pose2_cont& start, const Pose2_cont& goal, Motion& motion)
+{
+    std::size_t i = find(start, goal);
+    if (i == slots_.size()) {
+        i = insert(start, goal);
+    }
+    Slot& slot = slots_[i];
+    slot.motion.swap(motion);
+    compute_bounds(slot);
+}
+
+void MotionCache::invalidate(const Pose2_cont& start, const Pose2_cont& goal)
+{
+    std::size_t found = find(start, goal);
+    if (found != slots_.size()) {
+        // the slot keeps its pose storage for whichever motion lands here next
+        slots_[found].state = DELETED;
+        --size_;
+    }
+}
+
+void MotionCache::clear()
+{
+    for (Slot& slot : slots_) {
+        slot.state = EMPTY;
+    }
+    size_ = 0;
+    num_used_ = 0;
+}
+
+void MotionCache::set_generator(const MotionGenerator* generator)
+{
+    if (generator != generator_) {
+        generator_ = generator;
+        clear();
+    }
+}
+
+void MotionCache::set_resolution(double resolution)
+{
+    if (resolution != resolution_) {
+        resolution_ = resolution;
+        clear();
+    }
+}
+
+void MotionCache::rehash(std::size_t capacity)
+{
+    // reuse the previous table's storage when the capacity is unchanged
+    spare_slots_.resize(capacity);
+    for (Slot& slot : spare_slots_) {
+        slot.state = EMPTY;
+    }
+
+    const std::size_t mask = capacity - 1;
+    for (Slot& slot : slots_) {
+        if (slot.state != FULL) {
+            continue;
+        }
+        std::size_t i = hash(slot.start, slot.goal) & mask;
+        while (spare_slots_[i].state == FULL) {
+            i = (i + 1) & mask;
+        }
+        Slot& dst = spare_slots_[i];
+        dst.start = slot.start;
+        dst.goal = slot.goal;
+        dst.state = FULL;
+        dst.motion.swap(slot.motion);
+        dst.bounds = slot.bounds;
+    }
+
+    slots_.swap(spare_slots_);
+    num_used_ = size_;
+}
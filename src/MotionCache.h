@@ -0,0 +1,114 @@
+#ifndef MotionCache_h
+#define MotionCache_h
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+#include "Pose2.h"
+
+class MotionGenerator;
+
+/// Memoizes unicycle motions keyed on their (start, goal) pose pair. Entries
+/// are only ever dropped explicitly, so callers must invalidate a pair before
+/// mutating either of its poses.
+///
+/// The cache is an open-addressed table whose slots keep their pose storage
+/// when invalidated, so that regenerating a motion reuses the capacity of
+/// some earlier one. Once the table has grown to fit the working set,
+/// invalidating and regenerating motions does not allocate.
+class MotionCache
+{
+public:
+
+    typedef std::vector<Pose2_cont> Motion;
+
+    MotionCache();
+
+    /// Return the motion from $start to $goal, generating it on a cache miss.
+    /// The reference is valid until the next call that misses.
+    const Motion& motion(const Pose2_cont& start, const Pose2_cont& goal);
+
+    /// Return the bounds of the poses on the motion from $start to $goal,
+    /// generating it on a cache miss; empty if there is no such motion
+    const Bounds2& bounds(const Pose2_cont& start, const Pose2_cont& goal);
+
+    /// Generate the motions from $start to every goal in [$first, $last) that are not cached yet
+    template <typename GoalIt>
+    void update(const Pose2_cont& start, GoalIt first, GoalIt last);
+
+    /// Return whether the motion from $start to $goal is cached
+    bool contains(const Pose2_cont& start, const Pose2_cont& goal) const { return find(start, goal) != slots_.size(); }
+
+    /// Cache $motion as the motion from $start to $goal, generated elsewhere,
+    /// and leave the storage of some earlier motion in $motion for reuse
+    void store(const Pose2_cont& start, const Pose2_cont& goal, Motion& motion);
+
+    /// Drop the cached motion from $start to $goal, if any
+    void invalidate(const Pose2_cont& start, const Pose2_cont& goal);
+
+    /// Drop every cached motion
+    void clear();
+
+    /// Generate motions with $generator, which must outlive the cache, or with
+    /// the unicycle model if it is null. Changing it drops every cached motion.
+    void set_generator(const MotionGenerator* generator);
+    const MotionGenerator* generator() const { return generator_; }
+
+    /// Sample motions at most $resolution cells apart, or at the default
+    /// density if it is 0. Changing it drops every cached motion.
+    void set_resolution(double resolution);
+    double resolution() const { return resolution_; }
+
+    std::size_t size() const { return size_; }
+
+    /// Number of motions generated since construction
+    std::size_t num_generated() const { return num_generated_; }
+
+private:
+
+    enum SlotState { EMPTY = 0, FULL, DELETED };
+
+    struct Slot
+    {
+        Slot() : state(EMPTY) { }
+        Pose2_cont start;
+        Pose2_cont goal;
+        Motion motion;
+        Bounds2 bounds;
+        uint8_t state;
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<Slot> spare_slots_;
+    std::size_t size_;
+    std::size_t num_used_;  ///< FULL or DELETED slots
+    std::size_t num_generated_;
+    double resolution_;
+    const MotionGenerator* generator_;
+
+    static std::size_t hash(const Pose2_cont& start, const Pose2_cont& goal);
+
+    /// Return the slot holding the key, or slots_.size() if there is none
+    std::size_t find(const Pose2_cont& start, const Pose2_cont& goal) const;
+
+    /// Return the slot holding the motion from $start to $goal, generating it on a miss
+    std::size_t lookup(const Pose2_cont& start, const Pose2_cont& goal);
+
+    /// Claim a slot for the key, which must not be cached, leaving its motion to be filled
+    std::size_t insert(const Pose2_cont& start, const Pose2_cont& goal);
+
+    static void compute_bounds(Slot& slot);
+
+    /// Rebuild the table with $capacity slots, dropping tombstones
+    void rehash(std::size_t capacity);
+};
+
+template <typename GoalIt>
+void MotionCache::update(const Pose2_cont& start, GoalIt first, GoalIt last)
+{
+    for (GoalIt it = first; it != last; ++it) {
+        motion(start, *it);
+    }
+}
+
+#endif
@@ -2,7 +2,12 @@
 #include <cstdio>
 #include "GLWidget.h"
 #include "DiscreteAnglesSpinBox.h"
+#include "footprint.h"
 #include "logging.h"
+#include "motion_generator.h"
+#include "primitive_export.h"
+#include "reachability.h"
+#include "work_stealing_pool.h"
 
 MotionPrimitiveDesignerWindow::MotionPrimitiveDesignerWindow(QWidget* parent, Qt::WindowFlags flags) :
     QMainWindow(parent, flags)
@@ -24,6 +29,13 @@ MotionPrimitiveDesignerWindow::MotionPrimitiveDesignerWindow(QWidget* parent, Qt
     discrete_mode_toggle_button_ = new QPushButton(tr("Toggle Discrete Mode"));
     add_goal_button_ = new QPushButton(tr("Add Goal"));
     remove_goal_button_ = new QPushButton(tr("Remove Goal"));
+    export_button_ = new QPushButton(tr("Export Primitives..."));
+    generator_combobox_ = new QComboBox;
+    turning_radius_spinbox_ = new QDoubleSpinBox;
+    coverage_checkbox_ = new QCheckBox(tr("Show Coverage"));
+    coverage_steps_spinbox_ = new QSpinBox;
+    stats_checkbox_ = new QCheckBox(tr("Show Stats"));
+    stats_label_ = new QLabel;
     num_disc_angles_spinbox_ = new DiscreteAnglesSpinBox;
     start_disc_angle_spinbox_ = new QSpinBox;
     start_disc_x_spinbox_ = new QSpinBox;
@@ -35,6 +47,26 @@ MotionPrimitiveDesignerWindow::MotionPrimitiveDesignerWindow(QWidget* parent, Qt
     control_panel_layout->addWidget(discrete_mode_toggle_button_, Qt::AlignTop);
     control_panel_layout->addWidget(add_goal_button_);
     control_panel_layout->addWidget(remove_goal_button_);
+    control_panel_layout->addWidget(export_button_);
+
+    QHBoxLayout* generator_layout = new QHBoxLayout;
+    generator_layout->addWidget(new QLabel(tr("Generator")));
+    generator_layout->addWidget(generator_combobox_);
+    control_panel_layout->addLayout(generator_layout);
+
+    QHBoxLayout* turning_radius_layout = new QHBoxLayout;
+    turning_radius_layout->addWidget(new QLabel(tr("Turning Radius")));
+    turning_radius_layout->addWidget(turning_radius_spinbox_);
+    control_panel_layout->addLayout(turning_radius_layout);
+
+    control_panel_layout->addWidget(coverage_checkbox_);
+
+    QHBoxLayout* coverage_steps_layout = new QHBoxLayout;
+    coverage_steps_layout->addWidget(new QLabel(tr("Coverage Steps")));
+    coverage_steps_layout->addWidget(coverage_steps_spinbox_);
+    control_panel_layout->addLayout(coverage_steps_layout);
+
+    control_panel_layout->addWidget(stats_checkbox_);
 
     QHBoxLayout* num_angles_layout = new QHBoxLayout;
     num_angles_layout->addWidget(new QLabel(tr("Num Angles")));
@@ -76,14 +108,23 @@ MotionPrimitiveDesignerWindow::MotionPrimitiveDesignerWindow(QWidget* parent, Qt
     control_panel_widget->setLayout(control_panel_layout);
 
     setCentralWidget(render_widget_);
+    statusBar()->addPermanentWidget(stats_label_);
 
     connect(discrete_mode_toggle_button_,   SIGNAL(clicked()),          this, SLOT(toggle_selection_mode()));
     connect(num_disc_angles_spinbox_,       SIGNAL(valueChanged(int)),  this, SLOT(update_num_angles(int)));
+    connect(export_button_,                 SIGNAL(clicked()),          this, SLOT(export_primitives()));
 
     connect(add_goal_button_,               SIGNAL(clicked()),          render_widget_, SLOT(add_discrete_goal()));
     connect(remove_goal_button_,            SIGNAL(clicked()),          render_widget_, SLOT(remove_discrete_goal()));
 
+    connect(generator_combobox_,            SIGNAL(currentIndexChanged(const QString&)), render_widget_, SLOT(set_generator(const QString&)));
+    connect(turning_radius_spinbox_,        SIGNAL(valueChanged(double)),               render_widget_, SLOT(set_turning_radius(double)));
+    connect(coverage_checkbox_,             SIGNAL(toggled(bool)),                      render_widget_, SLOT(set_coverage_overlay(bool)));
+    connect(coverage_steps_spinbox_,        SIGNAL(valueChanged(int)),                  render_widget_, SLOT(set_coverage_steps(int)));
+    connect(stats_checkbox_,                SIGNAL(toggled(bool)),                      render_widget_, SLOT(set_stats_overlay(bool)));
+
     connect(render_widget_, SIGNAL(gui_changed()), this, SLOT(update_gui()));
+    connect(render_widget_, SIGNAL(stats_changed()), this, SLOT(update_stats()));
 
     connect(start_disc_angle_spinbox_, SIGNAL(valueChanged(int)), render_widget_, SLOT(set_disc_start_angle(int)));
     connect(start_disc_x_spinbox_, SIGNAL(valueChanged(int)), render_widget_, SLOT(set_disc_start_x(int)));
@@ -92,6 +133,20 @@ MotionPrimitiveDesignerWindow::MotionPrimitiveDesignerWindow(QWidget* parent, Qt
     connect(goal_disc_x_spinbox_, SIGNAL(valueChanged(int)), render_widget_, SLOT(set_disc_goal_x(int)));
     connect(goal_disc_y_spinbox_, SIGNAL(valueChanged(int)), render_widget_, SLOT(set_disc_goal_y(int)));
 
+    for (const std::string& name : motion_generator_names()) {
+        generator_combobox_->addItem(QString::fromStdString(name));
+    }
+
+    turning_radius_spinbox_->setDecimals(2);
+    turning_radius_spinbox_->setMinimum(0.1);
+    turning_radius_spinbox_->setMaximum(100.0);
+    turning_radius_spinbox_->setSingleStep(0.25);
+    turning_radius_spinbox_->setValue(1.0);
+
+    coverage_steps_spinbox_->setMinimum(1);
+    coverage_steps_spinbox_->setMaximum(REACH_MAX_STEPS);
+    coverage_steps_spinbox_->setValue(3);
+
     num_disc_angles_spinbox_->setMinimum(1);
     num_disc_angles_spinbox_->setMaximum(256);
 
@@ -122,6 +177,16 @@ void MotionPrimitiveDesignerWindow::update_num_angles(int i)
     render_widget_->set_num_angles(i);
 }
 
+void MotionPrimitiveDesignerWindow::update_stats()
+{
+    // enough to tell a slow generator from slow drawing; the overlay has the rest
+    const FrameStats& stats = render_widget_->frame_stats();
+    char text[128];
+    snprintf(text, sizeof(text), "frame %.1f ms  generation %.1f ms  latency %.1f ms  %zu primitives",
+            stats.frame_ms, stats.generation_ms, stats.latency_ms, stats.num_primitives);
+    stats_label_->setText(QString(text));
+}
+
 bool MotionPrimitiveDesignerWindow::is_pow2(unsigned i)
 {
     return i != 0 && !(i & (i - 1));
@@ -132,9 +197,47 @@ void MotionPrimitiveDesignerWindow::toggle_selection_mode()
     render_widget_->toggle_disc_mode();
 }
 
+void MotionPrimitiveDesignerWindow::export_primitives()
+{
+    QString path = QFileDialog::getSaveFileName(this, tr("Export Primitives"), QString(), tr("Motion Primitives (*.mprim)"));
+    if (path.isEmpty()) {
+        return;
+    }
+
+    bool ok;
+    double resolution = QInputDialog::getDouble(this, tr("Export Primitives"), tr("Cell size (m)"), 0.025, 0.0001, 100.0, 4, &ok);
+    if (!ok) {
+        return;
+    }
+
+    const int num_angles = render_widget_->num_angles();
+    const Footprint footprint = arrow_footprint();
+
+    PrimitiveExporter exporter;
+    if (!exporter.open(path.toStdString(), resolution, num_angles, footprint)) {
+        QMessageBox::warning(this, tr("Export Primitives"), tr("Failed to open %1 for writing").arg(path));
+        return;
+    }
+
+    PrimitiveSet primitives;
+    const std::size_t num_skipped = render_widget_->generator().generate_goal_primitives(
+            render_widget_->start(), render_widget_->goals(), num_angles, primitives);
+
+    WorkStealingPool pool;
+    compute_swept_cells(primitives, footprint, pool);
+    exporter.write(primitives);
+
+    if (!exporter.close()) {
+        QMessageBox::warning(this, tr("Export Primitives"), tr("Failed to write %1").arg(path));
+    }
+    else if (num_skipped > 0) {
+        QMessageBox::information(this, tr("Export Primitives"), tr("Skipped %1 goals with no feasible motion").arg((int)num_skipped));
+    }
+}
+
 void MotionPrimitiveDesignerWindow::update_gui()
 {
-    DEBUG_PRINT("Updating the gui");
+    LOG_DEBUG("Updating the gui");
 
     discrete_mode_toggle_button_->setText(QString("Toggle %1 Mode").arg(render_widget_->discrete_mode() ? "Continuous" : "Discrete"));
 
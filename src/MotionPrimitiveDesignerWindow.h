@@ -24,6 +24,8 @@ private slots:
 
     void update_num_angles(int i);
     void toggle_selection_mode();
+    void export_primitives();
+    void update_stats();
 
 private:
 
@@ -35,6 +37,13 @@ private:
     QPushButton*    discrete_mode_toggle_button_;
     QPushButton*    add_goal_button_;
     QPushButton*    remove_goal_button_;
+    QPushButton*    export_button_;
+    QComboBox*      generator_combobox_;
+    QDoubleSpinBox* turning_radius_spinbox_;
+    QCheckBox*      coverage_checkbox_;
+    QSpinBox*       coverage_steps_spinbox_;
+    QCheckBox*      stats_checkbox_;
+    QLabel*         stats_label_;
 
     DiscreteAnglesSpinBox*  num_disc_angles_spinbox_;
     QSpinBox*               start_disc_angle_spinbox_;
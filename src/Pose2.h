@@ -1,6 +1,7 @@
 #ifndef Pose2_h
 #define Pose2_h
 
+#include <algorithm>
 #include <cmath>
 #include <sstream>
 #include <string>
@@ -13,6 +14,18 @@ struct Pose2
     StorageType x, y, yaw;
 };
 
+template <typename StorageType>
+bool operator==(const Pose2<StorageType>& lhs, const Pose2<StorageType>& rhs)
+{
+    return lhs.x == rhs.x && lhs.y == rhs.y && lhs.yaw == rhs.yaw;
+}
+
+template <typename StorageType>
+bool operator!=(const Pose2<StorageType>& lhs, const Pose2<StorageType>& rhs)
+{
+    return !(lhs == rhs);
+}
+
 template <typename StorageType>
 std::string to_string(const Pose2<StorageType>& p)
 {
@@ -24,4 +37,43 @@ std::string to_string(const Pose2<StorageType>& p)
 typedef Pose2<double> Pose2_cont;
 typedef Pose2<int> Pose2_disc;
 
+/// An axis-aligned box; the default box is empty and grows to fit the
+/// points added to it
+struct Bounds2
+{
+    Bounds2() : min_x(HUGE_VAL), min_y(HUGE_VAL), max_x(-HUGE_VAL), max_y(-HUGE_VAL) { }
+    Bounds2(double min_x, double min_y, double max_x, double max_y) :
+        min_x(min_x), min_y(min_y), max_x(max_x), max_y(max_y) { }
+
+    double min_x, min_y, max_x, max_y;
+
+    bool empty() const { return min_x > max_x || min_y > max_y; }
+
+    void add(double x, double y)
+    {
+        min_x = std::min(min_x, x);
+        min_y = std::min(min_y, y);
+        max_x = std::max(max_x, x);
+        max_y = std::max(max_y, y);
+    }
+
+    bool contains(double x, double y) const { return x >= min_x && x <= max_x && y >= min_y && y <= max_y; }
+
+    bool contains(const Bounds2& b) const
+    {
+        return b.min_x >= min_x && b.max_x <= max_x && b.min_y >= min_y && b.max_y <= max_y;
+    }
+
+    bool intersects(const Bounds2& b) const
+    {
+        return b.min_x <= max_x && b.max_x >= min_x && b.min_y <= max_y && b.max_y >= min_y;
+    }
+
+    /// Return this box grown by $margin on every side
+    Bounds2 inflated(double margin) const
+    {
+        return Bounds2(min_x - margin, min_y - margin, max_x + margin, max_y + margin);
+    }
+};
+
 #endif
@@ -0,0 +1,507 @@
+#define GL_GLEXT_PROTOTYPES
+#include "PrimitiveRenderer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <GL/glext.h>
+
+/// The arrow drawn at every pose, as triangles in the pose's frame; the
+/// same shape that arrow_contains() tests against
+static const float ARROW_MESH[] =
+{
+    -0.5f, 0.15f,
+    -0.5f, -0.15f,
+    0.666f - 0.5f, -0.15f,
+
+    0.666f - 0.5f, -0.15f,
+    0.666f - 0.5f, 0.15f,
+    -0.5f, 0.15f,
+
+    0.666f - 0.5f, 0.3f,
+    0.666f - 0.5f, -0.3f,
+    0.5f, 0.0f,
+};
+
+static const int ARROW_MESH_VERTICES = sizeof(ARROW_MESH) / sizeof(ARROW_MESH[0]) / 2;
+
+/// The boundary of ARROW_MESH, counterclockwise from the tail
+static const float ARROW_OUTLINE[] =
+{
+    -0.5f, 0.15f,
+    -0.5f, -0.15f,
+    0.666f - 0.5f, -0.15f,
+    0.666f - 0.5f, -0.3f,
+    0.5f, 0.0f,
+    0.666f - 0.5f, 0.3f,
+    0.666f - 0.5f, 0.15f,
+};
+
+static const int ARROW_OUTLINE_VERTICES = sizeof(ARROW_OUTLINE) / sizeof(ARROW_OUTLINE[0]) / 2;
+
+static const char* ARROW_VERTEX_SHADER =
+    "#version 120\n"
+    "attribute vec2 vertex;\n"
+    "attribute vec3 pose;\n"
+    "attribute vec3 color;\n"
+    "varying vec3 frag_color;\n"
+    "void main()\n"
+    "{\n"
+    "    float c = cos(pose.z);\n"
+    "    float s = sin(pose.z);\n"
+    "    vec2 p = vec2(pose.x + c * vertex.x - s * vertex.y, pose.y + s * vertex.x + c * vertex.y);\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vec4(p, 0.0, 1.0);\n"
+    "    frag_color = color;\n"
+    "}\n";
+
+static const char* ARROW_FRAGMENT_SHADER =
+    "#version 120\n"
+    "varying vec3 frag_color;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_FragColor = vec4(frag_color, 1.0);\n"
+    "}\n";
+
+enum ArrowAttribute
+{
+    ARROW_VERTEX = 0,
+    ARROW_POSE,
+    ARROW_COLOR
+};
+
+/// Return whether the space-separated $extensions include $name
+static bool has_extension(const char* extensions, const char* name)
+{
+    const std::size_t len = strlen(name);
+    for (const char* p = extensions; p && (p = strstr(p, name)); p += len) {
+        if ((p == extensions || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static GLuint compile_shader(GLenum type, const char* source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, 0);
+    glCompileShader(shader);
+
+    GLint ok = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), 0, log);
+        fprintf(stderr, "Failed to compile arrow shader: %s\n", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+PrimitiveRenderer::PrimitiveRenderer() :
+    initialized_(false),
+    instanced_(false),
+    num_grid_vertices_(0),
+    num_cell_vertices_(0),
+    arrow_program_(0)
+{
+}
+
+bool PrimitiveRenderer::initialize()
+{
+    release();
+
+    // vertex buffers are core since 1.5, shaders since 2.0
+    const char* version = (const char*)glGetString(GL_VERSION);
+    int major = 0, minor = 0;
+    if (!version || sscanf(version, "%d.%d", &major, &minor) != 2 || major * 10 + minor < 15) {
+        fprintf(stderr, "OpenGL 1.5 is required for vertex buffers (have %s)\n", version ? version : "none");
+        return false;
+    }
+
+    glGenBuffers(1, &grid_buffer_.id);
+    glGenBuffers(1, &cell_buffer_.id);
+    glGenBuffers(1, &motion_buffer_.id);
+    glGenBuffers(1, &arrow_mesh_buffer_.id);
+    glGenBuffers(1, &arrow_buffer_.id);
+    glGenBuffers(1, &outline_buffer_.id);
+    initialized_ = true;
+
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    if (major >= 2 && has_extension(extensions, "GL_ARB_instanced_arrays") && create_arrow_program()) {
+        upload(arrow_mesh_buffer_, ARROW_MESH, sizeof(ARROW_MESH), GL_STATIC_DRAW);
+        instanced_ = true;
+    }
+    return true;
+}
+
+void PrimitiveRenderer::release()
+{
+    if (!initialized_) {
+        return;
+    }
+
+    Buffer* buffers[] = { &grid_buffer_, &cell_buffer_, &motion_buffer_, &arrow_mesh_buffer_, &arrow_buffer_, &outline_buffer_ };
+    for (Buffer* buffer : buffers) {
+        glDeleteBuffers(1, &buffer->id);
+        *buffer = Buffer();
+    }
+    if (arrow_program_) {
+        glDeleteProgram(arrow_program_);
+        arrow_program_ = 0;
+    }
+    num_grid_vertices_ = 0;
+    num_cell_vertices_ = 0;
+    initialized_ = false;
+    instanced_ = false;
+}
+
+bool PrimitiveRenderer::create_arrow_program()
+{
+    GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, ARROW_VERTEX_SHADER);
+    GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, ARROW_FRAGMENT_SHADER);
+    if (!vertex_shader || !fragment_shader) {
+        glDeleteShader(vertex_shader);
+        glDeleteShader(fragment_shader);
+        return false;
+    }
+
+    arrow_program_ = glCreateProgram();
+    glAttachShader(arrow_program_, vertex_shader);
+    glAttachShader(arrow_program_, fragment_shader);
+
+    // the per-vertex attribute takes location 0, which may not be instanced
+    glBindAttribLocation(arrow_program_, ARROW_VERTEX, "vertex");
+    glBindAttribLocation(arrow_program_, ARROW_POSE, "pose");
+    glBindAttribLocation(arrow_program_, ARROW_COLOR, "color");
+    glLinkProgram(arrow_program_);
+
+    // the program keeps the shaders alive while they are attached
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    GLint ok = GL_FALSE;
+    glGetProgramiv(arrow_program_, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetProgramInfoLog(arrow_program_, sizeof(log), 0, log);
+        fprintf(stderr, "Failed to link arrow program: %s\n", log);
+        glDeleteProgram(arrow_program_);
+        arrow_program_ = 0;
+        return false;
+    }
+    return true;
+}
+
+void PrimitiveRenderer::upload(Buffer& buffer, const void* data, std::size_t size, GLenum usage)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.id);
+    if (size > buffer.capacity) {
+        // grow geometrically so that a scene growing one goal at a time
+        // does not reallocate on every edit
+        buffer.capacity = std::max(size, 2 * buffer.capacity);
+        glBufferData(GL_ARRAY_BUFFER, buffer.capacity, 0, usage);
+    }
+    if (size) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+    }
+    buffer.size = size;
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void PrimitiveRenderer::set_grid(const Bounds2& area, int step)
+{
+    if (!initialized_) {
+        return;
+    }
+
+    // lighter lines first so that the major lines and axes draw over them
+    std::vector<float> vertices;
+    auto line = [&](double x0, double y0, double x1, double y1, float shade)
+    {
+        const float v[] = {
+            (float)x0, (float)y0, shade, shade, shade,
+            (float)x1, (float)y1, shade, shade, shade };
+        vertices.insert(vertices.end(), v, v + 2 * COLORED_VERTEX_FLOATS);
+    };
+
+    const int min_x = step * (int)ceil(area.min_x / step);
+    const int min_y = step * (int)ceil(area.min_y / step);
+    const int max_x = step * (int)floor(area.max_x / step);
+    const int max_y = step * (int)floor(area.max_y / step);
+    const int major = 5 * step;
+    for (int pass = 0; pass < 2; ++pass) {
+        const float shade = pass ? 0.5f : 0.8f;
+        for (int x = min_x; x <= max_x; x += step) {
+            if (x != 0 && ((x % major) == 0) == (pass == 1)) {
+                line(x, area.min_y, x, area.max_y, shade);
+            }
+        }
+        for (int y = min_y; y <= max_y; y += step) {
+            if (y != 0 && ((y % major) == 0) == (pass == 1)) {
+                line(area.min_x, y, area.max_x, y, shade);
+            }
+        }
+    }
+    if (area.min_x <= 0.0 && area.max_x >= 0.0) {
+        line(0, area.min_y, 0, area.max_y, 0.0f);
+    }
+    if (area.min_y <= 0.0 && area.max_y >= 0.0) {
+        line(area.min_x, 0, area.max_x, 0, 0.0f);
+    }
+
+    upload(grid_buffer_, vertices.data(), vertices.size() * sizeof(float), GL_STATIC_DRAW);
+    num_grid_vertices_ = vertices.size() / COLORED_VERTEX_FLOATS;
+}
+
+void PrimitiveRenderer::set_cells(const float* cells, std::size_t num_cells)
+{
+    if (!initialized_) {
+        return;
+    }
+
+    static const float corners[4][2] = { { -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.5f, 0.5f }, { -0.5f, 0.5f } };
+    cell_vertices_.clear();
+    for (std::size_t i = 0; i < num_cells; ++i) {
+        const float* cell = cells + i * BLENDED_VERTEX_FLOATS;
+        for (int k = 0; k < 4; ++k) {
+            const float v[BLENDED_VERTEX_FLOATS] = {
+                cell[0] + corners[k][0], cell[1] + corners[k][1], cell[2], cell[3], cell[4], cell[5] };
+            cell_vertices_.insert(cell_vertices_.end(), v, v + BLENDED_VERTEX_FLOATS);
+        }
+    }
+    upload(cell_buffer_, cell_vertices_.data(), cell_vertices_.size() * sizeof(float), GL_DYNAMIC_DRAW);
+    num_cell_vertices_ = 4 * num_cells;
+}
+
+void PrimitiveRenderer::begin_scene()
+{
+    motion_vertices_.clear();
+    arrows_.clear();
+}
+
+void PrimitiveRenderer::add_motion(const Pose2_cont* poses, std::size_t num_poses, double tolerance)
+{
+    if (num_poses < 2) {
+        return;
+    }
+
+    // motions are sampled far more densely than a line can show, and
+    // vertices dominate the cost of a frame on software drivers, so draw
+    // the fewest segments that stay within $tolerance of every pose.
+    // A segment from the anchor may end in any direction inside a cone that
+    // each pose past the anchor narrows to the directions passing within the
+    // tolerance of it; a pose outside the cone starts the next segment.
+    const double tol_sq = tolerance * tolerance;
+    std::size_t anchor = 0;
+    bool bounded = false;
+    double lo_x = 0.0, lo_y = 0.0, hi_x = 0.0, hi_y = 0.0;   // clockwise and counterclockwise edges of the cone
+    for (std::size_t i = 1; i < num_poses; ++i) {
+        double px = poses[i].x - poses[anchor].x;
+        double py = poses[i].y - poses[anchor].y;
+        double d_sq = px * px + py * py;
+        if (bounded && (lo_x * py - lo_y * px < 0.0 || px * hi_y - py * hi_x < 0.0)) {
+            emit_segment(poses[anchor], poses[i - 1]);
+            anchor = i - 1;
+            bounded = false;
+            px = poses[i].x - poses[anchor].x;
+            py = poses[i].y - poses[anchor].y;
+            d_sq = px * px + py * py;
+        }
+        if (d_sq <= tol_sq) {
+            continue;   // any segment from the anchor passes close enough
+        }
+
+        // the directions within the tolerance of this pose are its own
+        // rotated by at most asin(tol / d) either way
+        const double s = tolerance;
+        const double c = sqrt(d_sq - tol_sq);
+        const double cw_x = px * c + py * s, cw_y = py * c - px * s;
+        const double ccw_x = px * c - py * s, ccw_y = py * c + px * s;
+        if (!bounded || lo_x * cw_y - lo_y * cw_x > 0.0) {
+            lo_x = cw_x;
+            lo_y = cw_y;
+        }
+        if (!bounded || ccw_x * hi_y - ccw_y * hi_x > 0.0) {
+            hi_x = ccw_x;
+            hi_y = ccw_y;
+        }
+        bounded = true;
+    }
+    emit_segment(poses[anchor], poses[num_poses - 1]);
+}
+
+void PrimitiveRenderer::emit_segment(const Pose2_cont& a, const Pose2_cont& b)
+{
+    // separate segments rather than strips let every motion go out in one draw
+    const float v[] = { (float)a.x, (float)a.y, (float)b.x, (float)b.y };
+    motion_vertices_.insert(motion_vertices_.end(), v, v + 4);
+}
+
+void PrimitiveRenderer::add_arrow(const Pose2_cont& pose, float r, float g, float b)
+{
+    const float v[ARROW_INSTANCE_FLOATS] = { (float)pose.x, (float)pose.y, (float)pose.yaw, r, g, b };
+    arrows_.insert(arrows_.end(), v, v + ARROW_INSTANCE_FLOATS);
+}
+
+void PrimitiveRenderer::end_scene()
+{
+    if (!initialized_) {
+        return;
+    }
+
+    upload(motion_buffer_, motion_vertices_.data(), motion_vertices_.size() * sizeof(float), GL_DYNAMIC_DRAW);
+
+    if (instanced_) {
+        upload(arrow_buffer_, arrows_.data(), arrows_.size() * sizeof(float), GL_DYNAMIC_DRAW);
+        return;
+    }
+
+    arrow_triangles_.clear();
+    for (std::size_t i = 0; i < arrows_.size(); i += ARROW_INSTANCE_FLOATS) {
+        const float* a = &arrows_[i];
+        const double c = cos(a[2]);
+        const double s = sin(a[2]);
+        for (int k = 0; k < ARROW_MESH_VERTICES; ++k) {
+            const double vx = ARROW_MESH[2 * k];
+            const double vy = ARROW_MESH[2 * k + 1];
+            const float v[COLORED_VERTEX_FLOATS] = {
+                (float)(a[0] + c * vx - s * vy), (float)(a[1] + s * vx + c * vy), a[3], a[4], a[5] };
+            arrow_triangles_.insert(arrow_triangles_.end(), v, v + COLORED_VERTEX_FLOATS);
+        }
+    }
+    upload(arrow_buffer_, arrow_triangles_.data(), arrow_triangles_.size() * sizeof(float), GL_DYNAMIC_DRAW);
+}
+
+void PrimitiveRenderer::begin_outlines()
+{
+    outline_vertices_.clear();
+}
+
+void PrimitiveRenderer::add_outline(const Pose2_cont& pose, float r, float g, float b, double scale)
+{
+    // separate segments so that every outline goes out in one draw
+    const double c = scale * cos(pose.yaw);
+    const double s = scale * sin(pose.yaw);
+    for (int k = 0; k < ARROW_OUTLINE_VERTICES; ++k) {
+        const int ends[2] = { k, (k + 1) % ARROW_OUTLINE_VERTICES };
+        for (int e : ends) {
+            const double vx = ARROW_OUTLINE[2 * e];
+            const double vy = ARROW_OUTLINE[2 * e + 1];
+            const float v[COLORED_VERTEX_FLOATS] = {
+                (float)(pose.x + c * vx - s * vy), (float)(pose.y + s * vx + c * vy), r, g, b };
+            outline_vertices_.insert(outline_vertices_.end(), v, v + COLORED_VERTEX_FLOATS);
+        }
+    }
+}
+
+void PrimitiveRenderer::end_outlines()
+{
+    if (!initialized_) {
+        return;
+    }
+    upload(outline_buffer_, outline_vertices_.data(), outline_vertices_.size() * sizeof(float), GL_STREAM_DRAW);
+}
+
+void PrimitiveRenderer::draw_colored(const Buffer& buffer, GLenum mode, std::size_t num_vertices) const
+{
+    if (!num_vertices) {
+        return;
+    }
+
+    const GLsizei stride = COLORED_VERTEX_FLOATS * sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.id);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, stride, (const GLvoid*)0);
+    glColorPointer(3, GL_FLOAT, stride, (const GLvoid*)(2 * sizeof(float)));
+    glDrawArrays(mode, 0, (GLsizei)num_vertices);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void PrimitiveRenderer::draw_grid() const
+{
+    draw_colored(grid_buffer_, GL_LINES, num_grid_vertices_);
+}
+
+void PrimitiveRenderer::draw_cells() const
+{
+    if (!num_cell_vertices_) {
+        return;
+    }
+
+    const GLsizei stride = BLENDED_VERTEX_FLOATS * sizeof(float);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBindBuffer(GL_ARRAY_BUFFER, cell_buffer_.id);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, stride, (const GLvoid*)0);
+    glColorPointer(4, GL_FLOAT, stride, (const GLvoid*)(2 * sizeof(float)));
+    glDrawArrays(GL_QUADS, 0, (GLsizei)num_cell_vertices_);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDisable(GL_BLEND);
+}
+
+void PrimitiveRenderer::draw_outlines() const
+{
+    draw_colored(outline_buffer_, GL_LINES, outline_buffer_.size / (COLORED_VERTEX_FLOATS * sizeof(float)));
+}
+
+void PrimitiveRenderer::draw_motions(float r, float g, float b) const
+{
+    if (!initialized_ || motion_vertices_.empty()) {
+        return;
+    }
+
+    glColor3f(r, g, b);
+    glBindBuffer(GL_ARRAY_BUFFER, motion_buffer_.id);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, (const GLvoid*)0);
+    glDrawArrays(GL_LINES, 0, (GLsizei)num_motion_vertices());
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void PrimitiveRenderer::draw_arrows() const
+{
+    if (!initialized_ || arrows_.empty()) {
+        return;
+    }
+
+    if (!instanced_) {
+        draw_colored(arrow_buffer_, GL_TRIANGLES, num_arrows() * ARROW_MESH_VERTICES);
+        return;
+    }
+
+    const GLsizei stride = ARROW_INSTANCE_FLOATS * sizeof(float);
+    glUseProgram(arrow_program_);
+
+    glBindBuffer(GL_ARRAY_BUFFER, arrow_mesh_buffer_.id);
+    glEnableVertexAttribArray(ARROW_VERTEX);
+    glVertexAttribPointer(ARROW_VERTEX, 2, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, arrow_buffer_.id);
+    glEnableVertexAttribArray(ARROW_POSE);
+    glEnableVertexAttribArray(ARROW_COLOR);
+    glVertexAttribPointer(ARROW_POSE, 3, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)0);
+    glVertexAttribPointer(ARROW_COLOR, 3, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)(3 * sizeof(float)));
+    glVertexAttribDivisorARB(ARROW_POSE, 1);
+    glVertexAttribDivisorARB(ARROW_COLOR, 1);
+
+    glDrawArraysInstancedARB(GL_TRIANGLES, 0, ARROW_MESH_VERTICES, (GLsizei)num_arrows());
+
+    glVertexAttribDivisorARB(ARROW_POSE, 0);
+    glVertexAttribDivisorARB(ARROW_COLOR, 0);
+    glDisableVertexAttribArray(ARROW_COLOR);
+    glDisableVertexAttribArray(ARROW_POSE);
+    glDisableVertexAttribArray(ARROW_VERTEX);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUseProgram(0);
+}
@@ -0,0 +1,124 @@
+#ifndef PrimitiveRenderer_h
+#define PrimitiveRenderer_h
+
+#include <cstddef>
+#include <vector>
+#include <GL/gl.h>
+#include "Pose2.h"
+
+/// Retained-mode drawing of the designer's scene. The grid, the motions and
+/// the arrows live in vertex buffers that are only rewritten when they
+/// change, so a frame costs a few draw calls however many motions there are.
+///
+/// Arrows are one mesh drawn at every pose: instanced from a per-pose
+/// attribute buffer when the driver has ARB_instanced_arrays and GLSL, and
+/// from a buffer of triangles transformed on the CPU otherwise. Arrow
+/// outlines, which mark the selection, are few and change with it, so they
+/// are always transformed on the CPU and drawn as one batch of lines.
+///
+/// Every method except the constructor needs the widget's context current.
+class PrimitiveRenderer
+{
+public:
+
+    PrimitiveRenderer();
+
+    /// Create the buffers and the arrow program. Return false if the context
+    /// lacks vertex buffers, in which case nothing is drawn.
+    bool initialize();
+
+    /// Delete the buffers and the arrow program
+    void release();
+
+    bool initialized() const { return initialized_; }
+    bool instanced() const { return instanced_; }
+
+    /// Rebuild the grid over $area with lines every $step cells, every fifth
+    /// one darker, and the axes darkest
+    void set_grid(const Bounds2& area, int step);
+
+    /// Start a new scene, dropping the motions and arrows of the last one
+    void begin_scene();
+
+    /// Add the motion through $poses, drawn with the fewest segments that
+    /// pass within $tolerance cells of every pose
+    void add_motion(const Pose2_cont* poses, std::size_t num_poses, double tolerance);
+    void add_arrow(const Pose2_cont& pose, float r, float g, float b);
+
+    /// Upload the scene added since begin_scene()
+    void end_scene();
+
+    /// Replace the shaded cells with the $num_cells unit cells in $cells,
+    /// each given as its center x and y and an r, g, b, a color
+    void set_cells(const float* cells, std::size_t num_cells);
+
+    /// Start a new set of outlines, dropping the last
+    void begin_outlines();
+
+    /// Add the outline of the arrow at $pose, scaled by $scale
+    void add_outline(const Pose2_cont& pose, float r, float g, float b, double scale = 1.0);
+
+    /// Upload the outlines added since begin_outlines()
+    void end_outlines();
+
+    void draw_grid() const;
+    void draw_cells() const;
+    void draw_motions(float r, float g, float b) const;
+    void draw_arrows() const;
+    void draw_outlines() const;
+
+    std::size_t num_motion_vertices() const { return motion_vertices_.size() / 2; }
+    std::size_t num_arrows() const { return arrows_.size() / ARROW_INSTANCE_FLOATS; }
+
+private:
+
+    /// x, y, yaw, r, g, b
+    static const int ARROW_INSTANCE_FLOATS = 6;
+
+    /// x, y, r, g, b
+    static const int COLORED_VERTEX_FLOATS = 5;
+
+    /// x, y, r, g, b, a
+    static const int BLENDED_VERTEX_FLOATS = 6;
+
+    /// A vertex buffer that keeps its storage when rewritten with less data
+    struct Buffer
+    {
+        Buffer() : id(0), capacity(0), size(0) { }
+        GLuint id;
+        std::size_t capacity;   ///< bytes
+        std::size_t size;       ///< bytes
+    };
+
+    bool initialized_;
+    bool instanced_;
+
+    Buffer grid_buffer_;
+    std::size_t num_grid_vertices_;
+
+    Buffer cell_buffer_;
+    std::size_t num_cell_vertices_;
+    std::vector<float> cell_vertices_;
+
+    Buffer motion_buffer_;
+    std::vector<float> motion_vertices_;
+
+    Buffer arrow_mesh_buffer_;
+    Buffer arrow_buffer_;
+    std::vector<float> arrows_;
+    std::vector<float> arrow_triangles_;    ///< when not instanced
+
+    Buffer outline_buffer_;
+    std::vector<float> outline_vertices_;
+
+    GLuint arrow_program_;
+
+    void upload(Buffer& buffer, const void* data, std::size_t size, GLenum usage);
+    void draw_colored(const Buffer& buffer, GLenum mode, std::size_t num_vertices) const;
+
+    bool create_arrow_program();
+
+    void emit_segment(const Pose2_cont& a, const Pose2_cont& b);
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include "angles.h"
+#include <algorithm>
+#include <cmath>
+
+double NormalizeAngle(double angle_rad, double angle_min_rad, double angle_max_rad)
+{
+    if (fabs(angle_rad) > 2.0 * M_PI) { // normalize to [-2*pi, 2*pi] range
+        angle_rad -= ((int)(angle_rad / (2.0 * M_PI))) * 2.0 * M_PI;
+    }
+
+    while (angle_rad > angle_max_rad) {
+        angle_rad -= 2.0 * M_PI;
+    }
+
+    while (angle_rad < angle_min_rad) {
+        angle_rad += 2 * M_PI;
+    }
+
+    return angle_rad;
+}
+
+double ShortestAngleDist(double a1_rad, double a2_rad)
+{
+    double a1_norm = NormalizeAngle(a1_rad, 0.0, 2.0 * M_PI);
+    double a2_norm = NormalizeAngle(a2_rad, 0.0, 2.0 * M_PI);
+    return std::min(fabs(a1_norm - a2_norm), 2.0 * M_PI - fabs(a2_norm - a1_norm));
+}
+
+double ShortestAngleDiff(double a1_rad, double a2_rad)
+{
+    double a1_norm = NormalizeAngle(a1_rad, 0.0, 2.0 * M_PI);
+    double a2_norm = NormalizeAngle(a2_rad, 0.0, 2.0 * M_PI);
+
+    double dist = ShortestAngleDist(a1_rad, a2_rad);
+    if (ShortestAngleDist(a1_norm + dist, a2_norm) < ShortestAngleDist(a1_norm - dist, a2_norm)) {
+        return -dist;
+    }
+    else {
+        return dist;
+    }
+}
+
+double shortest_angle_diff(double af, double ai)
+{
+    auto cmodf = [](double a, double n) { return fmod(fmod(a, n) + n, n); };
+    double a = af - ai;
+    a = cmodf(a + M_PI, 2.0 * M_PI) - M_PI;
+    return a;
+}
+
+double normalize_angle(double angle)
+{
+    // get to the range from -2PI, 2PI
+    if (fabs(angle) > 2 * M_PI) {
+        angle = angle - ((int)(angle / (2 * M_PI))) * 2 * M_PI;
+    }
+
+    // get to the range 0, 2PI
+    if (angle < 0) {
+        angle += 2 * M_PI;
+    }
+
+    return angle;
+}
+
+double realize_angle(int index, int num_angles)
+{
+    return index * (2.0 * M_PI) / num_angles;
+}
+
+int discretize_angle(double angle, int num_angles)
+{
+    double thetaBinSize = 2.0 * M_PI / num_angles;
+    int index = (int)(normalize_angle(angle + thetaBinSize / 2.0) / (2.0 * M_PI) * (num_angles));
+    // an angle within half a bin below 2*pi belongs to bin 0
+    return index < num_angles ? index : 0;
+}
@@ -0,0 +1,25 @@
+#ifndef angles_h
+#define angles_h
+
+/// Normalize $angle_rad into the range [$angle_min_rad, $angle_max_rad]
+double NormalizeAngle(double angle_rad, double angle_min_rad, double angle_max_rad);
+
+/// Return the unsigned shortest distance between two angles
+double ShortestAngleDist(double a1_rad, double a2_rad);
+
+/// Return the signed shortest difference between two angles
+double ShortestAngleDiff(double a1_rad, double a2_rad);
+
+/// Return the signed difference $af - $ai wrapped into [-pi, pi)
+double shortest_angle_diff(double af, double ai);
+
+/// Normalize $angle into the range [0, 2*pi)
+double normalize_angle(double angle);
+
+/// Return the continuous angle at the center of discrete angle bin $index
+double realize_angle(int index, int num_angles);
+
+/// Return the index of the discrete angle bin containing $angle
+int discretize_angle(double angle, int num_angles);
+
+#endif
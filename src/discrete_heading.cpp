@@ -0,0 +1,52 @@
+#include "discrete_heading.h"
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "angles.h"
+
+thread_local const HeadingTable* HeadingTable::last_ = 0;
+
+const HeadingTable& HeadingTable::get_locked(int num_angles)
+{
+    static std::mutex mutex;
+    static std::map<int, std::unique_ptr<HeadingTable>> tables;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<HeadingTable>& table = tables[num_angles];
+    if (!table) {
+        table.reset(new HeadingTable(num_angles));
+    }
+    last_ = table.get();
+    return *table;
+}
+
+HeadingTable::HeadingTable(int num_angles) :
+    num_angles_(num_angles),
+    bins_per_radian_(num_angles / (2.0 * M_PI)),
+    angle_(num_angles),
+    cos_(num_angles),
+    sin_(num_angles)
+{
+    for (int i = 0; i < num_angles; ++i) {
+        angle_[i] = realize_angle(i, num_angles);
+        cos_[i] = ::cos(angle_[i]);
+        sin_[i] = ::sin(angle_[i]);
+    }
+
+    // the differences of realized angles are not exact multiples of one
+    // step, so store every pair rather than one entry per step
+    if (num_angles <= MAX_DIFF_TABLE_ANGLES) {
+        diff_.resize((std::size_t)num_angles * num_angles);
+        for (int to = 0; to < num_angles; ++to) {
+            for (int from = 0; from < num_angles; ++from) {
+                diff_[(std::size_t)to * num_angles + from] = diff_slow(to, from);
+            }
+        }
+    }
+}
+
+double HeadingTable::diff_slow(int to, int from) const
+{
+    return shortest_angle_diff(angle_[to], angle_[from]);
+}
@@ -0,0 +1,143 @@
+#ifndef discrete_heading_h
+#define discrete_heading_h
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/// Angles, sines and cosines of the discrete headings at one resolution.
+/// Entries equal realize_angle() and the cos/sin of it exactly, so code
+/// reading them produces the same bits as code that calls the trig functions
+/// itself. Tables are built once per resolution and never freed.
+class HeadingTable
+{
+public:
+
+    /// Return the table for $num_angles headings, building it on first use.
+    /// Safe to call from several threads.
+    static const HeadingTable& get(int num_angles)
+    {
+        // callers tend to stay at one resolution, so skip the lock when a
+        // thread asks for the same table again
+        const HeadingTable* table = last_;
+        return table && table->num_angles_ == num_angles ? *table : get_locked(num_angles);
+    }
+
+    int num_angles() const { return num_angles_; }
+
+    double angle(int index) const { return angle_[index]; }
+    double cos(int index) const { return cos_[index]; }
+    double sin(int index) const { return sin_[index]; }
+
+    /// Return shortest_angle_diff(angle($to), angle($from))
+    double diff(int to, int from) const
+    {
+        return diff_.empty() ? diff_slow(to, from) : diff_[(std::size_t)to * num_angles_ + from];
+    }
+
+    /// Wrap $index into [0, num_angles)
+    int wrap(int index) const
+    {
+        const int r = index % num_angles_;
+        return r < 0 ? r + num_angles_ : r;
+    }
+
+    /// Return the signed number of steps from $from to $to, in
+    /// [-num_angles / 2, num_angles / 2)
+    int steps(int to, int from) const
+    {
+        return wrap(to - from + num_angles_ / 2) - num_angles_ / 2;
+    }
+
+    /// Return the index of the bin containing $angle, as discretize_angle
+    /// does but without normalizing $angle first. NaN and infinite angles
+    /// fall in bin 0.
+    int discretize(double angle) const
+    {
+        double x = angle * bins_per_radian_ + 0.5;
+        if (!(std::fabs(x) < MAX_DISCRETIZE_BINS)) {
+            // reduce angles far enough out to overflow the cast
+            if (!std::isfinite(angle)) {
+                return 0;
+            }
+            x = std::fmod(angle, 2.0 * M_PI) * bins_per_radian_ + 0.5;
+        }
+        int index = (int)x;
+        if (x < index) {
+            --index;    // truncation rounded a negative bin up
+        }
+        return wrap(index);
+    }
+
+private:
+
+    /// Resolutions above this compute diff() instead of storing n^2
+    /// entries; at the cap the table takes 512 KiB
+    static const int MAX_DIFF_TABLE_ANGLES = 256;
+
+    /// Bins discretize() counts out to before reducing the angle
+    static constexpr double MAX_DISCRETIZE_BINS = 1 << 30;
+
+    /// The table each thread asked for last
+    static thread_local const HeadingTable* last_;
+
+    explicit HeadingTable(int num_angles);
+
+    static const HeadingTable& get_locked(int num_angles);
+
+    double diff_slow(int to, int from) const;
+
+    int num_angles_;
+    double bins_per_radian_;
+    std::vector<double> angle_;
+    std::vector<double> cos_;
+    std::vector<double> sin_;
+    std::vector<double> diff_;
+};
+
+/// A heading index in [0, num_angles) at a fixed resolution. Arithmetic wraps
+/// around the circle without leaving the integers.
+class DiscreteHeading
+{
+public:
+
+    DiscreteHeading() : index_(0), table_(0) { }
+    DiscreteHeading(int index, const HeadingTable& table) : index_(table.wrap(index)), table_(&table) { }
+    DiscreteHeading(int index, int num_angles) : DiscreteHeading(index, HeadingTable::get(num_angles)) { }
+
+    /// Return the heading whose bin contains $angle
+    static DiscreteHeading from_angle(double angle, int num_angles)
+    {
+        const HeadingTable& table = HeadingTable::get(num_angles);
+        return DiscreteHeading(table.discretize(angle), table);
+    }
+
+    int index() const { return index_; }
+    int num_angles() const { return table_->num_angles(); }
+    const HeadingTable& table() const { return *table_; }
+
+    double angle() const { return table_->angle(index_); }
+    double cos() const { return table_->cos(index_); }
+    double sin() const { return table_->sin(index_); }
+
+    DiscreteHeading operator+(int steps) const { return DiscreteHeading(index_ + steps, *table_); }
+    DiscreteHeading operator-(int steps) const { return DiscreteHeading(index_ - steps, *table_); }
+    DiscreteHeading& operator+=(int steps) { index_ = table_->wrap(index_ + steps); return *this; }
+    DiscreteHeading& operator-=(int steps) { index_ = table_->wrap(index_ - steps); return *this; }
+
+    /// Return the signed number of steps from $from to this heading
+    int steps_from(const DiscreteHeading& from) const { return table_->steps(index_, from.index_); }
+
+    /// Return the signed angle from $from to this heading, as shortest_angle_diff would
+    double diff_from(const DiscreteHeading& from) const { return table_->diff(index_, from.index_); }
+
+    bool operator==(const DiscreteHeading& rhs) const { return index_ == rhs.index_ && table_ == rhs.table_; }
+    bool operator!=(const DiscreteHeading& rhs) const { return !(*this == rhs); }
+
+private:
+
+    int index_;
+    const HeadingTable* table_;
+};
+
+#endif
@@ -0,0 +1,350 @@
+#include "dubins_motions.h"
+#include <algorithm>
+#include <cmath>
+
+static const double TWO_PI = 2.0 * M_PI;
+
+static inline double mod2pi(double angle)
+{
+    double a = fmod(angle, TWO_PI);
+    return a < 0.0 ? a + TWO_PI : a;
+}
+
+/// Wrap the turn of an outer arc into [0, 2*pi), treating a turn within
+/// roundoff of a full circle as no turn at all
+static inline double wrap_turn(double angle)
+{
+    double a = mod2pi(angle);
+    return a > TWO_PI - 1e-9 ? 0.0 : a;
+}
+
+/// A start and goal pair rotated and scaled so the start is at the origin,
+/// the goal lies on the positive x axis at distance $d, and the turning radius is 1
+struct DubinsProblem
+{
+    double d, alpha, beta;
+    double sa, ca, sb, cb, cab;
+};
+
+static inline void normalize_problem(
+    double dx, double dy, double start_yaw, double goal_yaw, double radius, DubinsProblem& p)
+{
+    const double theta = mod2pi(atan2(dy, dx));
+    p.d = sqrt(dx * dx + dy * dy) / radius;
+    p.alpha = mod2pi(start_yaw - theta);
+    p.beta = mod2pi(goal_yaw - theta);
+    p.sa = sin(p.alpha);
+    p.ca = cos(p.alpha);
+    p.sb = sin(p.beta);
+    p.cb = cos(p.beta);
+    p.cab = cos(p.alpha - p.beta);
+}
+
+// Each word solver writes its three segment lengths and returns false if the
+// word cannot connect the poses. See Shkel and Lumelsky, "Classification of
+// the Dubins set", 2001.
+
+static inline bool solve_lsl(const DubinsProblem& p, double* out)
+{
+    const double p_sq = 2.0 + p.d * p.d - 2.0 * p.cab + 2.0 * p.d * (p.sa - p.sb);
+    if (p_sq < 0.0) {
+        return false;
+    }
+    const double tmp = atan2(p.cb - p.ca, p.d + p.sa - p.sb);
+    out[0] = wrap_turn(tmp - p.alpha);
+    out[1] = sqrt(p_sq);
+    out[2] = wrap_turn(p.beta - tmp);
+    return true;
+}
+
+static inline bool solve_rsr(const DubinsProblem& p, double* out)
+{
+    const double p_sq = 2.0 + p.d * p.d - 2.0 * p.cab + 2.0 * p.d * (p.sb - p.sa);
+    if (p_sq < 0.0) {
+        return false;
+    }
+    const double tmp = atan2(p.ca - p.cb, p.d - p.sa + p.sb);
+    out[0] = wrap_turn(p.alpha - tmp);
+    out[1] = sqrt(p_sq);
+    out[2] = wrap_turn(tmp - p.beta);
+    return true;
+}
+
+static inline bool solve_lsr(const DubinsProblem& p, double* out)
+{
+    const double p_sq = -2.0 + p.d * p.d + 2.0 * p.cab + 2.0 * p.d * (p.sa + p.sb);
+    if (p_sq < 0.0) {
+        return false;
+    }
+    const double len = sqrt(p_sq);
+    const double tmp = atan2(-p.ca - p.cb, p.d + p.sa + p.sb) - atan2(-2.0, len);
+    out[0] = wrap_turn(tmp - p.alpha);
+    out[1] = len;
+    out[2] = wrap_turn(tmp - p.beta);
+    return true;
+}
+
+static inline bool solve_rsl(const DubinsProblem& p, double* out)
+{
+    const double p_sq = -2.0 + p.d * p.d + 2.0 * p.cab - 2.0 * p.d * (p.sa + p.sb);
+    if (p_sq < 0.0) {
+        return false;
+    }
+    const double len = sqrt(p_sq);
+    const double tmp = atan2(p.ca + p.cb, p.d - p.sa - p.sb) - atan2(2.0, len);
+    out[0] = wrap_turn(p.alpha - tmp);
+    out[1] = len;
+    out[2] = wrap_turn(p.beta - tmp);
+    return true;
+}
+
+static inline bool solve_rlr(const DubinsProblem& p, double* out)
+{
+    const double c = (6.0 - p.d * p.d + 2.0 * p.cab + 2.0 * p.d * (p.sa - p.sb)) / 8.0;
+    if (fabs(c) > 1.0) {
+        return false;
+    }
+    const double phi = atan2(p.ca - p.cb, p.d - p.sa + p.sb);
+    const double middle = mod2pi(TWO_PI - acos(c));
+    out[0] = wrap_turn(p.alpha - phi + 0.5 * middle);
+    out[1] = middle;
+    out[2] = wrap_turn(p.alpha - p.beta - out[0] + middle);
+    return true;
+}
+
+static inline bool solve_lrl(const DubinsProblem& p, double* out)
+{
+    const double c = (6.0 - p.d * p.d + 2.0 * p.cab + 2.0 * p.d * (p.sb - p.sa)) / 8.0;
+    if (fabs(c) > 1.0) {
+        return false;
+    }
+    const double phi = atan2(p.ca - p.cb, p.d + p.sa - p.sb);
+    const double middle = mod2pi(TWO_PI - acos(c));
+    out[0] = wrap_turn(-p.alpha - phi + 0.5 * middle);
+    out[1] = middle;
+    out[2] = wrap_turn(p.beta - p.alpha - out[0] + middle);
+    return true;
+}
+
+typedef bool (*DubinsWordSolver)(const DubinsProblem&, double*);
+
+/// Indexed by DubinsWord
+static const DubinsWordSolver DUBINS_WORD_SOLVERS[DUBINS_NUM_WORDS] =
+{
+    solve_lsl, solve_lsr, solve_rsl, solve_rsr, solve_rlr, solve_lrl
+};
+
+enum DubinsSegmentType { SEG_L, SEG_S, SEG_R };
+
+static const DubinsSegmentType DUBINS_SEGMENT_TYPES[DUBINS_NUM_WORDS][3] =
+{
+    { SEG_L, SEG_S, SEG_L },
+    { SEG_L, SEG_S, SEG_R },
+    { SEG_R, SEG_S, SEG_L },
+    { SEG_R, SEG_S, SEG_R },
+    { SEG_R, SEG_L, SEG_R },
+    { SEG_L, SEG_R, SEG_L },
+};
+
+bool solve_dubins_motion(const Pose2_cont& start, const Pose2_cont& goal, double radius, DubinsMotion& motion)
+{
+    motion.start = start;
+    motion.radius = radius;
+    motion.word = DUBINS_INFEASIBLE;
+    if (!(radius > 0.0)) {
+        return false;
+    }
+
+    DubinsProblem p;
+    normalize_problem(goal.x - start.x, goal.y - start.y, start.yaw, goal.yaw, radius, p);
+
+    // ties go to the earlier word, as in solve_dubins_motions
+    double best = 0.0;
+    for (int w = 0; w < DUBINS_NUM_WORDS; ++w) {
+        double segments[3];
+        if (!DUBINS_WORD_SOLVERS[w](p, segments)) {
+            continue;
+        }
+        double length = segments[0] + segments[1] + segments[2];
+        if (motion.word == DUBINS_INFEASIBLE || length < best) {
+            best = length;
+            motion.word = (uint8_t)w;
+            motion.segments[0] = segments[0];
+            motion.segments[1] = segments[1];
+            motion.segments[2] = segments[2];
+        }
+    }
+    return motion.word != DUBINS_INFEASIBLE;
+}
+
+double dubins_motion_length(const DubinsMotion& motion)
+{
+    return motion.radius * (motion.segments[0] + motion.segments[1] + motion.segments[2]);
+}
+
+/// Advance the unit-radius pose $p by $length along a segment of $type
+static inline Pose2_cont advance(const Pose2_cont& p, double length, DubinsSegmentType type)
+{
+    switch (type) {
+    case SEG_L:
+        return Pose2_cont(p.x + sin(p.yaw + length) - sin(p.yaw), p.y - cos(p.yaw + length) + cos(p.yaw), p.yaw + length);
+    case SEG_R:
+        return Pose2_cont(p.x - sin(p.yaw - length) + sin(p.yaw), p.y + cos(p.yaw - length) - cos(p.yaw), p.yaw - length);
+    default:
+        return Pose2_cont(p.x + length * cos(p.yaw), p.y + length * sin(p.yaw), p.yaw);
+    }
+}
+
+/// Evaluate $motion at $s, in units of its radius along the path, given the
+/// unit-radius poses at the start of each segment
+static inline Pose2_cont evaluate(const DubinsMotion& motion, const Pose2_cont* knots, double s)
+{
+    const DubinsSegmentType* types = DUBINS_SEGMENT_TYPES[motion.word];
+    Pose2_cont p;
+    if (s <= motion.segments[0]) {
+        p = advance(knots[0], s, types[0]);
+    }
+    else if (s <= motion.segments[0] + motion.segments[1]) {
+        p = advance(knots[1], s - motion.segments[0], types[1]);
+    }
+    else {
+        p = advance(knots[2], s - motion.segments[0] - motion.segments[1], types[2]);
+    }
+    return Pose2_cont(
+            motion.start.x + motion.radius * p.x,
+            motion.start.y + motion.radius * p.y,
+            p.yaw);
+}
+
+static inline void segment_knots(const DubinsMotion& motion, Pose2_cont* knots)
+{
+    const DubinsSegmentType* types = DUBINS_SEGMENT_TYPES[motion.word];
+    knots[0] = Pose2_cont(0.0, 0.0, motion.start.yaw);
+    knots[1] = advance(knots[0], motion.segments[0], types[0]);
+    knots[2] = advance(knots[1], motion.segments[1], types[1]);
+}
+
+Pose2_cont dubins_motion_pose(const DubinsMotion& motion, double t)
+{
+    Pose2_cont knots[3];
+    segment_knots(motion, knots);
+    return evaluate(motion, knots, t * (motion.segments[0] + motion.segments[1] + motion.segments[2]));
+}
+
+int num_dubins_motion_samples(const DubinsMotion& motion, double resolution)
+{
+    const double length = dubins_motion_length(motion);
+    if (!(length > 0.0)) {
+        return 0;
+    }
+    if (!(resolution > 0.0)) {
+        resolution = DUBINS_SAMPLE_RES;
+    }
+    return std::max(2, (int)std::ceil(length / resolution) + 1);
+}
+
+void sample_dubins_motion(const DubinsMotion& motion, int num_samples, Pose2_cont* poses)
+{
+    Pose2_cont knots[3];
+    segment_knots(motion, knots);
+
+    const double total = motion.segments[0] + motion.segments[1] + motion.segments[2];
+    const double step = num_samples > 1 ? total / (num_samples - 1) : 0.0;
+    for (int i = 0; i < num_samples; ++i) {
+        poses[i] = evaluate(motion, knots, i == num_samples - 1 ? total : i * step);
+    }
+}
+
+double DubinsGenerator::turning_radius(const DubinsMotion& motion) const
+{
+    const DubinsSegmentType* types = DUBINS_SEGMENT_TYPES[motion.word];
+    for (int i = 0; i < 3; ++i) {
+        if (types[i] != SEG_S && motion.segments[i] > 0.0) {
+            return motion.radius;
+        }
+    }
+    return 0.0;
+}
+
+DubinsMotion DubinsMotionBatch::motion(const Pose2Array& starts, std::size_t i) const
+{
+    DubinsMotion m;
+    m.start = starts[i];
+    m.radius = radius;
+    m.segments[0] = segment0[i];
+    m.segments[1] = segment1[i];
+    m.segments[2] = segment2[i];
+    m.word = word[i];
+    return m;
+}
+
+/// Evaluate one word for every pair and keep it wherever it is strictly shorter
+template <bool (*Solve)(const DubinsProblem&, double*)>
+static void solve_word_pass(uint8_t w, DubinsMotionBatch& motions)
+{
+    const std::size_t n = motions.size();
+    for (std::size_t i = 0; i < n; ++i) {
+        DubinsProblem p = {
+            motions.d[i], motions.alpha[i], motions.beta[i],
+            motions.sa[i], motions.ca[i], motions.sb[i], motions.cb[i], motions.cab[i]
+        };
+        double segments[3];
+        if (!Solve(p, segments)) {
+            continue;
+        }
+        double length = segments[0] + segments[1] + segments[2];
+        if (motions.word[i] == DUBINS_INFEASIBLE || length < motions.length[i]) {
+            motions.length[i] = length;
+            motions.word[i] = w;
+            motions.segment0[i] = segments[0];
+            motions.segment1[i] = segments[1];
+            motions.segment2[i] = segments[2];
+        }
+    }
+}
+
+void solve_dubins_motions(const Pose2Array& starts, const Pose2Array& goals, double radius, DubinsMotionBatch& motions)
+{
+    const std::size_t n = goals.size();
+
+    motions.radius = radius;
+    motions.segment0.resize(n);
+    motions.segment1.resize(n);
+    motions.segment2.resize(n);
+    motions.length.resize(n);
+    motions.word.assign(n, DUBINS_INFEASIBLE);
+    motions.d.resize(n);
+    motions.alpha.resize(n);
+    motions.beta.resize(n);
+    motions.sa.resize(n);
+    motions.ca.resize(n);
+    motions.sb.resize(n);
+    motions.cb.resize(n);
+    motions.cab.resize(n);
+
+    if (!(radius > 0.0)) {
+        return;
+    }
+
+    // pass 1: normalize every pair
+    for (std::size_t i = 0; i < n; ++i) {
+        DubinsProblem p;
+        normalize_problem(goals.x[i] - starts.x[i], goals.y[i] - starts.y[i], starts.yaw[i], goals.yaw[i], radius, p);
+        motions.d[i] = p.d;
+        motions.alpha[i] = p.alpha;
+        motions.beta[i] = p.beta;
+        motions.sa[i] = p.sa;
+        motions.ca[i] = p.ca;
+        motions.sb[i] = p.sb;
+        motions.cb[i] = p.cb;
+        motions.cab[i] = p.cab;
+    }
+
+    // passes 2-7: one per word, in DubinsWord order so ties resolve as in the scalar solve
+    solve_word_pass<solve_lsl>(DUBINS_LSL, motions);
+    solve_word_pass<solve_lsr>(DUBINS_LSR, motions);
+    solve_word_pass<solve_rsl>(DUBINS_RSL, motions);
+    solve_word_pass<solve_rsr>(DUBINS_RSR, motions);
+    solve_word_pass<solve_rlr>(DUBINS_RLR, motions);
+    solve_word_pass<solve_lrl>(DUBINS_LRL, motions);
+}
@@ -0,0 +1,134 @@
+#ifndef dubins_motions_h
+#define dubins_motions_h
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+#include "Pose2.h"
+#include "unicycle_motions.h"
+
+/// The six Dubins path words, each three segments turning Left, Right or going Straight
+enum DubinsWord
+{
+    DUBINS_LSL = 0,
+    DUBINS_LSR,
+    DUBINS_RSL,
+    DUBINS_RSR,
+    DUBINS_RLR,
+    DUBINS_LRL,
+    DUBINS_NUM_WORDS,
+    DUBINS_INFEASIBLE = DUBINS_NUM_WORDS
+};
+
+/// Shortest forward path between two poses for a vehicle whose turning radius
+/// is at least $radius. $segments holds the length of each segment of $word in
+/// units of $radius, i.e. the angle turned on arcs.
+struct DubinsMotion
+{
+    Pose2_cont start;
+    double radius;
+    double segments[3];
+    uint8_t word;   ///< a DubinsWord
+};
+
+/// Solve for the shortest Dubins path from $start to $goal with turning
+/// radius $radius. Return false if $radius is not positive.
+bool solve_dubins_motion(const Pose2_cont& start, const Pose2_cont& goal, double radius, DubinsMotion& motion);
+
+/// Return the path length of $motion in cells
+double dubins_motion_length(const DubinsMotion& motion);
+
+/// Return the pose reached at normalized time $t, in [0, 1], along $motion.
+/// Headings are continuous from the start heading rather than normalized.
+Pose2_cont dubins_motion_pose(const DubinsMotion& motion, double t);
+
+/// Default spacing of Dubins samples along the path, in cells
+static const double DUBINS_SAMPLE_RES = 0.1;
+
+/// Return the number of samples that keeps consecutive poses at most
+/// $resolution cells apart along $motion, or DUBINS_SAMPLE_RES apart if it
+/// is 0. Return 0 for an empty path.
+int num_dubins_motion_samples(const DubinsMotion& motion, double resolution);
+
+/// Write $num_samples poses, evenly spaced along $motion and including both
+/// endpoints, into $poses
+void sample_dubins_motion(const DubinsMotion& motion, int num_samples, Pose2_cont* poses);
+
+/// Struct-of-arrays results of a batched solve; segment lengths are in units
+/// of the shared turning radius. The scratch arrays are kept between calls.
+struct DubinsMotionBatch
+{
+    double radius;
+    std::vector<double> segment0;
+    std::vector<double> segment1;
+    std::vector<double> segment2;
+    std::vector<double> length;     ///< total length in units of the radius
+    std::vector<uint8_t> word;      ///< a DubinsWord
+
+    std::size_t size() const { return word.size(); }
+
+    /// Return the $i'th motion, which must not be DUBINS_INFEASIBLE
+    DubinsMotion motion(const Pose2Array& starts, std::size_t i) const;
+
+    // scratch: the normalized problem of Shkel and Lumelsky
+    std::vector<double> d, alpha, beta;
+    std::vector<double> sa, ca, sb, cb, cab;
+};
+
+/// Solve for the shortest Dubins paths from $starts[i] to $goals[i]. Every
+/// pair is first normalized, then each of the six words is evaluated for all
+/// pairs in its own pass, keeping the shortest. Results match solve_dubins_motion exactly.
+void solve_dubins_motions(const Pose2Array& starts, const Pose2Array& goals, double radius, DubinsMotionBatch& motions);
+
+/// Dubins paths as a curve generator; see motion_generator.h
+class DubinsGenerator
+{
+public:
+
+    typedef DubinsMotion Motion;
+    typedef DubinsMotionBatch Batch;
+
+    explicit DubinsGenerator(double radius = 1.0) : radius_(radius) { }
+
+    static const char* name() { return "dubins"; }
+
+    double radius() const { return radius_; }
+
+    bool solve(const Pose2_cont& start, const Pose2_cont& goal, Motion& motion) const
+    {
+        return solve_dubins_motion(start, goal, radius_, motion);
+    }
+
+    void solve(const Pose2Array& starts, const Pose2Array& goals, Batch& motions) const
+    {
+        solve_dubins_motions(starts, goals, radius_, motions);
+    }
+
+    bool feasible(const Batch& motions, std::size_t i) const
+    {
+        return motions.word[i] != DUBINS_INFEASIBLE;
+    }
+
+    Motion motion(const Batch& motions, const Pose2Array& starts, std::size_t i) const
+    {
+        return motions.motion(starts, i);
+    }
+
+    double turning_radius(const Motion& motion) const;
+
+    int num_samples(const Motion& motion, double resolution) const
+    {
+        return num_dubins_motion_samples(motion, resolution);
+    }
+
+    void sample(const Motion& motion, int num_samples, Pose2_cont* poses) const
+    {
+        sample_dubins_motion(motion, num_samples, poses);
+    }
+
+private:
+
+    double radius_;
+};
+
+#endif
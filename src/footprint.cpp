@@ -0,0 +1,352 @@
+#include "footprint.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "angles.h"
+#include "lattice_primitives.h"
+#include "work_stealing_pool.h"
+
+Footprint arrow_footprint()
+{
+    // the outline of the arrows the designer draws; see PrimitiveRenderer
+    const FootprintVertex vertices[] =
+    {
+        { -0.5, 0.15 },
+        { -0.5, -0.15 },
+        { 0.166, -0.15 },
+        { 0.166, -0.3 },
+        { 0.5, 0.0 },
+        { 0.166, 0.3 },
+        { 0.166, 0.15 },
+    };
+    return Footprint(vertices, vertices + sizeof(vertices) / sizeof(vertices[0]));
+}
+
+/// Return whether $p and $q lie on the same side of the line through $a and $b
+static inline bool same_side(const FootprintVertex& p, const FootprintVertex& q, const FootprintVertex& a, const FootprintVertex& b)
+{
+    const double cp = (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+    const double cq = (b.x - a.x) * (q.y - a.y) - (b.y - a.y) * (q.x - a.x);
+    return cp * cq >= 0.0;
+}
+
+static inline bool point_in_triangle(const FootprintVertex& p, const FootprintVertex& a, const FootprintVertex& b, const FootprintVertex& c)
+{
+    return same_side(p, a, b, c) && same_side(p, b, a, c) && same_side(p, c, a, b);
+}
+
+bool arrow_contains(const Pose2_cont& pose, double x, double y)
+{
+    // the head and two triangles covering the shaft
+    static const FootprintVertex triangles[3][3] =
+    {
+        { { 0.166, 0.3 }, { 0.166, -0.3 }, { 0.5, 0.0 } },
+        { { -0.5, -0.15 }, { 0.166, -0.15 }, { -0.5, 0.15 } },
+        { { 0.166, -0.15 }, { 0.166, 0.15 }, { -0.5, 0.15 } },
+    };
+
+    // test in the arrow's frame rather than transforming every vertex
+    const double c = cos(pose.yaw);
+    const double s = sin(pose.yaw);
+    const FootprintVertex p = { c * (x - pose.x) + s * (y - pose.y), -s * (x - pose.x) + c * (y - pose.y) };
+    for (int i = 0; i < 3; ++i) {
+        if (point_in_triangle(p, triangles[i][0], triangles[i][1], triangles[i][2])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Bounds2 arrow_bounds(const Pose2_cont& pose)
+{
+    static const Footprint arrow = arrow_footprint();
+
+    const double c = cos(pose.yaw);
+    const double s = sin(pose.yaw);
+    Bounds2 bounds;
+    for (const FootprintVertex& v : arrow) {
+        bounds.add(pose.x + c * v.x - s * v.y, pose.y + s * v.x + c * v.y);
+    }
+    return bounds;
+}
+
+bool parse_footprint(const std::string& text, Footprint& footprint)
+{
+    footprint.clear();
+    const char* s = text.c_str();
+    while (*s) {
+        char* end;
+        FootprintVertex v;
+        v.x = strtod(s, &end);
+        if (end == s || *end != ',') {
+            return false;
+        }
+        s = end + 1;
+        v.y = strtod(s, &end);
+        if (end == s || (*end != ';' && *end != '\0')) {
+            return false;
+        }
+        footprint.push_back(v);
+        s = *end ? end + 1 : end;
+    }
+    return footprint.size() >= 3;
+}
+
+static inline int cell_index(double coord)
+{
+    return (int)std::floor(coord + 0.5);
+}
+
+/// The cells marked within a rectangle of the grid, one byte per cell in
+/// column-major order so reading them back yields them sorted
+struct CellMask
+{
+    int min_i;
+    int min_j;
+    int num_columns;
+    int num_rows;
+    std::vector<unsigned char> marks;
+
+    void mark(int i, int j)
+    {
+        marks[(i - min_i) * num_rows + (j - min_j)] = 1;
+    }
+
+    /// Return whether every cell that $bounds overlaps is marked
+    bool all_marked(const Bounds2& bounds) const
+    {
+        const int i0 = cell_index(bounds.min_x);
+        const int j0 = cell_index(bounds.min_y);
+        const int i1 = cell_index(bounds.max_x);
+        const int j1 = cell_index(bounds.max_y);
+        if (i0 < min_i || j0 < min_j || i1 >= min_i + num_columns || j1 >= min_j + num_rows) {
+            return false;
+        }
+        for (int i = i0; i <= i1; ++i) {
+            const unsigned char* column = &marks[(i - min_i) * num_rows];
+            for (int j = j0; j <= j1; ++j) {
+                if (!column[j - min_j]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+/// Mark every cell the segment from $a to $b passes through
+static void rasterize_edge(const FootprintVertex& a, const FootprintVertex& b, CellMask& cells)
+{
+    int i = cell_index(a.x);
+    int j = cell_index(a.y);
+    const int i_end = cell_index(b.x);
+    const int j_end = cell_index(b.y);
+    cells.mark(i, j);
+    if (i == i_end && j == j_end) {
+        return;
+    }
+
+    const double dx = b.x - a.x;
+    const double dy = b.y - a.y;
+    const int step_i = dx > 0.0 ? 1 : -1;
+    const int step_j = dy > 0.0 ? 1 : -1;
+
+    // parametric distance to the next cell boundary along each axis and between boundaries
+    const double inf = HUGE_VAL;
+    double t_max_x = dx != 0.0 ? ((i + 0.5 * step_i) - a.x) / dx : inf;
+    double t_max_y = dy != 0.0 ? ((j + 0.5 * step_j) - a.y) / dy : inf;
+    const double t_delta_x = dx != 0.0 ? step_i / dx : inf;
+    const double t_delta_y = dy != 0.0 ? step_j / dy : inf;
+
+    const int num_steps = std::abs(i_end - i) + std::abs(j_end - j);
+    for (int k = 0; k < num_steps; ++k) {
+        if (t_max_x < t_max_y) {
+            i += step_i;
+            t_max_x += t_delta_x;
+        }
+        else {
+            j += step_j;
+            t_max_y += t_delta_y;
+        }
+        cells.mark(i, j);
+    }
+}
+
+/// Mark every cell overlapped by the polygon $vertices: the cells its
+/// boundary crosses plus those whose centers lie inside it
+static void rasterize_polygon(const std::vector<FootprintVertex>& vertices, std::vector<double>& crossings, CellMask& cells)
+{
+    const std::size_t n = vertices.size();
+    double min_y = vertices[0].y;
+    double max_y = vertices[0].y;
+    for (std::size_t k = 0; k < n; ++k) {
+        rasterize_edge(vertices[k], vertices[(k + 1) % n], cells);
+        min_y = std::min(min_y, vertices[k].y);
+        max_y = std::max(max_y, vertices[k].y);
+    }
+
+    // scan the rows of cell centers with the even-odd rule
+    for (int j = (int)std::ceil(min_y); j <= (int)std::floor(max_y); ++j) {
+        crossings.clear();
+        for (std::size_t k = 0; k < n; ++k) {
+            const FootprintVertex& a = vertices[k];
+            const FootprintVertex& b = vertices[(k + 1) % n];
+            if ((a.y <= j) != (b.y <= j)) {
+                crossings.push_back(a.x + (j - a.y) * (b.x - a.x) / (b.y - a.y));
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+        for (std::size_t k = 0; k + 1 < crossings.size(); k += 2) {
+            for (int i = (int)std::ceil(crossings[k]); i <= (int)std::floor(crossings[k + 1]); ++i) {
+                cells.mark(i, j);
+            }
+        }
+    }
+}
+
+void swept_cells(
+    const Footprint& footprint,
+    const Pose2_cont* poses,
+    std::size_t num_poses,
+    std::vector<CellOffset>& cells)
+{
+    cells.clear();
+    if (footprint.size() < 3 || num_poses == 0) {
+        return;
+    }
+
+    double reach = 0.0;
+    for (const FootprintVertex& v : footprint) {
+        reach = std::max(reach, std::sqrt(v.x * v.x + v.y * v.y));
+    }
+
+    // every placement lies within the bounds of the poses grown by the
+    // reach, so the cells can be marked in a mask that size rather than
+    // collected, sorted and deduplicated; most repeat between placements
+    Bounds2 path;
+    for (std::size_t i = 0; i < num_poses; ++i) {
+        path.add(poses[i].x, poses[i].y);
+    }
+    // with a cell to spare on each side against rounding
+    CellMask mask;
+    mask.min_i = cell_index(path.min_x - reach) - 1;
+    mask.min_j = cell_index(path.min_y - reach) - 1;
+    mask.num_columns = cell_index(path.max_x + reach) - mask.min_i + 2;
+    mask.num_rows = cell_index(path.max_y + reach) - mask.min_j + 2;
+    mask.marks.assign((std::size_t)mask.num_columns * mask.num_rows, 0);
+
+    // the bounds of the last placement, or bounds known to contain them
+    Bounds2 bounds;
+    double last_x = 0.0;
+    double last_y = 0.0;
+    double last_heading = 0.0;
+
+    std::vector<FootprintVertex> placed(footprint.size());
+    std::vector<double> crossings;
+    auto place = [&](double x, double y, double yaw, double heading)
+    {
+        // no vertex moves further than the center plus the reach times the
+        // turn, so the last bounds shifted and grown by that much, and a
+        // little against rounding, contain the footprint's. The polygon marks
+        // no cell outside its bounds, so once every cell within them is
+        // marked it has nothing to add.
+        if (!bounds.empty()) {
+            const double grow = reach * std::fabs(heading - last_heading) + 1e-9;
+            const Bounds2 moved(
+                bounds.min_x + (x - last_x) - grow, bounds.min_y + (y - last_y) - grow,
+                bounds.max_x + (x - last_x) + grow, bounds.max_y + (y - last_y) + grow);
+            if (mask.all_marked(moved)) {
+                bounds = moved;
+                last_x = x;
+                last_y = y;
+                last_heading = heading;
+                return;
+            }
+        }
+
+        const double c = cos(yaw);
+        const double s = sin(yaw);
+        bounds = Bounds2();
+        for (std::size_t k = 0; k < footprint.size(); ++k) {
+            placed[k].x = x + c * footprint[k].x - s * footprint[k].y;
+            placed[k].y = y + s * footprint[k].x + c * footprint[k].y;
+            bounds.add(placed[k].x, placed[k].y);
+        }
+        last_x = x;
+        last_y = y;
+        last_heading = heading;
+        if (!mask.all_marked(bounds)) {
+            rasterize_polygon(placed, crossings, mask);
+        }
+    };
+
+    // the poses are usually far closer together than the sweep step, so
+    // place the footprint only each time the travel since the last placement
+    // reaches the step, interpolating within a pose pair when it is longer.
+    // $heading follows the yaw without wrapping, to measure turns by.
+    double heading = poses[0].yaw;
+    place(poses[0].x, poses[0].y, poses[0].yaw, heading);
+    double since_placed = 0.0;
+    for (std::size_t i = 1; i < num_poses; ++i) {
+        const Pose2_cont& p0 = poses[i - 1];
+        const Pose2_cont& p1 = poses[i];
+        const double dyaw = shortest_angle_diff(p1.yaw, p0.yaw);
+        const double travel = std::hypot(p1.x - p0.x, p1.y - p0.y) + reach * std::fabs(dyaw);
+        double d = FOOTPRINT_SWEEP_STEP - since_placed;
+        for (; d <= travel; d += FOOTPRINT_SWEEP_STEP) {
+            const double alpha = d / travel;
+            place(p0.x + alpha * (p1.x - p0.x), p0.y + alpha * (p1.y - p0.y), p0.yaw + alpha * dyaw, heading + alpha * dyaw);
+        }
+        since_placed = travel - (d - FOOTPRINT_SWEEP_STEP);
+        heading += dyaw;
+    }
+    if (since_placed > 0.0) {
+        const Pose2_cont& last = poses[num_poses - 1];
+        place(last.x, last.y, last.yaw, heading);
+    }
+
+    const unsigned char* marks = mask.marks.data();
+    for (int i = 0; i < mask.num_columns; ++i) {
+        for (int j = 0; j < mask.num_rows; ++j, ++marks) {
+            if (*marks) {
+                CellOffset c = { mask.min_i + i, mask.min_j + j };
+                cells.push_back(c);
+            }
+        }
+    }
+}
+
+void compute_swept_cells(PrimitiveSet& primitives, const Footprint& footprint, WorkStealingPool& pool)
+{
+    // each chunk sweeps into its own buffer; the buffers are concatenated in
+    // order afterwards so the result does not depend on scheduling
+    const std::size_t chunk_size = 64;
+    const std::size_t num_chunks = (primitives.size() + chunk_size - 1) / chunk_size;
+    std::vector<std::vector<CellOffset>> chunk_cells(num_chunks);
+
+    pool.parallel_for(0, num_chunks, 1, [&](int, std::size_t first, std::size_t last)
+    {
+        std::vector<CellOffset> cells;
+        for (std::size_t c = first; c < last; ++c) {
+            std::vector<CellOffset>& out = chunk_cells[c];
+            const std::size_t end = std::min(primitives.size(), (c + 1) * chunk_size);
+            for (std::size_t i = c * chunk_size; i < end; ++i) {
+                MotionPrimitive& p = primitives.primitives[i];
+                swept_cells(footprint, primitives.poses_of(p), p.num_poses, cells);
+                p.first_cell = out.size();
+                p.num_cells = cells.size();
+                out.insert(out.end(), cells.begin(), cells.end());
+            }
+        }
+    });
+
+    primitives.cells.clear();
+    for (std::size_t c = 0; c < num_chunks; ++c) {
+        const std::size_t offset = primitives.cells.size();
+        const std::size_t end = std::min(primitives.size(), (c + 1) * chunk_size);
+        for (std::size_t i = c * chunk_size; i < end; ++i) {
+            primitives.primitives[i].first_cell += offset;
+        }
+        primitives.cells.insert(primitives.cells.end(), chunk_cells[c].begin(), chunk_cells[c].end());
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef footprint_h
+#define footprint_h
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Pose2.h"
+
+struct PrimitiveSet;
+class WorkStealingPool;
+
+/// A vertex of a robot footprint, in cells in the robot frame
+struct FootprintVertex
+{
+    double x;
+    double y;
+};
+
+/// A simple polygon, in either winding order
+typedef std::vector<FootprintVertex> Footprint;
+
+/// A grid cell relative to the start cell of a primitive. Cell (i, j) covers
+/// [i - 0.5, i + 0.5) x [j - 0.5, j + 0.5), so poses at integer coordinates
+/// sit at cell centers.
+struct CellOffset
+{
+    int32_t dx;
+    int32_t dy;
+};
+
+inline bool operator<(const CellOffset& lhs, const CellOffset& rhs)
+{
+    return lhs.dx != rhs.dx ? lhs.dx < rhs.dx : lhs.dy < rhs.dy;
+}
+
+inline bool operator==(const CellOffset& lhs, const CellOffset& rhs)
+{
+    return lhs.dx == rhs.dx && lhs.dy == rhs.dy;
+}
+
+/// Return the arrow the designer draws for the start and goal poses
+Footprint arrow_footprint();
+
+/// Return whether ($x, $y) lies on the arrow drawn at $pose, the test the
+/// designer uses to pick the start and goals
+bool arrow_contains(const Pose2_cont& pose, double x, double y);
+
+/// Return the bounds of the arrow drawn at $pose
+Bounds2 arrow_bounds(const Pose2_cont& pose);
+
+/// Parse a footprint written as "x1,y1;x2,y2;..." with at least three vertices
+bool parse_footprint(const std::string& text, Footprint& footprint);
+
+/// Largest distance, in cells, that any footprint vertex moves between
+/// consecutive placements when sweeping a primitive
+static const double FOOTPRINT_SWEEP_STEP = 0.1;
+
+/// Replace the contents of $cells with every cell overlapped by $footprint
+/// placed along the path through $poses, sorted and deduplicated. The
+/// footprint is placed at the first and last poses and wherever the travel
+/// since the last placement reaches FOOTPRINT_SWEEP_STEP, between poses if
+/// need be, so no vertex moves further than that between placements.
+/// Cells the footprint boundary only touches count as overlapped, so the
+/// result errs on the side of a collision.
+void swept_cells(
+    const Footprint& footprint,
+    const Pose2_cont* poses,
+    std::size_t num_poses,
+    std::vector<CellOffset>& cells);
+
+/// Compute the swept cells of every primitive in $primitives in parallel,
+/// replacing any computed before
+void compute_swept_cells(PrimitiveSet& primitives, const Footprint& footprint, WorkStealingPool& pool);
+
+#endif
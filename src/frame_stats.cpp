@@ -0,0 +1,165 @@
+#include "frame_stats.h"
+#include <algorithm>
+
+static const char* const FRAME_STAGE_NAMES[NUM_FRAME_STAGES] = { "upload", "coverage", "grid", "curves", "arrows", "other" };
+
+const char* frame_stage_name(FrameStage stage)
+{
+    return FRAME_STAGE_NAMES[stage];
+}
+
+FrameStats::FrameStats() :
+    num_frames(0),
+    frame_ms(0.0),
+    max_frame_ms(0.0),
+    generation_ms(0.0),
+    num_generated(0),
+    latency_ms(0.0),
+    max_latency_ms(0.0),
+    motion_latency_ms(0.0),
+    num_goals(0),
+    num_primitives(0),
+    num_poses(0),
+    num_vertices(0),
+    num_arrows(0)
+{
+    std::fill(stage_ms, stage_ms + NUM_FRAME_STAGES, 0.0);
+}
+
+template <typename Duration>
+static double to_ms(Duration d)
+{
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+FrameStatsRecorder::FrameStatsRecorder() :
+    num_frames_(0),
+    next_frame_(0),
+    num_latencies_(0),
+    next_latency_(0),
+    have_input_(false),
+    have_edit_(false),
+    have_result_(false),
+    generation_ms_(0.0),
+    num_generated_(0),
+    motion_latency_ms_(0.0),
+    result_this_frame_(false)
+{
+}
+
+void FrameStatsRecorder::input()
+{
+    const Clock::time_point now = Clock::now();
+    if (!have_input_) {
+        input_time_ = now;
+        have_input_ = true;
+    }
+    if (!have_edit_) {
+        edit_time_ = now;
+        have_edit_ = true;
+    }
+}
+
+void FrameStatsRecorder::begin_frame()
+{
+    frame_start_ = Clock::now();
+    stage_start_ = frame_start_;
+    frame_.total_ms = 0.0;
+    std::fill(frame_.stage_ms, frame_.stage_ms + NUM_FRAME_STAGES, 0.0);
+    result_this_frame_ = false;
+}
+
+void FrameStatsRecorder::end_stage(FrameStage stage)
+{
+    const Clock::time_point now = Clock::now();
+    frame_.stage_ms[stage] += to_ms(now - stage_start_);
+    stage_start_ = now;
+}
+
+void FrameStatsRecorder::motions_requested(uint64_t version)
+{
+    // a request without input behind it, such as one from the controls,
+    // counts from the repaint that made it
+    requests_.push_back(std::make_pair(version, have_edit_ ? edit_time_ : frame_start_));
+    have_edit_ = false;
+}
+
+void FrameStatsRecorder::motions_received(uint64_t version, double generation_ms, std::size_t num_generated)
+{
+    // the result also answers every request it superseded, so the wait
+    // counts from the oldest of them
+    bool answered = false;
+    Clock::time_point input_time;
+    while (!requests_.empty() && requests_.front().first <= version) {
+        if (!answered) {
+            input_time = requests_.front().second;
+            answered = true;
+        }
+        requests_.pop_front();
+    }
+
+    generation_ms_ = generation_ms;
+    num_generated_ = num_generated;
+    have_result_ = true;
+    if (answered) {
+        result_this_frame_ = true;
+        result_input_time_ = input_time;
+    }
+}
+
+void FrameStatsRecorder::end_frame(FrameStats& stats)
+{
+    end_stage(FRAME_STAGE_OTHER);
+    const Clock::time_point now = stage_start_;
+    frame_.total_ms = to_ms(now - frame_start_);
+
+    frames_[next_frame_] = frame_;
+    next_frame_ = (next_frame_ + 1) % FRAME_STATS_WINDOW;
+    num_frames_ = std::min(num_frames_ + 1, FRAME_STATS_WINDOW);
+
+    if (have_input_) {
+        latencies_[next_latency_] = to_ms(now - input_time_);
+        next_latency_ = (next_latency_ + 1) % FRAME_STATS_WINDOW;
+        num_latencies_ = std::min(num_latencies_ + 1, FRAME_STATS_WINDOW);
+        have_input_ = false;
+    }
+
+    // input that did not lead to a request this frame, such as a pan, never will
+    have_edit_ = false;
+
+    if (result_this_frame_) {
+        motion_latency_ms_ = to_ms(now - result_input_time_);
+    }
+
+    stats.num_frames = num_frames_;
+    stats.frame_ms = 0.0;
+    stats.max_frame_ms = 0.0;
+    std::fill(stats.stage_ms, stats.stage_ms + NUM_FRAME_STAGES, 0.0);
+    for (std::size_t i = 0; i < num_frames_; ++i) {
+        stats.frame_ms += frames_[i].total_ms;
+        stats.max_frame_ms = std::max(stats.max_frame_ms, frames_[i].total_ms);
+        for (int s = 0; s < NUM_FRAME_STAGES; ++s) {
+            stats.stage_ms[s] += frames_[i].stage_ms[s];
+        }
+    }
+    stats.frame_ms /= num_frames_;
+    for (int s = 0; s < NUM_FRAME_STAGES; ++s) {
+        stats.stage_ms[s] /= num_frames_;
+    }
+
+    stats.latency_ms = 0.0;
+    stats.max_latency_ms = 0.0;
+    for (std::size_t i = 0; i < num_latencies_; ++i) {
+        stats.latency_ms += latencies_[i];
+        stats.max_latency_ms = std::max(stats.max_latency_ms, latencies_[i]);
+    }
+    if (num_latencies_ > 0) {
+        stats.latency_ms /= num_latencies_;
+    }
+
+    if (have_result_) {
+        stats.generation_ms = generation_ms_;
+        stats.num_generated = num_generated_;
+        stats.motion_latency_ms = motion_latency_ms_;
+    }
+}
@@ -0,0 +1,128 @@
+#ifndef frame_stats_h
+#define frame_stats_h
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <stdint.h>
+#include <utility>
+
+/// The parts of a designer repaint that are timed separately
+enum FrameStage
+{
+    FRAME_STAGE_UPLOAD,     ///< culling, decimating and uploading the scene
+    FRAME_STAGE_COVERAGE,   ///< computing and shading the reachability overlay
+    FRAME_STAGE_GRID,
+    FRAME_STAGE_CURVES,
+    FRAME_STAGE_ARROWS,
+    FRAME_STAGE_OTHER,      ///< requests, guidelines, the selection and the overlay
+    NUM_FRAME_STAGES
+};
+
+/// Return a short name for $stage
+const char* frame_stage_name(FrameStage stage);
+
+/// Where the time went over the last FRAME_STATS_WINDOW repaints, and the
+/// size of the scene drawn. Times are in milliseconds.
+struct FrameStats
+{
+    FrameStats();
+
+    std::size_t num_frames;     ///< repaints averaged, up to FRAME_STATS_WINDOW
+
+    double frame_ms;            ///< mean repaint, on the GUI thread
+    double max_frame_ms;
+    double stage_ms[NUM_FRAME_STAGES];  ///< mean per repaint
+
+    /// Time the worker spent generating the motions drawn, off the GUI
+    /// thread, and how many of them were not cached
+    double generation_ms;
+    std::size_t num_generated;
+
+    /// Mean and worst time from an input event to the end of the repaint
+    /// that showed it
+    double latency_ms;
+    double max_latency_ms;
+
+    /// Time from the input event that led to the motions drawn to the end of
+    /// the repaint that first drew them
+    double motion_latency_ms;
+
+    std::size_t num_goals;
+    std::size_t num_primitives; ///< goals with a motion
+    std::size_t num_poses;      ///< along the motions
+    std::size_t num_vertices;   ///< of the curves drawn, after culling and decimation
+    std::size_t num_arrows;     ///< drawn
+};
+
+/// Repaints averaged by a FrameStatsRecorder
+static const std::size_t FRAME_STATS_WINDOW = 60;
+
+/// Times repaints stage by stage and keeps rolling averages of the times and
+/// of the latency from input to repaint. Cheap enough to run on every repaint.
+class FrameStatsRecorder
+{
+public:
+
+    FrameStatsRecorder();
+
+    /// Note an input event now; the latency is measured from the earliest
+    /// event not yet shown
+    void input();
+
+    void begin_frame();
+
+    /// Charge the time since the frame began or since the last stage ended to $stage
+    void end_stage(FrameStage stage);
+
+    /// Note that the frame submitted motion request $version, which answers
+    /// the input noted since the last request
+    void motions_requested(uint64_t version);
+
+    /// Note that the frame draws the result of motion request $version for
+    /// the first time; the worker took $generation_ms and generated $num_generated motions
+    void motions_received(uint64_t version, double generation_ms, std::size_t num_generated);
+
+    /// Charge what is left of the frame to FRAME_STAGE_OTHER and update the
+    /// times in $stats; its counts are left to the caller
+    void end_frame(FrameStats& stats);
+
+private:
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Frame
+    {
+        double total_ms;
+        double stage_ms[NUM_FRAME_STAGES];
+    };
+
+    Frame frames_[FRAME_STATS_WINDOW];
+    std::size_t num_frames_;
+    std::size_t next_frame_;
+
+    double latencies_[FRAME_STATS_WINDOW];
+    std::size_t num_latencies_;
+    std::size_t next_latency_;
+
+    Frame frame_;
+    Clock::time_point frame_start_;
+    Clock::time_point stage_start_;
+
+    bool have_input_;
+    Clock::time_point input_time_;      ///< of the earliest input not yet shown
+    bool have_edit_;
+    Clock::time_point edit_time_;       ///< of the earliest input not yet in a motion request
+
+    /// Requests not yet answered and the input each answers
+    std::deque<std::pair<uint64_t, Clock::time_point>> requests_;
+
+    bool have_result_;
+    double generation_ms_;
+    std::size_t num_generated_;
+    double motion_latency_ms_;
+    bool result_this_frame_;
+    Clock::time_point result_input_time_;
+};
+
+#endif
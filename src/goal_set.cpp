@@ -0,0 +1,70 @@
+#include "goal_set.h"
+
+GoalSet::GoalSet() :
+    free_slot_(NO_SLOT)
+{
+}
+
+GoalHandle GoalSet::insert(const Pose2_cont& pose)
+{
+    uint32_t slot;
+    if (free_slot_ != NO_SLOT) {
+        slot = free_slot_;
+        free_slot_ = slots_[slot].index;
+    }
+    else {
+        slot = (uint32_t)slots_.size();
+        Slot s = { 0, 1 };
+        slots_.push_back(s);
+    }
+
+    slots_[slot].index = (uint32_t)poses_.size();
+    poses_.push_back(pose);
+    slot_of_.push_back(slot);
+    return GoalHandle(slot, slots_[slot].generation);
+}
+
+bool GoalSet::erase(GoalHandle handle)
+{
+    if (!contains(handle)) {
+        return false;
+    }
+
+    // move the last goal into the hole
+    const uint32_t i = slots_[handle.slot].index;
+    const uint32_t last = (uint32_t)poses_.size() - 1;
+    if (i != last) {
+        poses_.x[i] = poses_.x[last];
+        poses_.y[i] = poses_.y[last];
+        poses_.yaw[i] = poses_.yaw[last];
+        slot_of_[i] = slot_of_[last];
+        slots_[slot_of_[i]].index = i;
+    }
+    poses_.x.pop_back();
+    poses_.y.pop_back();
+    poses_.yaw.pop_back();
+    slot_of_.pop_back();
+
+    Slot& slot = slots_[handle.slot];
+    if (++slot.generation == 0) {
+        slot.generation = 1;
+    }
+    slot.index = free_slot_;
+    free_slot_ = handle.slot;
+    return true;
+}
+
+void GoalSet::clear()
+{
+    while (!slot_of_.empty()) {
+        erase(handle(slot_of_.size() - 1));
+    }
+}
+
+void GoalSet::set_pose(GoalHandle handle, const Pose2_cont& pose)
+{
+    const std::size_t i = index(handle);
+    poses_.x[i] = pose.x;
+    poses_.y[i] = pose.y;
+    poses_.yaw[i] = pose.yaw;
+}
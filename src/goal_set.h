@@ -0,0 +1,124 @@
+#ifndef goal_set_h
+#define goal_set_h
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+#include "Pose2.h"
+#include "unicycle_motions.h"
+
+/// A reference to a goal in a GoalSet that stays valid while other goals are
+/// added and removed. Slots are reused, so each carries a generation that
+/// tells a handle to a removed goal from one to the goal now in its slot.
+struct GoalHandle
+{
+    GoalHandle() : slot(0), generation(0) { }
+    GoalHandle(uint32_t slot, uint32_t generation) : slot(slot), generation(generation) { }
+
+    uint32_t slot;
+    uint32_t generation;    ///< 0 for the null handle
+
+    bool null() const { return generation == 0; }
+
+    bool operator==(const GoalHandle& rhs) const { return slot == rhs.slot && generation == rhs.generation; }
+    bool operator!=(const GoalHandle& rhs) const { return !(*this == rhs); }
+};
+
+/// Goal poses in contiguous struct-of-arrays storage, addressed by stable
+/// handles. Adding and removing a goal is O(1): a removed goal's place in the
+/// arrays is taken by the last goal, so the goals stay packed and in no
+/// particular order, and poses() can be handed straight to the batch solvers.
+///
+/// Slot numbers are small and reused, which makes them suitable as ids in
+/// side tables such as a SpatialIndex.
+class GoalSet
+{
+public:
+
+    /// Iterates the goals in storage order
+    class const_iterator
+    {
+    public:
+
+        const_iterator(const GoalSet* goals, std::size_t i) : goals_(goals), i_(i) { }
+
+        Pose2_cont operator*() const { return (*goals_)[i_]; }
+        const_iterator& operator++() { ++i_; return *this; }
+
+        bool operator==(const const_iterator& rhs) const { return i_ == rhs.i_; }
+        bool operator!=(const const_iterator& rhs) const { return i_ != rhs.i_; }
+
+    private:
+
+        const GoalSet* goals_;
+        std::size_t i_;
+    };
+
+    GoalSet();
+
+    /// Add a goal at $pose and return its handle
+    GoalHandle insert(const Pose2_cont& pose);
+
+    /// Remove the goal $handle refers to. Return false if there is none.
+    bool erase(GoalHandle handle);
+
+    /// Remove every goal; every handle becomes stale
+    void clear();
+
+    /// Return whether $handle refers to a goal in the set
+    bool contains(GoalHandle handle) const
+    {
+        return handle.slot < slots_.size() && slots_[handle.slot].generation == handle.generation && !handle.null();
+    }
+
+    /// Return the pose of the goal $handle, which must be in the set, refers to
+    Pose2_cont pose(GoalHandle handle) const { return (*this)[index(handle)]; }
+    void set_pose(GoalHandle handle, const Pose2_cont& pose);
+
+    std::size_t size() const { return poses_.size(); }
+    bool empty() const { return poses_.size() == 0; }
+
+    /// Return one more than the largest slot number in use
+    std::size_t num_slots() const { return slots_.size(); }
+
+    /// Return the storage position of the goal $handle, which must be in the
+    /// set, refers to. Positions change when goals are removed.
+    std::size_t index(GoalHandle handle) const { return slots_[handle.slot].index; }
+
+    /// Return the handle of the goal at storage position $i
+    GoalHandle handle(std::size_t i) const
+    {
+        const uint32_t slot = slot_of_[i];
+        return GoalHandle(slot, slots_[slot].generation);
+    }
+
+    /// Return the handle of the goal in $slot, which must be in use
+    GoalHandle slot_handle(uint32_t slot) const { return GoalHandle(slot, slots_[slot].generation); }
+
+    Pose2_cont operator[](std::size_t i) const { return poses_[i]; }
+
+    /// The poses in storage order
+    const Pose2Array& poses() const { return poses_; }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+private:
+
+    /// A goal's storage position while the slot is in use, and the next free
+    /// slot while it is not
+    struct Slot
+    {
+        uint32_t index;
+        uint32_t generation;
+    };
+
+    static const uint32_t NO_SLOT = 0xFFFFFFFF;
+
+    Pose2Array poses_;
+    std::vector<uint32_t> slot_of_;     ///< by storage position
+    std::vector<Slot> slots_;
+    uint32_t free_slot_;
+};
+
+#endif
@@ -0,0 +1,300 @@
+#include "heuristic_table.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "primitive_library.h"
+#include "work_stealing_pool.h"
+
+/// Smallest cost per cell of length of any primitive: each covers at least one
+/// cell and primitive_cost() rounds its length to the nearest unit
+static const double MIN_COST_PER_CELL = PRIMITIVE_COST_SCALE - 0.5;
+
+static const uint32_t UNREACHED = std::numeric_limits<uint32_t>::max();
+
+/// Per-worker search storage, kept between searches
+struct DijkstraScratch
+{
+    std::vector<uint32_t> cost;     ///< indexed by search_index()
+    std::vector<uint64_t> open;     ///< cost << 32 | state index
+};
+
+static inline std::size_t search_index(int half_width, int x, int y, int angle)
+{
+    const std::size_t width = 2 * half_width + 1;
+    return ((std::size_t)angle * width + (y + half_width)) * width + (x + half_width);
+}
+
+/// Fill $scratch.cost with the cost of the cheapest path over $edges from
+/// (0, 0, $source_angle) to every state within $half_width cells, for costs up
+/// to $max_cost, leaving the rest UNREACHED. Return the number of states expanded.
+static std::size_t lattice_dijkstra(
+    const LatticeEdges& edges,
+    int source_angle,
+    int half_width,
+    uint32_t max_cost,
+    DijkstraScratch& scratch)
+{
+    const int num_angles = (int)edges.size();
+    const std::size_t width = 2 * half_width + 1;
+    std::vector<uint32_t>& cost = scratch.cost;
+    std::vector<uint64_t>& open = scratch.open;
+    cost.assign(num_angles * width * width, UNREACHED);
+    open.clear();
+
+    const std::greater<uint64_t> cmp;
+    const std::size_t source = search_index(half_width, 0, 0, source_angle);
+    cost[source] = 0;
+    open.push_back(source);
+
+    std::size_t num_expanded = 0;
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), cmp);
+        const uint64_t top = open.back();
+        open.pop_back();
+
+        const uint32_t g = (uint32_t)(top >> 32);
+        const std::size_t index = (std::size_t)(top & 0xFFFFFFFF);
+        if (g > cost[index]) {
+            continue;   // stale entry
+        }
+        ++num_expanded;
+
+        const int angle = (int)(index / (width * width));
+        const int y = (int)((index / width) % width) - half_width;
+        const int x = (int)(index % width) - half_width;
+        for (const LatticeEdge& e : edges[angle]) {
+            const int sx = x + e.dx;
+            const int sy = y + e.dy;
+            if (sx < -half_width || sx > half_width || sy < -half_width || sy > half_width) {
+                continue;
+            }
+            const uint64_t sg = (uint64_t)g + e.cost;
+            if (sg > max_cost) {
+                continue;
+            }
+            const std::size_t s = search_index(half_width, sx, sy, e.end_angle);
+            if (sg < cost[s]) {
+                cost[s] = (uint32_t)sg;
+                open.push_back((sg << 32) | s);
+                std::push_heap(open.begin(), open.end(), cmp);
+            }
+        }
+    }
+    return num_expanded;
+}
+
+/// Return the largest cost that every search confined to $half_width cells finds exactly
+static uint32_t exact_cost_bound(int half_width)
+{
+    return (uint32_t)std::floor(half_width * MIN_COST_PER_CELL);
+}
+
+static int search_half_width(const HeuristicTableParams& params)
+{
+    return params.radius + (params.margin < 0 ? params.radius : params.margin);
+}
+
+void build_heuristic_table(
+    const LatticeEdges& edges,
+    const HeuristicTableParams& params,
+    WorkStealingPool& pool,
+    std::vector<uint32_t>& costs,
+    uint32_t& max_cost,
+    HeuristicTableReport& report)
+{
+    const int num_angles = (int)edges.size();
+    const int radius = params.radius;
+    const int half_width = search_half_width(params);
+    max_cost = exact_cost_bound(half_width);
+
+    // searching the reversed graph from a goal finds the paths into it
+    LatticeEdges reversed;
+    reverse_lattice_edges(edges, reversed);
+
+    const std::size_t width = 2 * radius + 1;
+    costs.assign((std::size_t)num_angles * num_angles * width * width, max_cost);
+
+    std::vector<DijkstraScratch> scratch(pool.num_threads());
+    std::vector<std::size_t> expansions(pool.num_threads(), 0);
+    std::vector<std::size_t> exact(pool.num_threads(), 0);
+
+    pool.parallel_for(0, num_angles, 1, [&](int worker, std::size_t first, std::size_t last)
+    {
+        DijkstraScratch& s = scratch[worker];
+        for (std::size_t goal_angle = first; goal_angle < last; ++goal_angle) {
+            expansions[worker] += lattice_dijkstra(reversed, (int)goal_angle, half_width, max_cost, s);
+            for (int angle = 0; angle < num_angles; ++angle) {
+                for (int dy = -radius; dy <= radius; ++dy) {
+                    for (int dx = -radius; dx <= radius; ++dx) {
+                        const uint32_t c = s.cost[search_index(half_width, dx, dy, angle)];
+                        if (c != UNREACHED) {
+                            costs[heuristic_table_index(num_angles, radius, dx, dy, angle, (int)goal_angle)] = c;
+                            ++exact[worker];
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    report.num_expansions = 0;
+    report.num_exact = 0;
+    for (int w = 0; w < pool.num_threads(); ++w) {
+        report.num_expansions += expansions[w];
+        report.num_exact += exact[w];
+    }
+    report.num_saturated = costs.size() - report.num_exact;
+}
+
+bool write_heuristic_table(
+    const std::string& path,
+    int num_angles,
+    int radius,
+    uint32_t max_cost,
+    const std::vector<uint32_t>& costs)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+
+    HeuristicTableHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, HEURISTIC_TABLE_MAGIC, sizeof(header.magic));
+    header.version = HEURISTIC_TABLE_VERSION;
+    header.num_angles = (uint32_t)num_angles;
+    header.radius = (uint32_t)radius;
+    header.max_cost = max_cost;
+    header.num_entries = costs.size();
+    header.costs_offset = sizeof(HeuristicTableHeader);
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && !costs.empty()) {
+        ok = fwrite(costs.data(), sizeof(uint32_t), costs.size(), file) == costs.size();
+    }
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    return ok;
+}
+
+HeuristicTable::HeuristicTable() :
+    data_(0),
+    size_(0),
+    header_(0),
+    costs_(0)
+{
+}
+
+HeuristicTable::~HeuristicTable()
+{
+    close();
+}
+
+bool HeuristicTable::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (std::size_t)st.st_size < sizeof(HeuristicTableHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    data_ = data;
+    size_ = st.st_size;
+    header_ = (const HeuristicTableHeader*)data_;
+
+    const uint64_t width = 2 * (uint64_t)header_->radius + 1;
+    if (memcmp(header_->magic, HEURISTIC_TABLE_MAGIC, sizeof(header_->magic)) != 0 ||
+        header_->version != HEURISTIC_TABLE_VERSION ||
+        header_->num_entries != (uint64_t)header_->num_angles * header_->num_angles * width * width ||
+        header_->costs_offset % 8 != 0 ||
+        header_->costs_offset > size_ ||
+        header_->num_entries > (size_ - header_->costs_offset) / sizeof(uint32_t))
+    {
+        close();
+        return false;
+    }
+
+    costs_ = (const uint32_t*)((const char*)data_ + header_->costs_offset);
+    return true;
+}
+
+void HeuristicTable::close()
+{
+    if (data_) {
+        munmap(data_, size_);
+    }
+    data_ = 0;
+    size_ = 0;
+    header_ = 0;
+    costs_ = 0;
+}
+
+uint32_t HeuristicTable::distance_bound(int dx, int dy)
+{
+    return (uint32_t)std::floor(MIN_COST_PER_CELL * std::sqrt((double)dx * dx + (double)dy * dy));
+}
+
+std::size_t verify_heuristic_table(
+    const LatticeEdges& edges,
+    const HeuristicTable& table,
+    const HeuristicTableParams& params,
+    WorkStealingPool& pool)
+{
+    const int num_angles = table.num_angles();
+    const int radius = table.radius();
+    const int half_width = search_half_width(params);
+    const uint32_t max_cost = exact_cost_bound(half_width);
+    if ((int)edges.size() != num_angles || max_cost != table.max_cost()) {
+        return (std::size_t)num_angles * num_angles * (2 * radius + 1) * (2 * radius + 1);
+    }
+
+    std::vector<DijkstraScratch> scratch(pool.num_threads());
+    std::vector<std::size_t> mismatches(pool.num_threads(), 0);
+
+    // by translation, the path from (0, 0, a) to (x, y, b) is the one from
+    // (-x, -y, a) to a goal at the origin with heading b
+    pool.parallel_for(0, num_angles, 1, [&](int worker, std::size_t first, std::size_t last)
+    {
+        DijkstraScratch& s = scratch[worker];
+        for (std::size_t angle = first; angle < last; ++angle) {
+            lattice_dijkstra(edges, (int)angle, half_width, max_cost, s);
+            for (int goal_angle = 0; goal_angle < num_angles; ++goal_angle) {
+                for (int y = -radius; y <= radius; ++y) {
+                    for (int x = -radius; x <= radius; ++x) {
+                        const uint32_t c = std::min(s.cost[search_index(half_width, x, y, goal_angle)], max_cost);
+                        if (table.entry(-x, -y, (int)angle, goal_angle) != c) {
+                            ++mismatches[worker];
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    std::size_t total = 0;
+    for (int w = 0; w < pool.num_threads(); ++w) {
+        total += mismatches[w];
+    }
+    return total;
+}
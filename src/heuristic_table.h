@@ -0,0 +1,151 @@
+#ifndef heuristic_table_h
+#define heuristic_table_h
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "lattice_graph.h"
+
+class WorkStealingPool;
+
+/// On-disk layout of a heuristic lookup table, native endian:
+///
+///     HeuristicTableHeader
+///     uint32_t    costs[num_angles][num_angles][2 * radius + 1][2 * radius + 1]
+///
+/// indexed by goal heading, state heading, and then the state's offset from
+/// the goal in y and x.
+struct HeuristicTableHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t num_angles;
+    uint32_t radius;
+    uint32_t max_cost;      ///< costs are exact up to here and saturate at it
+    uint64_t num_entries;
+    uint64_t costs_offset;
+};
+
+static const char HEURISTIC_TABLE_MAGIC[8] = { 'M', 'P', 'R', 'I', 'M', 'H', 'E', 'U' };
+static const uint32_t HEURISTIC_TABLE_VERSION = 1;
+
+/// Bounds on the searches that fill a heuristic table
+struct HeuristicTableParams
+{
+    HeuristicTableParams() : radius(32), margin(-1) { }
+
+    int radius;     ///< cover goal offsets in [-radius, radius] cells in x and y
+    int margin;     ///< search this many cells past the radius, or the radius again if negative
+};
+
+/// Outcome of build_heuristic_table
+struct HeuristicTableReport
+{
+    std::size_t num_expansions;
+    std::size_t num_exact;      ///< entries holding the exact cost-to-go
+    std::size_t num_saturated;  ///< entries whose cost-to-go exceeds max_cost, or is infinite
+};
+
+/// Return the offset of the entry for a state at ($dx, $dy) from the goal with
+/// heading $angle, for a goal with heading $goal_angle
+inline std::size_t heuristic_table_index(int num_angles, int radius, int dx, int dy, int angle, int goal_angle)
+{
+    const std::size_t width = 2 * radius + 1;
+    return (((std::size_t)goal_angle * num_angles + angle) * width + (dy + radius)) * width + (dx + radius);
+}
+
+/// Fill $costs with the cost of the cheapest path over $edges from every
+/// state within $params.radius of a goal to that goal, for every pair of
+/// state and goal headings, by one backward Dijkstra search per goal heading
+/// run in parallel over the free lattice.
+///
+/// Searches are confined to $params.radius + $params.margin cells of the
+/// goal. Every primitive covers at least one cell and its rounded cost is at
+/// least (PRIMITIVE_COST_SCALE - 0.5) per cell of length, so any path no
+/// dearer than $max_cost stays within that box and its cost is exact. Dearer
+/// entries are stored as $max_cost, which keeps the table admissible and
+/// consistent.
+void build_heuristic_table(
+    const LatticeEdges& edges,
+    const HeuristicTableParams& params,
+    WorkStealingPool& pool,
+    std::vector<uint32_t>& costs,
+    uint32_t& max_cost,
+    HeuristicTableReport& report);
+
+/// Write a table built by build_heuristic_table
+bool write_heuristic_table(
+    const std::string& path,
+    int num_angles,
+    int radius,
+    uint32_t max_cost,
+    const std::vector<uint32_t>& costs);
+
+/// Read-only view of a memory-mapped heuristic table
+class HeuristicTable
+{
+public:
+
+    HeuristicTable();
+    ~HeuristicTable();
+
+    bool open(const std::string& path);
+    void close();
+
+    bool is_open() const { return data_ != 0; }
+
+    int num_angles() const { return (int)header_->num_angles; }
+    int radius() const { return (int)header_->radius; }
+    uint32_t max_cost() const { return header_->max_cost; }
+
+    bool contains(int dx, int dy) const
+    {
+        return dx >= -radius() && dx <= radius() && dy >= -radius() && dy <= radius();
+    }
+
+    /// Return the stored cost from a state at ($dx, $dy), which must lie
+    /// within the radius, with heading $angle to a goal with heading $goal_angle
+    uint32_t entry(int dx, int dy, int angle, int goal_angle) const
+    {
+        return costs_[heuristic_table_index(num_angles(), radius(), dx, dy, angle, goal_angle)];
+    }
+
+    /// Return a lower bound on the cost from a state at ($dx, $dy) from the
+    /// goal with heading $angle to a goal with heading $goal_angle: the larger
+    /// of the table entry and distance_bound() within the radius, and the
+    /// latter alone beyond it. It is consistent between states within the radius.
+    uint32_t cost(int dx, int dy, int angle, int goal_angle) const
+    {
+        const uint32_t bound = distance_bound(dx, dy);
+        if (!contains(dx, dy)) {
+            return bound;
+        }
+        const uint32_t stored = entry(dx, dy, angle, goal_angle);
+        return stored > bound ? stored : bound;
+    }
+
+    /// Return a lower bound on the cost of any path covering ($dx, $dy)
+    static uint32_t distance_bound(int dx, int dy);
+
+private:
+
+    void* data_;
+    std::size_t size_;
+
+    const HeuristicTableHeader* header_;
+    const uint32_t* costs_;
+
+    HeuristicTable(const HeuristicTable&);
+    HeuristicTable& operator=(const HeuristicTable&);
+};
+
+/// Check $table against forward Dijkstra searches over $edges from every
+/// start heading, and return the number of entries that differ
+std::size_t verify_heuristic_table(
+    const LatticeEdges& edges,
+    const HeuristicTable& table,
+    const HeuristicTableParams& params,
+    WorkStealingPool& pool);
+
+#endif
@@ -0,0 +1,35 @@
+#include "lattice_graph.h"
+#include "lattice_primitives.h"
+#include "primitive_library.h"
+
+void lattice_edges(const PrimitiveSet& primitives, int num_angles, LatticeEdges& edges)
+{
+    edges.assign(num_angles, std::vector<LatticeEdge>());
+    for (const MotionPrimitive& p : primitives.primitives) {
+        LatticeEdge e = { p.end.x, p.end.y, p.end.yaw, primitive_cost(primitives.poses_of(p), p.num_poses) };
+        edges[p.start_angle].push_back(e);
+    }
+}
+
+void lattice_edges(const PrimitiveLibrary& library, LatticeEdges& edges)
+{
+    edges.assign(library.num_angles(), std::vector<LatticeEdge>());
+    for (int a = 0; a < library.num_angles(); ++a) {
+        const PrimitiveRecord* records = library.primitives(a);
+        for (std::size_t i = 0; i < library.num_primitives(a); ++i) {
+            LatticeEdge e = { records[i].dx, records[i].dy, records[i].end_angle, records[i].cost };
+            edges[a].push_back(e);
+        }
+    }
+}
+
+void reverse_lattice_edges(const LatticeEdges& edges, LatticeEdges& reversed)
+{
+    reversed.assign(edges.size(), std::vector<LatticeEdge>());
+    for (std::size_t a = 0; a < edges.size(); ++a) {
+        for (const LatticeEdge& e : edges[a]) {
+            LatticeEdge r = { -e.dx, -e.dy, (int)a, e.cost };
+            reversed[e.end_angle].push_back(r);
+        }
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef lattice_graph_h
+#define lattice_graph_h
+
+#include <stdint.h>
+#include <vector>
+
+struct PrimitiveSet;
+class PrimitiveLibrary;
+
+/// A primitive as an edge of the translation-invariant lattice graph
+struct LatticeEdge
+{
+    int dx;
+    int dy;
+    int end_angle;
+    int32_t cost;   ///< primitive_cost() of the primitive
+};
+
+/// Outgoing edges indexed by start heading
+typedef std::vector<std::vector<LatticeEdge>> LatticeEdges;
+
+/// Replace the contents of $edges with one edge per primitive in $primitives
+void lattice_edges(const PrimitiveSet& primitives, int num_angles, LatticeEdges& edges);
+
+/// Replace the contents of $edges with one edge per primitive in $library
+void lattice_edges(const PrimitiveLibrary& library, LatticeEdges& edges);
+
+/// Replace the contents of $reversed with every edge of $edges pointing the
+/// other way, so that searching it from a state finds paths into that state
+void reverse_lattice_edges(const LatticeEdges& edges, LatticeEdges& reversed);
+
+#endif
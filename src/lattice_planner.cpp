@@ -0,0 +1,168 @@
+#include "lattice_planner.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include "heuristic_table.h"
+#include "occupancy_grid.h"
+#include "primitive_library.h"
+
+static const uint32_t UNREACHED = std::numeric_limits<uint32_t>::max();
+
+LatticePlanner::LatticePlanner(const PrimitiveLibrary& library, const HeuristicTable* heuristic) :
+    num_angles_(library.num_angles()),
+    edges_(library.num_angles()),
+    heuristic_(heuristic && heuristic->num_angles() == library.num_angles() ? heuristic : 0)
+{
+    std::vector<CellOffset> pose_cells;
+    for (int a = 0; a < num_angles_; ++a) {
+        const PrimitiveRecord* records = library.primitives(a);
+        for (std::size_t i = 0; i < library.num_primitives(a); ++i) {
+            const PrimitiveRecord& r = records[i];
+            Edge e;
+            e.dx = r.dx;
+            e.dy = r.dy;
+            e.end_angle = r.end_angle;
+            e.cost = r.cost;
+            e.first_cell = cells_.size();
+            if (r.num_cells > 0) {
+                const CellOffset* cells = library.cells(r);
+                cells_.insert(cells_.end(), cells, cells + r.num_cells);
+            }
+            else {
+                pose_cells.clear();
+                const Pose2_cont* poses = library.poses(r);
+                for (uint32_t k = 0; k < r.num_poses; ++k) {
+                    CellOffset c = { (int32_t)std::floor(poses[k].x + 0.5), (int32_t)std::floor(poses[k].y + 0.5) };
+                    pose_cells.push_back(c);
+                }
+                std::sort(pose_cells.begin(), pose_cells.end());
+                pose_cells.erase(std::unique(pose_cells.begin(), pose_cells.end()), pose_cells.end());
+                cells_.insert(cells_.end(), pose_cells.begin(), pose_cells.end());
+            }
+            e.num_cells = cells_.size() - e.first_cell;
+            edges_[a].push_back(e);
+        }
+    }
+}
+
+uint32_t LatticePlanner::heuristic(int x, int y, int angle, const Pose2_disc& goal) const
+{
+    if (heuristic_) {
+        return heuristic_->cost(x - goal.x, y - goal.y, angle, goal.yaw);
+    }
+    return HeuristicTable::distance_bound(x - goal.x, y - goal.y);
+}
+
+bool LatticePlanner::edge_free(const OccupancyGrid& grid, int x, int y, const Edge& edge) const
+{
+    const CellOffset* cells = cells_.data() + edge.first_cell;
+    for (std::size_t i = 0; i < edge.num_cells; ++i) {
+        if (grid.occupied(x + cells[i].dx, y + cells[i].dy)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LatticePlanner::plan(
+    const OccupancyGrid& grid,
+    const Pose2_disc& start,
+    const Pose2_disc& goal,
+    const PlannerParams& params,
+    PlanResult& result)
+{
+    result.success = false;
+    result.cost = -1;
+    result.num_expansions = 0;
+    result.path.clear();
+
+    if (grid.occupied(start.x, start.y) || grid.occupied(goal.x, goal.y) ||
+        start.yaw < 0 || start.yaw >= num_angles_ || goal.yaw < 0 || goal.yaw >= num_angles_)
+    {
+        return false;
+    }
+
+    const std::size_t plane = (std::size_t)grid.width * grid.height;
+    const std::size_t num_states = plane * num_angles_;
+    if (num_states > UNREACHED) {
+        return false;   // state indices must fit beside f in an open list entry
+    }
+    g_.assign(num_states, UNREACHED);
+    parent_.resize(num_states);
+    closed_.assign(num_states, 0);
+    open_.clear();
+
+    auto index_of = [&](int x, int y, int angle) { return (std::size_t)angle * plane + (std::size_t)y * grid.width + x; };
+
+    // open list entries pack f above the state index, so the heap orders by f
+    const std::greater<uint64_t> cmp;
+    const std::size_t start_index = index_of(start.x, start.y, start.yaw);
+    const std::size_t goal_index = index_of(goal.x, goal.y, goal.yaw);
+    g_[start_index] = 0;
+    parent_[start_index] = (uint32_t)start_index;
+    open_.push_back(((uint64_t)heuristic(start.x, start.y, start.yaw, goal) << 32) | start_index);
+
+    while (!open_.empty()) {
+        std::pop_heap(open_.begin(), open_.end(), cmp);
+        const std::size_t index = (std::size_t)(open_.back() & 0xFFFFFFFF);
+        open_.pop_back();
+
+        if (closed_[index]) {
+            continue;   // stale entry
+        }
+        closed_[index] = 1;
+
+        if (index == goal_index) {
+            result.success = true;
+            break;
+        }
+        if (++result.num_expansions > params.max_expansions) {
+            break;
+        }
+
+        const int angle = (int)(index / plane);
+        const int y = (int)((index % plane) / grid.width);
+        const int x = (int)(index % grid.width);
+        const uint32_t g = g_[index];
+        for (const Edge& e : edges_[angle]) {
+            const int sx = x + e.dx;
+            const int sy = y + e.dy;
+            if (!grid.in_bounds(sx, sy)) {
+                continue;
+            }
+            const std::size_t s = index_of(sx, sy, e.end_angle);
+            // costs must stay below UNREACHED to fit g_, so a state costlier
+            // than that is never reached
+            const uint64_t sg = (uint64_t)g + e.cost;
+            if (sg >= UNREACHED || sg >= g_[s] || !edge_free(grid, x, y, e)) {
+                continue;
+            }
+            // the table heuristic is only consistent within its radius, so
+            // a closed state may still be reached more cheaply
+            closed_[s] = 0;
+            g_[s] = (uint32_t)sg;
+            parent_[s] = (uint32_t)index;
+            // f saturates rather than spill into the state index; states
+            // that far away only lose their order among themselves
+            const uint64_t f = std::min<uint64_t>(sg + heuristic(sx, sy, e.end_angle, goal), UNREACHED);
+            open_.push_back((f << 32) | s);
+            std::push_heap(open_.begin(), open_.end(), cmp);
+        }
+    }
+
+    if (!result.success) {
+        return false;
+    }
+
+    result.cost = g_[goal_index];
+    for (std::size_t index = goal_index; ; index = parent_[index]) {
+        result.path.push_back(Pose2_disc(
+                (int)(index % grid.width), (int)((index % plane) / grid.width), (int)(index / plane)));
+        if (index == start_index) {
+            break;
+        }
+    }
+    std::reverse(result.path.begin(), result.path.end());
+    return true;
+}
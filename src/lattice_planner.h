@@ -0,0 +1,82 @@
+#ifndef lattice_planner_h
+#define lattice_planner_h
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+#include "footprint.h"
+#include "Pose2.h"
+
+class HeuristicTable;
+class PrimitiveLibrary;
+struct OccupancyGrid;
+
+/// Bounds on a single search
+struct PlannerParams
+{
+    PlannerParams() : max_expansions(10000000) { }
+
+    std::size_t max_expansions;     ///< give up after expanding this many states
+};
+
+/// Outcome of LatticePlanner::plan
+struct PlanResult
+{
+    bool success;
+    int64_t cost;                   ///< sum of primitive costs, or -1 on failure
+    std::size_t num_expansions;
+    std::vector<Pose2_disc> path;   ///< lattice states from the start to the goal
+};
+
+/// A* over the (x, y, discrete heading) lattice of an occupancy grid, with
+/// the primitives of a library as edges. A primitive may be applied at a
+/// state if every cell it sweeps is free; libraries without swept cells fall
+/// back to the cells holding their intermediate poses. Search storage is
+/// kept between plans on grids of the same size.
+class LatticePlanner
+{
+public:
+
+    /// Plan with the primitives in $library, and with costs-to-go from
+    /// $heuristic if it is not null, or a straight-line bound otherwise.
+    /// Both are copied from, so neither needs to outlive the planner, except
+    /// that $heuristic is consulted during every plan.
+    LatticePlanner(const PrimitiveLibrary& library, const HeuristicTable* heuristic = 0);
+
+    int num_angles() const { return num_angles_; }
+
+    /// Search $grid from $start to $goal
+    bool plan(
+        const OccupancyGrid& grid,
+        const Pose2_disc& start,
+        const Pose2_disc& goal,
+        const PlannerParams& params,
+        PlanResult& result);
+
+private:
+
+    struct Edge
+    {
+        int dx;
+        int dy;
+        int end_angle;
+        int32_t cost;
+        std::size_t first_cell;
+        std::size_t num_cells;
+    };
+
+    int num_angles_;
+    std::vector<std::vector<Edge>> edges_;  ///< indexed by start heading
+    std::vector<CellOffset> cells_;
+    const HeuristicTable* heuristic_;
+
+    std::vector<uint32_t> g_;
+    std::vector<uint32_t> parent_;
+    std::vector<uint8_t> closed_;
+    std::vector<uint64_t> open_;
+
+    uint32_t heuristic(int x, int y, int angle, const Pose2_disc& goal) const;
+    bool edge_free(const OccupancyGrid& grid, int x, int y, const Edge& edge) const;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "lattice_primitives.h"
+#include <algorithm>
+#include <cmath>
+
+void PrimitiveSet::append(const PrimitiveSet& other)
+{
+    const std::size_t pose_offset = poses.size();
+    const std::size_t cell_offset = cells.size();
+    poses.insert(poses.end(), other.poses.begin(), other.poses.end());
+    cells.insert(cells.end(), other.cells.begin(), other.cells.end());
+    for (const MotionPrimitive& primitive : other.primitives) {
+        primitives.push_back(primitive);
+        primitives.back().first_pose += pose_offset;
+        primitives.back().first_cell += cell_offset;
+    }
+}
+
+std::size_t num_lattice_goals(const LatticeParams& params)
+{
+    const std::size_t width = 2 * params.extent + 1;
+    return width * width * params.num_angles;
+}
+
+bool within_radius_bounds(const LatticeParams& params, double radius)
+{
+    if (radius == 0.0) {
+        // straight-line motions never turn
+        return true;
+    }
+    radius = fabs(radius);
+    return radius >= params.min_radius && radius <= params.max_radius;
+}
+
+PrimitiveSet generate_lattice_primitives(
+    const LatticeParams& params,
+    const std::vector<int>& start_angles,
+    WorkStealingPool& pool)
+{
+    UnicycleGenerator generator;
+    LatticeWorkspace<UnicycleGenerator> workspace;
+    PrimitiveSet primitives;
+    generate_lattice_primitives(generator, params, start_angles, pool, workspace, primitives);
+    return primitives;
+}
+
+PrimitiveSet generate_lattice_primitives(
+    const LatticeParams& params,
+    int start_angle,
+    WorkStealingPool& pool)
+{
+    return generate_lattice_primitives(params, std::vector<int>(1, start_angle), pool);
+}
+
+PrimitiveSet generate_lattice_primitives(
+    const LatticeParams& params,
+    WorkStealingPool& pool)
+{
+    std::vector<int> start_angles(params.num_angles);
+    for (int a = 0; a < params.num_angles; ++a) {
+        start_angles[a] = a;
+    }
+    return generate_lattice_primitives(params, start_angles, pool);
+}
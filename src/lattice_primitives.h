@@ -0,0 +1,250 @@
+#ifndef lattice_primitives_h
+#define lattice_primitives_h
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include "discrete_heading.h"
+#include "footprint.h"
+#include "Pose2.h"
+#include "unicycle_motions.h"
+#include "work_stealing_pool.h"
+
+/// Bounds on the primitives enumerated over a lattice
+struct LatticeParams
+{
+    LatticeParams() :
+        num_angles(16),
+        extent(5),
+        min_radius(0.0),
+        max_radius(std::numeric_limits<double>::infinity()),
+        sample_resolution(0.0)
+    { }
+
+    int num_angles;     ///< number of discrete headings
+    int extent;         ///< goals range over [-extent, extent] cells in x and y
+    double min_radius;  ///< smallest allowed turning radius, in cells
+    double max_radius;  ///< largest allowed turning radius, in cells
+    double sample_resolution;   ///< largest spacing between intermediate poses, in cells, or 0 for the default density
+};
+
+/// A motion from the origin cell at discrete heading $start_angle to the
+/// lattice pose $end, whose yaw holds the discrete goal heading. Its
+/// intermediate poses are the $num_poses poses at $first_pose in the pose
+/// pool of the PrimitiveSet holding it. Once swept cells have been computed,
+/// the $num_cells cells at $first_cell in the cell pool are those its footprint
+/// overlaps; otherwise $num_cells is 0.
+struct MotionPrimitive
+{
+    int start_angle;
+    Pose2_disc end;
+    std::size_t first_pose;
+    std::size_t num_poses;
+    std::size_t first_cell;
+    std::size_t num_cells;
+};
+
+/// Primitives whose intermediate poses and swept cells each share one
+/// contiguous pool. clear() keeps the capacity of all three, so a set that
+/// is reused across batches stops allocating once it has grown to the
+/// largest batch.
+struct PrimitiveSet
+{
+    std::vector<MotionPrimitive> primitives;
+    std::vector<Pose2_cont> poses;
+    std::vector<CellOffset> cells;
+
+    std::size_t size() const { return primitives.size(); }
+    bool empty() const { return primitives.empty(); }
+    void clear() { primitives.clear(); poses.clear(); cells.clear(); }
+
+    const MotionPrimitive& operator[](std::size_t i) const { return primitives[i]; }
+
+    /// Return the intermediate poses of $primitive
+    const Pose2_cont* poses_of(const MotionPrimitive& primitive) const { return poses.data() + primitive.first_pose; }
+
+    /// Return the swept cells of $primitive
+    const CellOffset* cells_of(const MotionPrimitive& primitive) const { return cells.data() + primitive.first_cell; }
+
+    /// Append every primitive of $other along with its poses and cells
+    void append(const PrimitiveSet& other);
+};
+
+/// Scratch storage for generate_lattice_primitives with $Generator, kept between calls
+template <typename Generator>
+struct LatticeWorkspace
+{
+    struct Worker
+    {
+        Pose2Array starts;
+        Pose2Array goals;
+        std::vector<Pose2_disc> ends;
+        typename Generator::Batch motions;
+    };
+
+    std::vector<Worker> workers;        ///< one per pool worker
+    std::vector<PrimitiveSet> columns;  ///< one per (start heading, goal column)
+};
+
+/// Return the number of (start heading, lattice goal) pairs enumerated per start heading
+std::size_t num_lattice_goals(const LatticeParams& params);
+
+/// Return whether a motion turning with $radius, 0 for one that never turns,
+/// lies within the radius bounds of $params
+bool within_radius_bounds(const LatticeParams& params, double radius);
+
+/// Replace the contents of $primitives with every feasible primitive that
+/// $generator finds for each heading in $start_angles, in that order, and for
+/// each heading ordered by goal x, goal y and then goal heading. $Generator
+/// models the curve generator concept in motion_generator.h; its batch solve
+/// and sampling are called directly, so nothing is dispatched per pose. Once
+/// $workspace and $primitives have grown to fit, repeated calls do not allocate.
+template <typename Generator>
+void generate_lattice_primitives(
+    const Generator& generator,
+    const LatticeParams& params,
+    const std::vector<int>& start_angles,
+    WorkStealingPool& pool,
+    LatticeWorkspace<Generator>& workspace,
+    PrimitiveSet& primitives);
+
+/// Generate every feasible unicycle primitive starting at discrete heading $start_angle
+PrimitiveSet generate_lattice_primitives(
+    const LatticeParams& params,
+    int start_angle,
+    WorkStealingPool& pool);
+
+/// Generate every feasible unicycle primitive for each heading in $start_angles, in that order
+PrimitiveSet generate_lattice_primitives(
+    const LatticeParams& params,
+    const std::vector<int>& start_angles,
+    WorkStealingPool& pool);
+
+/// Generate every feasible unicycle primitive for every start heading, ordered by start heading
+PrimitiveSet generate_lattice_primitives(
+    const LatticeParams& params,
+    WorkStealingPool& pool);
+
+/// Generate the primitives from $start_angle to every goal in the column at $goal_x
+template <typename Generator>
+void generate_lattice_column(
+    const Generator& generator,
+    const LatticeParams& params,
+    int start_angle,
+    int goal_x,
+    typename LatticeWorkspace<Generator>::Worker& scratch,
+    PrimitiveSet& primitives)
+{
+    const HeadingTable& headings = HeadingTable::get(params.num_angles);
+    const DiscreteHeading start(start_angle, headings);
+
+    Pose2Array& starts = scratch.starts;
+    Pose2Array& goals = scratch.goals;
+    std::vector<Pose2_disc>& ends = scratch.ends;
+    starts.clear();
+    goals.clear();
+    ends.clear();
+    for (int goal_y = -params.extent; goal_y <= params.extent; ++goal_y) {
+        for (int goal_angle = 0; goal_angle < params.num_angles; ++goal_angle) {
+            if (goal_x == 0 && goal_y == 0) {
+                continue;
+            }
+            starts.push_back(0.0, 0.0, start);
+            goals.push_back((double)goal_x, (double)goal_y, DiscreteHeading(goal_angle, headings));
+            ends.push_back(Pose2_disc(goal_x, goal_y, goal_angle));
+        }
+    }
+
+    typename Generator::Batch& motions = scratch.motions;
+    generator.solve(starts, goals, motions);
+
+    primitives.clear();
+    for (std::size_t i = 0; i < ends.size(); ++i) {
+        if (!generator.feasible(motions, i)) {
+            continue;
+        }
+
+        typename Generator::Motion motion = generator.motion(motions, starts, i);
+        if (!within_radius_bounds(params, generator.turning_radius(motion))) {
+            continue;
+        }
+
+        const int num_samples = generator.num_samples(motion, params.sample_resolution);
+        if (num_samples <= 0) {
+            continue;
+        }
+
+        MotionPrimitive primitive;
+        primitive.start_angle = start_angle;
+        primitive.end = ends[i];
+        primitive.first_pose = primitives.poses.size();
+        primitive.num_poses = num_samples;
+        primitive.first_cell = 0;
+        primitive.num_cells = 0;
+
+        primitives.poses.resize(primitives.poses.size() + num_samples);
+        generator.sample(motion, num_samples, &primitives.poses[primitive.first_pose]);
+        primitives.primitives.push_back(primitive);
+    }
+}
+
+template <typename Generator>
+void generate_lattice_primitives(
+    const Generator& generator,
+    const LatticeParams& params,
+    const std::vector<int>& start_angles,
+    WorkStealingPool& pool,
+    LatticeWorkspace<Generator>& workspace,
+    PrimitiveSet& primitives)
+{
+    const int num_columns = 2 * params.extent + 1;
+    const std::size_t num_tasks = start_angles.size() * num_columns;
+
+    if (workspace.workers.size() < (std::size_t)pool.num_threads()) {
+        workspace.workers.resize(pool.num_threads());
+    }
+
+    // one output slot per (start heading, goal column) keeps the result
+    // ordering independent of which worker ran which column
+    if (workspace.columns.size() < num_tasks) {
+        workspace.columns.resize(num_tasks);
+    }
+
+    // the task captures a single pointer so that it fits in the small-object
+    // buffer of the pool's std::function instead of being heap-allocated
+    struct ColumnTask
+    {
+        const Generator* generator;
+        const LatticeParams* params;
+        const std::vector<int>* start_angles;
+        LatticeWorkspace<Generator>* workspace;
+        int num_columns;
+    } task = { &generator, &params, &start_angles, &workspace, num_columns };
+
+    const ColumnTask* ctx = &task;
+    pool.parallel_for(0, num_tasks, 1, [ctx](int worker, std::size_t first, std::size_t last)
+    {
+        for (std::size_t t = first; t < last; ++t) {
+            int start_angle = (*ctx->start_angles)[t / ctx->num_columns];
+            int goal_x = -ctx->params->extent + (int)(t % ctx->num_columns);
+            generate_lattice_column(*ctx->generator, *ctx->params, start_angle, goal_x,
+                    ctx->workspace->workers[worker], ctx->workspace->columns[t]);
+        }
+    });
+
+    std::size_t num_primitives = 0;
+    std::size_t num_poses = 0;
+    for (std::size_t t = 0; t < num_tasks; ++t) {
+        num_primitives += workspace.columns[t].primitives.size();
+        num_poses += workspace.columns[t].poses.size();
+    }
+
+    primitives.clear();
+    primitives.primitives.reserve(num_primitives);
+    primitives.poses.reserve(num_poses);
+    for (std::size_t t = 0; t < num_tasks; ++t) {
+        primitives.append(workspace.columns[t]);
+    }
+}
+
+#endif
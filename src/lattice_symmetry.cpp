@@ -0,0 +1,277 @@
+#include "lattice_symmetry.h"
+#include <algorithm>
+#include <cmath>
+#include "angles.h"
+#include "motion_generator.h"
+#include "work_stealing_pool.h"
+
+static int mod(int a, int n)
+{
+    return ((a % n) + n) % n;
+}
+
+static bool operator==(const LatticeTransform& lhs, const LatticeTransform& rhs)
+{
+    return lhs.xx == rhs.xx && lhs.xy == rhs.xy && lhs.yx == rhs.yx && lhs.yy == rhs.yy &&
+            lhs.angle_sign == rhs.angle_sign && lhs.angle_offset == rhs.angle_offset;
+}
+
+static LatticeTransform make_transform(int xx, int xy, int yx, int yy, int angle_sign, int angle_offset)
+{
+    LatticeTransform t = { xx, xy, yx, yy, angle_sign, angle_offset };
+    return t;
+}
+
+/// Return the transform applying $b and then $a
+static LatticeTransform compose(const LatticeTransform& a, const LatticeTransform& b, int num_angles)
+{
+    return make_transform(
+            a.xx * b.xx + a.xy * b.yx, a.xx * b.xy + a.xy * b.yy,
+            a.yx * b.xx + a.yy * b.yx, a.yx * b.xy + a.yy * b.yy,
+            a.angle_sign * b.angle_sign,
+            mod(a.angle_sign * b.angle_offset + a.angle_offset, num_angles));
+}
+
+/// Return the symmetry group of the lattice, identity first
+static std::vector<LatticeTransform> lattice_symmetries(int num_angles)
+{
+    std::vector<LatticeTransform> generators;
+
+    // reflection across the x axis maps heading a onto -a for any resolution
+    generators.push_back(make_transform(1, 0, 0, -1, -1, 0));
+    if (num_angles % 4 == 0) {
+        // quarter turn
+        generators.push_back(make_transform(0, -1, 1, 0, 1, num_angles / 4));
+    }
+    else if (num_angles % 2 == 0) {
+        // half turn
+        generators.push_back(make_transform(-1, 0, 0, -1, 1, num_angles / 2));
+    }
+
+    std::vector<LatticeTransform> group(1, make_transform(1, 0, 0, 1, 1, 0));
+    for (std::size_t i = 0; i < group.size(); ++i) {
+        for (const LatticeTransform& g : generators) {
+            LatticeTransform t = compose(g, group[i], num_angles);
+            if (std::find(group.begin(), group.end(), t) == group.end()) {
+                group.push_back(t);
+            }
+        }
+    }
+    return group;
+}
+
+int num_lattice_symmetries(int num_angles)
+{
+    return (int)lattice_symmetries(num_angles).size();
+}
+
+/// Return the smallest heading in the orbit of $angle
+static int canonical_angle(const std::vector<LatticeTransform>& group, int angle, int num_angles)
+{
+    int canonical = angle;
+    for (const LatticeTransform& t : group) {
+        canonical = std::min(canonical, transform_angle(t, angle, num_angles));
+    }
+    return canonical;
+}
+
+std::vector<int> canonical_headings(int num_angles)
+{
+    std::vector<LatticeTransform> group = lattice_symmetries(num_angles);
+    std::vector<int> headings;
+    for (int a = 0; a < num_angles; ++a) {
+        if (canonical_angle(group, a, num_angles) == a) {
+            headings.push_back(a);
+        }
+    }
+    return headings;
+}
+
+HeadingSymmetry heading_symmetry(int angle, int num_angles)
+{
+    std::vector<LatticeTransform> group = lattice_symmetries(num_angles);
+
+    HeadingSymmetry symmetry;
+    symmetry.canonical_angle = canonical_angle(group, angle, num_angles);
+    symmetry.transform = group.front();
+    for (const LatticeTransform& t : group) {
+        if (transform_angle(t, symmetry.canonical_angle, num_angles) == angle) {
+            symmetry.transform = t;
+            break;
+        }
+    }
+    return symmetry;
+}
+
+bool find_lattice_transform(int from_angle, int to_angle, int num_angles, LatticeTransform& t)
+{
+    for (const LatticeTransform& g : lattice_symmetries(num_angles)) {
+        if (transform_angle(g, from_angle, num_angles) == to_angle) {
+            t = g;
+            return true;
+        }
+    }
+    return false;
+}
+
+int transform_angle(const LatticeTransform& t, int angle, int num_angles)
+{
+    return mod(t.angle_sign * angle + t.angle_offset, num_angles);
+}
+
+Pose2_disc transform_pose(const LatticeTransform& t, const Pose2_disc& pose, int num_angles)
+{
+    return Pose2_disc(
+            t.xx * pose.x + t.xy * pose.y,
+            t.yx * pose.x + t.yy * pose.y,
+            transform_angle(t, pose.yaw, num_angles));
+}
+
+Pose2_cont transform_pose(const LatticeTransform& t, const Pose2_cont& pose, int num_angles)
+{
+    return Pose2_cont(
+            t.xx * pose.x + t.xy * pose.y,
+            t.yx * pose.x + t.yy * pose.y,
+            t.angle_sign * pose.yaw + realize_angle(t.angle_offset, num_angles));
+}
+
+void transform_primitive(
+    const LatticeTransform& t,
+    const PrimitiveSet& from,
+    const MotionPrimitive& primitive,
+    int num_angles,
+    PrimitiveSet& to)
+{
+    MotionPrimitive transformed;
+    transformed.start_angle = transform_angle(t, primitive.start_angle, num_angles);
+    transformed.end = transform_pose(t, primitive.end, num_angles);
+    transformed.first_pose = to.poses.size();
+    transformed.num_poses = primitive.num_poses;
+
+    // a reflected footprint is a different footprint, so swept cells are
+    // recomputed rather than transformed
+    transformed.first_cell = 0;
+    transformed.num_cells = 0;
+
+    // keep the derived yaws continuous with realize_angle(start_angle) rather
+    // than offset from it by a full turn
+    int unwrapped = t.angle_sign * primitive.start_angle + t.angle_offset;
+    double yaw_shift = -2.0 * M_PI * ((unwrapped - transformed.start_angle) / num_angles);
+
+    const Pose2_cont* poses = from.poses_of(primitive);
+    for (std::size_t i = 0; i < primitive.num_poses; ++i) {
+        Pose2_cont p = transform_pose(t, poses[i], num_angles);
+        p.yaw += yaw_shift;
+        to.poses.push_back(p);
+    }
+    to.primitives.push_back(transformed);
+}
+
+PrimitiveSet generate_canonical_primitives(
+    MotionGenerator& generator,
+    const LatticeParams& params,
+    WorkStealingPool& pool)
+{
+    PrimitiveSet primitives;
+    generator.generate_lattice_primitives(params, canonical_headings(params.num_angles), pool, primitives);
+    return primitives;
+}
+
+static bool end_less(const MotionPrimitive& lhs, const MotionPrimitive& rhs)
+{
+    if (lhs.end.x != rhs.end.x) {
+        return lhs.end.x < rhs.end.x;
+    }
+    if (lhs.end.y != rhs.end.y) {
+        return lhs.end.y < rhs.end.y;
+    }
+    return lhs.end.yaw < rhs.end.yaw;
+}
+
+void expand_canonical_primitives(
+    const LatticeParams& params,
+    const PrimitiveSet& canonical,
+    int start_angle,
+    PrimitiveSet& primitives)
+{
+    HeadingSymmetry symmetry = heading_symmetry(start_angle, params.num_angles);
+
+    primitives.clear();
+    for (const MotionPrimitive& primitive : canonical.primitives) {
+        if (primitive.start_angle == symmetry.canonical_angle) {
+            transform_primitive(symmetry.transform, canonical, primitive, params.num_angles, primitives);
+        }
+    }
+
+    // records only refer to their poses by offset, so they sort in place
+    std::sort(primitives.primitives.begin(), primitives.primitives.end(), end_less);
+}
+
+/// Return the largest position or heading difference between two pose sequences of length $n
+static double max_pose_error(const Pose2_cont* lhs, const Pose2_cont* rhs, std::size_t n)
+{
+    double error = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        error = std::max(error, fabs(lhs[i].x - rhs[i].x));
+        error = std::max(error, fabs(lhs[i].y - rhs[i].y));
+        error = std::max(error, fabs(shortest_angle_diff(lhs[i].yaw, rhs[i].yaw)));
+    }
+    return error;
+}
+
+std::vector<SymmetryMismatch> verify_lattice_symmetry(
+    MotionGenerator& generator,
+    const LatticeParams& params,
+    const PrimitiveSet& canonical,
+    double pose_tolerance,
+    WorkStealingPool& pool)
+{
+    PrimitiveSet direct;
+    PrimitiveSet derived;
+
+    std::vector<SymmetryMismatch> mismatches;
+    for (int a = 0; a < params.num_angles; ++a) {
+        HeadingSymmetry symmetry = heading_symmetry(a, params.num_angles);
+        if (symmetry.canonical_angle == a) {
+            continue;
+        }
+
+        generator.generate_lattice_primitives(params, std::vector<int>(1, a), pool, direct);
+        expand_canonical_primitives(params, canonical, a, derived);
+
+        SymmetryMismatch mismatch = { a, symmetry.canonical_angle, 0, 0, 0, 0.0 };
+
+        // both sequences are sorted by endpoint
+        std::size_t i = 0, j = 0;
+        while (i < direct.size() || j < derived.size()) {
+            if (j == derived.size() || (i < direct.size() && end_less(direct[i], derived[j]))) {
+                ++mismatch.num_missing;
+                ++i;
+            }
+            else if (i == direct.size() || end_less(derived[j], direct[i])) {
+                ++mismatch.num_extra;
+                ++j;
+            }
+            else {
+                if (direct[i].num_poses != derived[j].num_poses) {
+                    ++mismatch.num_pose_mismatches;
+                }
+                else {
+                    double error = max_pose_error(
+                            direct.poses_of(direct[i]), derived.poses_of(derived[j]), direct[i].num_poses);
+                    mismatch.max_pose_error = std::max(mismatch.max_pose_error, error);
+                    if (error > pose_tolerance) {
+                        ++mismatch.num_pose_mismatches;
+                    }
+                }
+                ++i;
+                ++j;
+            }
+        }
+
+        if (mismatch.num_missing || mismatch.num_extra || mismatch.num_pose_mismatches) {
+            mismatches.push_back(mismatch);
+        }
+    }
+    return mismatches;
+}
@@ -0,0 +1,90 @@
+#ifndef lattice_symmetry_h
+#define lattice_symmetry_h
+
+#include <cstddef>
+#include <vector>
+#include "Pose2.h"
+#include "lattice_primitives.h"
+
+class MotionGenerator;
+class WorkStealingPool;
+
+/// A symmetry of the lattice: a signed permutation of the cell axes paired with
+/// the matching map on discrete headings, angle -> angle_sign * angle + angle_offset
+struct LatticeTransform
+{
+    int xx, xy;
+    int yx, yy;
+    int angle_sign;
+    int angle_offset;
+};
+
+/// A canonical start heading and the transform taking its primitives onto another heading
+struct HeadingSymmetry
+{
+    int canonical_angle;
+    LatticeTransform transform;
+};
+
+/// A start heading whose derived primitives differ from directly generated ones
+struct SymmetryMismatch
+{
+    int start_angle;
+    int canonical_angle;
+    std::size_t num_missing;        ///< directly generated endpoints with no derived counterpart
+    std::size_t num_extra;          ///< derived endpoints that direct generation rejects
+    std::size_t num_pose_mismatches; ///< shared endpoints whose intermediate poses differ
+    double max_pose_error;
+};
+
+/// Return the number of distinct symmetries of a lattice with $num_angles
+/// headings: 8 when it is a multiple of 4, 4 when it is even, and 2 otherwise
+int num_lattice_symmetries(int num_angles);
+
+/// Return the start headings from which all others can be derived, in increasing order
+std::vector<int> canonical_headings(int num_angles);
+
+/// Return the canonical heading for $angle and the transform that maps it onto $angle
+HeadingSymmetry heading_symmetry(int angle, int num_angles);
+
+/// Find a symmetry mapping heading $from_angle onto $to_angle and store it in
+/// $t. Return false if the two headings lie in different orbits.
+bool find_lattice_transform(int from_angle, int to_angle, int num_angles, LatticeTransform& t);
+
+int transform_angle(const LatticeTransform& t, int angle, int num_angles);
+Pose2_disc transform_pose(const LatticeTransform& t, const Pose2_disc& pose, int num_angles);
+Pose2_cont transform_pose(const LatticeTransform& t, const Pose2_cont& pose, int num_angles);
+
+/// Append the image of $primitive, whose poses live in $from, to $to
+void transform_primitive(
+    const LatticeTransform& t,
+    const PrimitiveSet& from,
+    const MotionPrimitive& primitive,
+    int num_angles,
+    PrimitiveSet& to);
+
+/// Generate primitives for the canonical start headings only, ordered by start heading
+PrimitiveSet generate_canonical_primitives(
+    MotionGenerator& generator,
+    const LatticeParams& params,
+    WorkStealingPool& pool);
+
+/// Derive the primitives for $start_angle from a canonical primitive set, in
+/// the same order generate_lattice_primitives would produce them, replacing
+/// the contents of $primitives
+void expand_canonical_primitives(
+    const LatticeParams& params,
+    const PrimitiveSet& canonical,
+    int start_angle,
+    PrimitiveSet& primitives);
+
+/// Generate every non-canonical heading directly and compare it against its
+/// derivation from $canonical. Return one entry per heading that differs.
+std::vector<SymmetryMismatch> verify_lattice_symmetry(
+    MotionGenerator& generator,
+    const LatticeParams& params,
+    const PrimitiveSet& canonical,
+    double pose_tolerance,
+    WorkStealingPool& pool);
+
+#endif
@@ -0,0 +1,224 @@
+#include "logging.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+
+/// Messages held before the writer catches up; a power of two
+static const std::size_t LOG_RING_SIZE = 1024;
+
+/// Longest message kept, prefix and newline included; longer ones are truncated
+static const std::size_t LOG_MESSAGE_SIZE = 256;
+
+/// Longest the writer sleeps between looks at the ring
+static const std::chrono::milliseconds LOG_WRITE_INTERVAL(20);
+
+static const char* const LOG_LEVEL_NAMES[] = { "trace", "debug", "info", "warn", "error", "off" };
+static const char* const LOG_LEVEL_PREFIXES[] = { "[TRACE] ", "[DEBUG] ", "[INFO] ", "[WARN] ", "[ERROR] ", "" };
+
+static int initial_log_level()
+{
+    const char* env = getenv("MPRIMS_LOG_LEVEL");
+    if (env) {
+        for (int level = LOG_LEVEL_TRACE; level <= LOG_LEVEL_OFF; ++level) {
+            if (!strcmp(env, LOG_LEVEL_NAMES[level])) {
+                return level;
+            }
+        }
+    }
+    return LOG_LEVEL_INFO;
+}
+
+std::atomic<int> g_log_level(initial_log_level());
+
+/// A bounded multi-producer, single-consumer ring of preformatted messages.
+/// Each slot's sequence number says whose turn it is: a producer owns slot
+/// i % size when the sequence is i, the writer when it is i + 1.
+class LogRing
+{
+public:
+
+    LogRing() :
+        enqueue_pos_(0),
+        dequeue_pos_(0),
+        num_dropped_(0),
+        num_reported_dropped_(0),
+        num_written_(0),
+        stop_(false)
+    {
+        for (std::size_t i = 0; i < LOG_RING_SIZE; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        thread_ = std::thread(&LogRing::writer_main, this);
+    }
+
+    ~LogRing()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    void write(int level, const char* fmt, va_list args)
+    {
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & (LOG_RING_SIZE - 1)];
+            const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                // full; the caller must not wait on the terminal
+                num_dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        const char* prefix = LOG_LEVEL_PREFIXES[level];
+        std::size_t length = strlen(prefix);
+        memcpy(slot->text, prefix, length);
+        const int n = vsnprintf(slot->text + length, LOG_MESSAGE_SIZE - length - 1, fmt, args);
+        if (n > 0) {
+            length += std::min((std::size_t)n, LOG_MESSAGE_SIZE - length - 2);
+        }
+        if (length == 0 || slot->text[length - 1] != '\n') {
+            slot->text[length++] = '\n';
+        }
+        slot->length = (uint16_t)length;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+
+        // errors are worth an immediate wakeup; the rest wait for the interval
+        if (level >= LOG_LEVEL_ERROR) {
+            wake_.notify_one();
+        }
+    }
+
+    void flush()
+    {
+        const std::size_t target = enqueue_pos_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.notify_one();
+        written_.wait(lock, [&]() { return num_written_ >= target; });
+    }
+
+    unsigned long num_dropped() const { return num_dropped_.load(std::memory_order_relaxed); }
+
+private:
+
+    struct Slot
+    {
+        std::atomic<std::size_t> sequence;
+        uint16_t length;
+        char text[LOG_MESSAGE_SIZE];
+    };
+
+    Slot slots_[LOG_RING_SIZE];
+    std::atomic<std::size_t> enqueue_pos_;
+    std::size_t dequeue_pos_;   ///< writer only
+    std::atomic<unsigned long> num_dropped_;
+    unsigned long num_reported_dropped_;    ///< writer only
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable written_;
+    std::size_t num_written_;   ///< messages on stdout, for flush()
+    bool stop_;
+
+    std::thread thread_;
+
+    /// Write every message that is ready; return whether there were any
+    bool drain()
+    {
+        bool any = false;
+        for (;;) {
+            Slot& slot = slots_[dequeue_pos_ & (LOG_RING_SIZE - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) {
+                break;
+            }
+            fwrite(slot.text, 1, slot.length, stdout);
+            slot.sequence.store(dequeue_pos_ + LOG_RING_SIZE, std::memory_order_release);
+            ++dequeue_pos_;
+            any = true;
+        }
+
+        // say how much is missing so that a gap in the log is not a mystery
+        const unsigned long num_dropped = num_dropped_.load(std::memory_order_relaxed);
+        if (num_dropped != num_reported_dropped_) {
+            fprintf(stdout, "[WARN] dropped %lu log messages\n", num_dropped - num_reported_dropped_);
+            num_reported_dropped_ = num_dropped;
+            any = true;
+        }
+
+        if (any) {
+            fflush(stdout);
+        }
+        return any;
+    }
+
+    void writer_main()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            lock.unlock();
+            drain();
+            lock.lock();
+
+            num_written_ = dequeue_pos_;
+            written_.notify_all();
+            if (stop_) {
+                lock.unlock();
+                drain();
+                return;
+            }
+            wake_.wait_for(lock, LOG_WRITE_INTERVAL);
+        }
+    }
+};
+
+/// Started on the first message and stopped, after writing what is left,
+/// at exit
+static LogRing& log_ring()
+{
+    static LogRing ring;
+    return ring;
+}
+
+void set_log_level(int level)
+{
+    g_log_level.store(level, std::memory_order_relaxed);
+}
+
+void log_write(int level, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    log_ring().write(level, fmt, args);
+    va_end(args);
+}
+
+void log_flush()
+{
+    log_ring().flush();
+}
+
+unsigned long log_num_dropped()
+{
+    return log_ring().num_dropped();
+}
@@ -1,12 +1,62 @@
 #ifndef logging_h
 #define logging_h
 
-#define DEBUG
+#include <atomic>
 
-#ifdef DEBUG
-#define DEBUG_PRINT(fmt, ...) printf("[INFO] " fmt "\n", ##__VA_ARGS__); fflush(stdout)
-#else
-#define DEBUG_PRINT(fmt, ...)
+// Leveled logging. A message below the compile-time floor LOG_MIN_LEVEL is
+// compiled out along with its arguments. Above it, a message below the
+// runtime level costs one relaxed load and its arguments are not evaluated.
+// Enabled messages are formatted straight into a lock-free ring and written
+// to stdout by a background thread, so logging never waits on the terminal;
+// when the ring is full, messages are dropped and counted instead.
+//
+// The runtime level starts at info, or at $MPRIMS_LOG_LEVEL if it is set to
+// one of trace, debug, info, warn, error or off.
+
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_WARN  3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF   5
+
+/// Build with -DLOG_MIN_LEVEL=LOG_LEVEL_TRACE to keep the solvers' trace messages
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
 #endif
 
+extern std::atomic<int> g_log_level;
+
+/// Return whether messages at $level are written
+inline bool log_enabled(int level)
+{
+    return level >= LOG_MIN_LEVEL && level >= g_log_level.load(std::memory_order_relaxed);
+}
+
+/// Write messages at $level and above, within the compile-time floor
+void set_log_level(int level);
+inline int log_level() { return g_log_level.load(std::memory_order_relaxed); }
+
+/// Format a message into the ring; use the LOG_ macros instead
+void log_write(int level, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/// Block until every message written so far is on stdout
+void log_flush();
+
+/// Number of messages dropped because the ring was full
+unsigned long log_num_dropped();
+
+#define LOG_AT(level, fmt, ...) \
+    do { \
+        if ((level) >= LOG_MIN_LEVEL && log_enabled(level)) { \
+            log_write(level, fmt, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_TRACE(fmt, ...) LOG_AT(LOG_LEVEL_TRACE, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...)  LOG_AT(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...)  LOG_AT(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...) LOG_AT(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+
 #endif
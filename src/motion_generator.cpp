@@ -0,0 +1,51 @@
+#include "motion_generator.h"
+#include "dubins_motions.h"
+#include "unicycle_motions.h"
+
+typedef MotionGenerator* (*MotionGeneratorFactory)(const MotionGeneratorParams&);
+
+static MotionGenerator* make_unicycle_generator(const MotionGeneratorParams&)
+{
+    return new BasicMotionGenerator<UnicycleGenerator>();
+}
+
+static MotionGenerator* make_dubins_generator(const MotionGeneratorParams& params)
+{
+    return new BasicMotionGenerator<DubinsGenerator>(DubinsGenerator(params.turning_radius));
+}
+
+struct MotionGeneratorEntry
+{
+    const char* name;
+    MotionGeneratorFactory create;
+};
+
+/// Every available curve generator, the default first
+static const MotionGeneratorEntry MOTION_GENERATORS[] =
+{
+    { UnicycleGenerator::name(), make_unicycle_generator },
+    { DubinsGenerator::name(), make_dubins_generator },
+};
+
+static const std::size_t NUM_MOTION_GENERATORS = sizeof(MOTION_GENERATORS) / sizeof(MOTION_GENERATORS[0]);
+
+std::vector<std::string> motion_generator_names()
+{
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < NUM_MOTION_GENERATORS; ++i) {
+        names.push_back(MOTION_GENERATORS[i].name);
+    }
+    return names;
+}
+
+std::unique_ptr<MotionGenerator> create_motion_generator(
+    const std::string& name,
+    const MotionGeneratorParams& params)
+{
+    for (std::size_t i = 0; i < NUM_MOTION_GENERATORS; ++i) {
+        if (name == MOTION_GENERATORS[i].name) {
+            return std::unique_ptr<MotionGenerator>(MOTION_GENERATORS[i].create(params));
+        }
+    }
+    return std::unique_ptr<MotionGenerator>();
+}
@@ -0,0 +1,323 @@
+#ifndef motion_generator_h
+#define motion_generator_h
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+#include "goal_set.h"
+#include "lattice_primitives.h"
+#include "Pose2.h"
+
+class WorkStealingPool;
+
+// A curve generator is a type G providing
+//
+//   typedef ... Motion;    compact parametric solution for one (start, goal) pair
+//   typedef ... Batch;     solutions for many pairs, reusable between solves
+//   static const char* name();
+//   bool solve(const Pose2_cont& start, const Pose2_cont& goal, Motion& motion) const;
+//   void solve(const Pose2Array& starts, const Pose2Array& goals, Batch& motions) const;
+//   bool feasible(const Batch& motions, std::size_t i) const;
+//   Motion motion(const Batch& motions, const Pose2Array& starts, std::size_t i) const;
+//   double turning_radius(const Motion& motion) const;    0 if it never turns
+//   int num_samples(const Motion& motion, double resolution) const;    0 = default density
+//   void sample(const Motion& motion, int num_samples, Pose2_cont* poses) const;
+//
+// Batch code such as generate_lattice_primitives takes G as a template
+// parameter. MotionGenerator wraps one behind a virtual interface so the
+// designer and mprimgen can choose a generator by name at runtime, paying
+// one virtual call per motion or per lattice batch rather than per pose.
+
+/// Scratch storage for MotionGenerator::generate_batch, kept between calls.
+/// Only the generator that created it can use it.
+class MotionBatchWorkspace
+{
+public:
+
+    virtual ~MotionBatchWorkspace() { }
+};
+
+/// Runtime handle on a curve generator
+class MotionGenerator
+{
+public:
+
+    virtual ~MotionGenerator() { }
+
+    virtual const char* name() const = 0;
+
+    /// Replace the contents of $poses with the intermediate poses on the
+    /// motion from $start to $goal, at most $resolution cells apart or at the
+    /// default density if it is 0. Return false, leaving $poses empty, if
+    /// there is no such motion.
+    virtual bool generate(
+        const Pose2_cont& start,
+        const Pose2_cont& goal,
+        std::vector<Pose2_cont>& poses,
+        double resolution = 0.0) const = 0;
+
+    /// For each k below $num_goals, replace the contents of $poses[k] with
+    /// the intermediate poses on the motion from $start to goal $indices[k]
+    /// of $goals, as generate() would, solving the motions as one batch in
+    /// $workspace. Goals without a motion get no poses. Return the number
+    /// with one. Once $workspace and $poses have grown to the batch, calls
+    /// allocate nothing.
+    virtual std::size_t generate_batch(
+        const Pose2_cont& start,
+        const Pose2Array& goals,
+        const std::size_t* indices,
+        std::size_t num_goals,
+        std::vector<Pose2_cont>* poses,
+        MotionBatchWorkspace& workspace,
+        double resolution = 0.0) const = 0;
+
+    /// As above, in a workspace made for the call
+    std::size_t generate_batch(
+        const Pose2_cont& start,
+        const Pose2Array& goals,
+        const std::size_t* indices,
+        std::size_t num_goals,
+        std::vector<Pose2_cont>* poses,
+        double resolution = 0.0) const
+    {
+        std::unique_ptr<MotionBatchWorkspace> workspace = create_batch_workspace();
+        return generate_batch(start, goals, indices, num_goals, poses, *workspace, resolution);
+    }
+
+    /// Return an empty workspace for generate_batch
+    virtual std::unique_ptr<MotionBatchWorkspace> create_batch_workspace() const = 0;
+
+    /// Replace the contents of $primitives with the lattice primitives for
+    /// each heading in $start_angles, as generate_lattice_primitives does.
+    /// Scratch storage is kept in the generator between calls.
+    virtual void generate_lattice_primitives(
+        const LatticeParams& params,
+        const std::vector<int>& start_angles,
+        WorkStealingPool& pool,
+        PrimitiveSet& primitives) = 0;
+
+    /// Replace the contents of $primitives with the motions from $start to
+    /// each of $goals, solved as one batch, in the goals' storage order. The
+    /// poses are made relative to the start cell and the end headings are
+    /// discretized to $num_angles. Return the number of goals left out for
+    /// having no motion.
+    virtual std::size_t generate_goal_primitives(
+        const Pose2_cont& start,
+        const GoalSet& goals,
+        int num_angles,
+        PrimitiveSet& primitives) const = 0;
+};
+
+/// Adapts the curve generator $Generator to the MotionGenerator interface
+template <typename Generator>
+class BasicMotionGenerator : public MotionGenerator
+{
+public:
+
+    explicit BasicMotionGenerator(const Generator& generator = Generator()) : generator_(generator) { }
+
+    const Generator& generator() const { return generator_; }
+
+    const char* name() const { return Generator::name(); }
+
+    bool generate(
+        const Pose2_cont& start,
+        const Pose2_cont& goal,
+        std::vector<Pose2_cont>& poses,
+        double resolution = 0.0) const;
+
+    using MotionGenerator::generate_batch;
+
+    std::size_t generate_batch(
+        const Pose2_cont& start,
+        const Pose2Array& goals,
+        const std::size_t* indices,
+        std::size_t num_goals,
+        std::vector<Pose2_cont>* poses,
+        MotionBatchWorkspace& workspace,
+        double resolution = 0.0) const;
+
+    std::unique_ptr<MotionBatchWorkspace> create_batch_workspace() const;
+
+    void generate_lattice_primitives(
+        const LatticeParams& params,
+        const std::vector<int>& start_angles,
+        WorkStealingPool& pool,
+        PrimitiveSet& primitives);
+
+    std::size_t generate_goal_primitives(
+        const Pose2_cont& start,
+        const GoalSet& goals,
+        int num_angles,
+        PrimitiveSet& primitives) const;
+
+private:
+
+    struct BatchWorkspace : public MotionBatchWorkspace
+    {
+        Pose2Array starts;
+        Pose2Array goals;
+        typename Generator::Batch motions;
+    };
+
+    Generator generator_;
+    LatticeWorkspace<Generator> workspace_;
+};
+
+/// Settings shared by every curve generator; each uses the ones that apply to it
+struct MotionGeneratorParams
+{
+    MotionGeneratorParams() : turning_radius(1.0) { }
+
+    double turning_radius;  ///< minimum turning radius, in cells, for generators with a fixed one
+};
+
+/// Return the names of the available curve generators; the first is the default
+std::vector<std::string> motion_generator_names();
+
+/// Create the curve generator called $name, or return null if there is none
+std::unique_ptr<MotionGenerator> create_motion_generator(
+    const std::string& name,
+    const MotionGeneratorParams& params = MotionGeneratorParams());
+
+template <typename Generator>
+bool BasicMotionGenerator<Generator>::generate(
+    const Pose2_cont& start,
+    const Pose2_cont& goal,
+    std::vector<Pose2_cont>& poses,
+    double resolution) const
+{
+    poses.clear();
+
+    typename Generator::Motion motion;
+    if (!generator_.solve(start, goal, motion)) {
+        return false;
+    }
+
+    const int num_samples = generator_.num_samples(motion, resolution);
+    if (num_samples <= 0) {
+        return false;
+    }
+
+    poses.resize(num_samples);
+    generator_.sample(motion, num_samples, &poses[0]);
+    return true;
+}
+
+template <typename Generator>
+std::size_t BasicMotionGenerator<Generator>::generate_batch(
+    const Pose2_cont& start,
+    const Pose2Array& goals,
+    const std::size_t* indices,
+    std::size_t num_goals,
+    std::vector<Pose2_cont>* poses,
+    MotionBatchWorkspace& workspace,
+    double resolution) const
+{
+    BatchWorkspace& scratch = static_cast<BatchWorkspace&>(workspace);
+    Pose2Array& starts = scratch.starts;
+    Pose2Array& batch_goals = scratch.goals;
+    typename Generator::Batch& motions = scratch.motions;
+    starts.clear();
+    batch_goals.clear();
+    for (std::size_t k = 0; k < num_goals; ++k) {
+        starts.push_back(start);
+        batch_goals.push_back(goals[indices[k]]);
+    }
+
+    generator_.solve(starts, batch_goals, motions);
+
+    std::size_t num_found = 0;
+    for (std::size_t k = 0; k < num_goals; ++k) {
+        poses[k].clear();
+        if (!generator_.feasible(motions, k)) {
+            continue;
+        }
+        const typename Generator::Motion motion = generator_.motion(motions, starts, k);
+        const int num_samples = generator_.num_samples(motion, resolution);
+        if (num_samples <= 0) {
+            continue;
+        }
+        poses[k].resize(num_samples);
+        generator_.sample(motion, num_samples, &poses[k][0]);
+        ++num_found;
+    }
+    return num_found;
+}
+
+template <typename Generator>
+std::unique_ptr<MotionBatchWorkspace> BasicMotionGenerator<Generator>::create_batch_workspace() const
+{
+    return std::unique_ptr<MotionBatchWorkspace>(new BatchWorkspace());
+}
+
+template <typename Generator>
+void BasicMotionGenerator<Generator>::generate_lattice_primitives(
+    const LatticeParams& params,
+    const std::vector<int>& start_angles,
+    WorkStealingPool& pool,
+    PrimitiveSet& primitives)
+{
+    ::generate_lattice_primitives(generator_, params, start_angles, pool, workspace_, primitives);
+}
+
+template <typename Generator>
+std::size_t BasicMotionGenerator<Generator>::generate_goal_primitives(
+    const Pose2_cont& start,
+    const GoalSet& goals,
+    int num_angles,
+    PrimitiveSet& primitives) const
+{
+    primitives.clear();
+
+    Pose2Array starts;
+    for (std::size_t i = 0; i < goals.size(); ++i) {
+        starts.push_back(start);
+    }
+
+    typename Generator::Batch motions;
+    generator_.solve(starts, goals.poses(), motions);
+
+    const int start_angle = DiscreteHeading::from_angle(start.yaw, num_angles).index();
+    const Pose2Array& poses = goals.poses();
+
+    std::size_t num_skipped = 0;
+    for (std::size_t i = 0; i < goals.size(); ++i) {
+        int num_samples = 0;
+        typename Generator::Motion motion;
+        if (generator_.feasible(motions, i)) {
+            motion = generator_.motion(motions, starts, i);
+            num_samples = generator_.num_samples(motion, 0.0);
+        }
+        if (num_samples <= 0) {
+            ++num_skipped;
+            continue;
+        }
+
+        MotionPrimitive primitive;
+        primitive.start_angle = start_angle;
+        primitive.end = Pose2_disc(
+                (int)std::round(poses.x[i] - start.x),
+                (int)std::round(poses.y[i] - start.y),
+                DiscreteHeading::from_angle(poses.yaw[i], num_angles).index());
+        primitive.first_pose = primitives.poses.size();
+        primitive.num_poses = num_samples;
+        primitive.first_cell = 0;
+        primitive.num_cells = 0;
+
+        primitives.poses.resize(primitives.poses.size() + num_samples);
+        Pose2_cont* sampled = &primitives.poses[primitive.first_pose];
+        generator_.sample(motion, num_samples, sampled);
+
+        // primitives are stored relative to the start cell
+        for (int j = 0; j < num_samples; ++j) {
+            sampled[j].x -= start.x;
+            sampled[j].y -= start.y;
+        }
+        primitives.primitives.push_back(primitive);
+    }
+    return num_skipped;
+}
+
+#endif
@@ -0,0 +1,249 @@
+#include "motion_worker.h"
+#include <algorithm>
+#include <utility>
+
+/// Misses solved as one batch, and handed to a pool worker, at a time
+static const std::size_t MISS_GRAIN = 16;
+
+/// Goals packed into a result between checks for a newer request
+static const std::size_t PACK_CHECK_INTERVAL = 256;
+
+const double MotionWorker::MAX_RESULT_AGE = 0.05;
+
+void MotionSet::clear()
+{
+    version = 0;
+    goals.clear();
+    poses.clear();
+    first_pose.clear();
+    bounds.clear();
+    generation_time = 0.0;
+    num_generated = 0;
+}
+
+void MotionSet::swap(MotionSet& other)
+{
+    std::swap(version, other.version);
+    std::swap(start, other.start);
+    std::swap(goals, other.goals);
+    poses.swap(other.poses);
+    first_pose.swap(other.first_pose);
+    bounds.swap(other.bounds);
+    std::swap(generation_time, other.generation_time);
+    std::swap(num_generated, other.num_generated);
+}
+
+MotionWorker::MotionWorker(int num_threads) :
+    version_(0),
+    num_generated_(0),
+    stop_(false),
+    have_request_(false),
+    pending_version_(0),
+    have_result_(false),
+    request_version_(0),
+    answered_(true),
+    generator_turning_radius_(0.0),
+    pool_(num_threads)
+{
+    thread_ = std::thread(&MotionWorker::worker_main, this);
+}
+
+MotionWorker::~MotionWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    request_available_.notify_one();
+    thread_.join();
+}
+
+uint64_t MotionWorker::submit(MotionRequest& request)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (have_request_) {
+        // the request being replaced never ran, so its stale goals carry over
+        request.stale_goals.insert(request.stale_goals.end(), pending_.stale_goals.begin(), pending_.stale_goals.end());
+    }
+    std::swap(pending_, request);
+    have_request_ = true;
+    pending_version_ = ++version_;
+    const uint64_t version = pending_version_;
+    lock.unlock();
+
+    request_available_.notify_one();
+    return version;
+}
+
+bool MotionWorker::poll(MotionSet& result)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!have_result_ || completed_.version <= result.version) {
+        return false;
+    }
+    result.swap(completed_);
+    have_result_ = false;
+    return true;
+}
+
+void MotionWorker::set_result_callback(const std::function<void()>& callback)
+{
+    std::lock_guard<std::mutex> lock(callback_mutex_);
+    callback_ = callback;
+}
+
+void MotionWorker::worker_main()
+{
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            request_available_.wait(lock, [this]() { return stop_ || have_request_; });
+            if (stop_) {
+                return;
+            }
+            std::swap(request_, pending_);
+            request_version_ = pending_version_;
+            have_request_ = false;
+        }
+
+        if (answered_) {
+            waiting_since_ = Clock::now();
+            answered_ = false;
+        }
+        if (!process()) {
+            continue;
+        }
+        answered_ = true;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            completed_.swap(result_);
+            have_result_ = true;
+        }
+
+        std::lock_guard<std::mutex> lock(callback_mutex_);
+        if (callback_) {
+            callback_();
+        }
+    }
+}
+
+bool MotionWorker::cancelled() const
+{
+    if (stop_) {
+        return true;
+    }
+    if (request_version_ == version_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    return std::chrono::duration<double>(Clock::now() - waiting_since_).count() < MAX_RESULT_AGE;
+}
+
+bool MotionWorker::use_generator(const MotionRequest& request)
+{
+    if (generator_ &&
+        request.generator == generator_name_ &&
+        request.generator_params.turning_radius == generator_turning_radius_)
+    {
+        return true;
+    }
+
+    std::unique_ptr<MotionGenerator> generator = create_motion_generator(request.generator, request.generator_params);
+    if (!generator) {
+        return false;
+    }
+
+    // a new generator may reuse the old one's address, so the cache cannot
+    // be trusted to notice the change
+    cache_.clear();
+    cache_.set_generator(generator.get());
+    batch_workspaces_.clear();
+    for (int w = 0; w < pool_.num_threads(); ++w) {
+        batch_workspaces_.push_back(generator->create_batch_workspace());
+    }
+    generator_ = std::move(generator);
+    generator_name_ = request.generator;
+    generator_turning_radius_ = request.generator_params.turning_radius;
+    return true;
+}
+
+bool MotionWorker::process()
+{
+    const Clock::time_point process_start = Clock::now();
+    const MotionRequest& request = request_;
+    if (!use_generator(request)) {
+        return false;
+    }
+
+    const Pose2_cont& start = request.start;
+    cache_.set_resolution(request.resolution);
+    if (start != cache_start_) {
+        cache_.clear();
+        cache_start_ = start;
+    }
+    else {
+        for (const Pose2_cont& goal : request.stale_goals) {
+            cache_.invalidate(start, goal);
+        }
+    }
+
+    // generate the motions that are not cached in parallel
+    misses_.clear();
+    for (std::size_t i = 0; i < request.goals.size(); ++i) {
+        if (!cache_.contains(start, request.goals[i])) {
+            misses_.push_back(i);
+        }
+    }
+    if (miss_motions_.size() < misses_.size()) {
+        miss_motions_.resize(misses_.size());
+    }
+    miss_done_.assign(misses_.size(), 0);
+
+    // the task captures only this, so that it fits in the small-object
+    // buffer of the pool's std::function instead of being heap-allocated
+    pool_.parallel_for(0, misses_.size(), MISS_GRAIN, [this](int worker, std::size_t first, std::size_t last)
+    {
+        const MotionRequest& request = request_;
+        MotionBatchWorkspace& workspace = *batch_workspaces_[worker];
+        for (std::size_t k = first; k < last; k += MISS_GRAIN) {
+            if (cancelled()) {
+                return;
+            }
+            const std::size_t end = std::min(last, k + MISS_GRAIN);
+            generator_->generate_batch(request.start, request.goals, &misses_[k], end - k, &miss_motions_[k], workspace, request.resolution);
+            std::fill(miss_done_.begin() + k, miss_done_.begin() + end, 1);
+        }
+    });
+
+    // keep what was finished even if the request was abandoned; the next
+    // request is likely to want most of it
+    std::size_t num_generated = 0;
+    for (std::size_t k = 0; k < misses_.size(); ++k) {
+        if (miss_done_[k]) {
+            cache_.store(start, request.goals[misses_[k]], miss_motions_[k]);
+            ++num_generated;
+        }
+    }
+    num_generated_ += num_generated;
+    if (cancelled()) {
+        return false;
+    }
+
+    result_.clear();
+    result_.version = request_version_;
+    result_.start = start;
+    result_.goals = request.goals;
+    for (std::size_t i = 0; i < request.goals.size(); ++i) {
+        if (i % PACK_CHECK_INTERVAL == 0 && cancelled()) {
+            return false;
+        }
+        const MotionCache::Motion& motion = cache_.motion(start, request.goals[i]);
+        result_.first_pose.push_back(result_.poses.size());
+        result_.poses.insert(result_.poses.end(), motion.begin(), motion.end());
+        result_.bounds.push_back(cache_.bounds(start, request.goals[i]));
+    }
+    result_.first_pose.push_back(result_.poses.size());
+    result_.num_generated = num_generated;
+    result_.generation_time = std::chrono::duration<double>(Clock::now() - process_start).count();
+    return true;
+}
@@ -0,0 +1,157 @@
+#ifndef motion_worker_h
+#define motion_worker_h
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MotionCache.h"
+#include "motion_generator.h"
+#include "Pose2.h"
+#include "unicycle_motions.h"
+#include "work_stealing_pool.h"
+
+/// The motions from one start to each of a list of goals, with their poses
+/// packed one motion after another
+struct MotionSet
+{
+    MotionSet() : version(0), generation_time(0.0), num_generated(0) { }
+
+    uint64_t version;                   ///< of the request answered; 0 for none
+    Pose2_cont start;
+    Pose2Array goals;
+    std::vector<Pose2_cont> poses;
+    std::vector<std::size_t> first_pose;    ///< per goal, and one past the last pose
+    std::vector<Bounds2> bounds;        ///< per goal; empty if there is no motion
+
+    double generation_time;     ///< seconds the worker spent on the request
+    std::size_t num_generated;  ///< motions generated for it; the rest were cached
+
+    std::size_t size() const { return goals.size(); }
+
+    const Pose2_cont* motion(std::size_t i) const { return poses.data() + first_pose[i]; }
+    std::size_t num_poses(std::size_t i) const { return first_pose[i + 1] - first_pose[i]; }
+
+    void clear();
+    void swap(MotionSet& other);
+};
+
+/// The motions wanted from a MotionWorker
+struct MotionRequest
+{
+    MotionRequest() : resolution(0.0) { }
+
+    std::string generator;
+    MotionGeneratorParams generator_params;
+    double resolution;  ///< as for MotionGenerator::generate
+
+    Pose2_cont start;
+    Pose2Array goals;   ///< as GoalSet::poses() holds them
+
+    /// Goals moved or removed since the last request, whose cached motions
+    /// are no longer needed
+    std::vector<Pose2_cont> stale_goals;
+};
+
+/// Generates motions on a background thread, so that a slow generator or a
+/// large set of goals does not hold up the caller. Each submitted request
+/// supersedes the earlier ones: a request still waiting is replaced, and one
+/// being generated is abandoned at its next check. During a long drag every
+/// request would be abandoned, so once the caller has gone MAX_RESULT_AGE
+/// without a result the request in progress is finished regardless.
+///
+/// Motions are cached between requests, including those finished before a
+/// request was abandoned, so a request only generates the motions of goals
+/// that changed. Misses are solved in batches, in parallel on a
+/// WorkStealingPool.
+class MotionWorker
+{
+public:
+
+    /// Start a worker whose pool has $num_threads threads; 0 uses one per hardware thread
+    explicit MotionWorker(int num_threads = 0);
+    ~MotionWorker();
+
+    /// Queue $request, taking its contents and leaving storage for reuse in
+    /// it, and abandon any earlier request. Return the request's version;
+    /// versions increase from 1.
+    uint64_t submit(MotionRequest& request);
+
+    /// If a request newer than the one $result answers has completed, swap
+    /// its motions into $result and return true. The storage $result held is
+    /// reused for later results.
+    bool poll(MotionSet& result);
+
+    /// Call $callback on the worker thread whenever a request completes; it
+    /// is not called again once this returns
+    void set_result_callback(const std::function<void()>& callback);
+
+    /// Number of motions generated since construction
+    std::size_t num_generated() const { return num_generated_; }
+
+    /// Longest the caller waits for some result while requests keep coming, in seconds
+    static const double MAX_RESULT_AGE;
+
+private:
+
+    typedef std::chrono::steady_clock Clock;
+
+    std::atomic<uint64_t> version_;     ///< of the newest request submitted
+    std::atomic<std::size_t> num_generated_;
+
+    std::mutex mutex_;
+    std::condition_variable request_available_;
+    std::atomic<bool> stop_;
+    bool have_request_;
+    MotionRequest pending_;
+    uint64_t pending_version_;
+    bool have_result_;
+    MotionSet completed_;
+
+    std::mutex callback_mutex_;
+    std::function<void()> callback_;
+
+    // used by the worker thread only
+    MotionRequest request_;
+    uint64_t request_version_;
+    bool answered_;             ///< whether the last request taken was answered
+    Clock::time_point waiting_since_;   ///< when the first unanswered request was taken
+    MotionSet result_;
+    MotionCache cache_;
+    Pose2_cont cache_start_;    ///< the start of every cached motion
+    std::unique_ptr<MotionGenerator> generator_;
+    std::string generator_name_;
+    double generator_turning_radius_;
+    std::vector<std::unique_ptr<MotionBatchWorkspace>> batch_workspaces_;  ///< one per pool worker, for generator_
+    std::vector<std::size_t> misses_;
+    std::vector<MotionCache::Motion> miss_motions_;
+    std::vector<uint8_t> miss_done_;
+    WorkStealingPool pool_;
+
+    std::thread thread_;
+
+    MotionWorker(const MotionWorker&);
+    MotionWorker& operator=(const MotionWorker&);
+
+    /// Return whether to abandon the request being generated
+    bool cancelled() const;
+
+    void worker_main();
+
+    /// Generate the motions for request_ into result_. Return false if the
+    /// request was abandoned first.
+    bool process();
+
+    /// Switch to the generator $request names, dropping the cached motions
+    /// if it changes. Return false if there is no such generator.
+    bool use_generator(const MotionRequest& request);
+};
+
+#endif
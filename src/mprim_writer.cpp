@@ -0,0 +1,198 @@
+#include "mprim_writer.h"
+#include <cmath>
+#include <cstring>
+#include "angles.h"
+#include "lattice_primitives.h"
+
+// width of the space-padded primitive count that close() patches in place
+static const int COUNT_WIDTH = 12;
+
+MprimWriter::MprimWriter(std::size_t buffer_size) :
+    file_(0),
+    buffer_(buffer_size < 4096 ? 4096 : buffer_size),
+    used_(0),
+    ok_(false),
+    resolution_(0.0),
+    num_angles_(0),
+    count_offset_(0),
+    num_primitives_(0),
+    current_start_angle_(-1),
+    next_prim_id_(0)
+{
+}
+
+MprimWriter::~MprimWriter()
+{
+    if (file_) {
+        close();
+    }
+}
+
+bool MprimWriter::open(const std::string& path, double resolution, int num_angles)
+{
+    if (file_) {
+        close();
+    }
+
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) {
+        return false;
+    }
+
+    // the buffer already batches writes; skip stdio's own copy
+    setvbuf(file_, 0, _IONBF, 0);
+
+    ok_ = true;
+    used_ = 0;
+    resolution_ = resolution;
+    num_angles_ = num_angles;
+    num_primitives_ = 0;
+    current_start_angle_ = -1;
+    next_prim_id_ = 0;
+
+    char header[128];
+    snprintf(header, sizeof(header), "resolution_m: %f\nnumberofangles: %d\ntotalnumberofprimitives: ", resolution, num_angles);
+    append(header);
+    count_offset_ = (long)used_;
+    for (int i = 0; i < COUNT_WIDTH; ++i) {
+        append(" ");
+    }
+    append("\n");
+    return true;
+}
+
+bool MprimWriter::write(int start_angle, const Pose2_disc& end, const Pose2_cont* poses, std::size_t num_poses, int cost_mult)
+{
+    if (!file_ || start_angle < current_start_angle_) {
+        return false;
+    }
+
+    if (start_angle != current_start_angle_) {
+        current_start_angle_ = start_angle;
+        next_prim_id_ = 0;
+    }
+
+    append("primID: ");
+    append_int(next_prim_id_++);
+    append("\nstartangle_c: ");
+    append_int(start_angle);
+    append("\nendpose_c: ");
+    append_int(end.x);
+    append(" ");
+    append_int(end.y);
+    append(" ");
+    append_int(end.yaw);
+    append("\nadditionalactioncostmult: ");
+    append_int(cost_mult);
+    append("\nintermediateposes: ");
+    append_int((long long)num_poses);
+    append("\n");
+
+    for (std::size_t i = 0; i < num_poses; ++i) {
+        append_fixed(poses[i].x * resolution_);
+        append(" ");
+        append_fixed(poses[i].y * resolution_);
+        append(" ");
+        append_fixed(normalize_angle(poses[i].yaw));
+        append("\n");
+    }
+
+    ++num_primitives_;
+    return ok_;
+}
+
+bool MprimWriter::write(const PrimitiveSet& primitives, int cost_mult)
+{
+    for (const MotionPrimitive& p : primitives.primitives) {
+        if (!write(p.start_angle, p.end, primitives.poses_of(p), p.num_poses, cost_mult)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MprimWriter::close()
+{
+    if (!file_) {
+        return false;
+    }
+
+    flush();
+
+    char count[COUNT_WIDTH + 1];
+    snprintf(count, sizeof(count), "%-*zu", COUNT_WIDTH, num_primitives_);
+    if (fseek(file_, count_offset_, SEEK_SET) != 0 || fwrite(count, 1, COUNT_WIDTH, file_) != (std::size_t)COUNT_WIDTH) {
+        ok_ = false;
+    }
+
+    if (fclose(file_) != 0) {
+        ok_ = false;
+    }
+    file_ = 0;
+    return ok_;
+}
+
+void MprimWriter::reserve(std::size_t size)
+{
+    if (used_ + size > buffer_.size()) {
+        flush();
+    }
+}
+
+void MprimWriter::flush()
+{
+    if (used_ > 0) {
+        if (fwrite(&buffer_[0], 1, used_, file_) != used_) {
+            ok_ = false;
+        }
+        used_ = 0;
+    }
+}
+
+void MprimWriter::append(const char* s)
+{
+    const std::size_t len = strlen(s);
+    reserve(len);
+    memcpy(&buffer_[used_], s, len);
+    used_ += len;
+}
+
+void MprimWriter::append_int(long long i)
+{
+    char digits[24];
+    int n = 0;
+    unsigned long long u = i < 0 ? 0ull - (unsigned long long)i : (unsigned long long)i;
+    do {
+        digits[n++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+
+    reserve(n + 1);
+    if (i < 0) {
+        buffer_[used_++] = '-';
+    }
+    while (n) {
+        buffer_[used_++] = digits[--n];
+    }
+}
+
+/// Append $d with four decimal places, as printf("%.4f") would
+void MprimWriter::append_fixed(double d)
+{
+    long long scaled = std::llround(d * 10000.0);
+    if (scaled < 0) {
+        reserve(1);
+        buffer_[used_++] = '-';
+        scaled = -scaled;
+    }
+
+    append_int(scaled / 10000);
+
+    long long frac = scaled % 10000;
+    reserve(5);
+    buffer_[used_++] = '.';
+    buffer_[used_++] = (char)('0' + frac / 1000);
+    buffer_[used_++] = (char)('0' + frac / 100 % 10);
+    buffer_[used_++] = (char)('0' + frac / 10 % 10);
+    buffer_[used_++] = (char)('0' + frac % 10);
+}
@@ -0,0 +1,69 @@
+#ifndef mprim_writer_h
+#define mprim_writer_h
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Pose2.h"
+
+struct PrimitiveSet;
+
+/// Streams motion primitives to an SBPL .mprim file. Output is formatted
+/// straight into a large buffer that is flushed whenever it fills, so memory
+/// use does not depend on the number of primitives. The primitive count in
+/// the header is patched in by close().
+class MprimWriter
+{
+public:
+
+    static const std::size_t DEFAULT_BUFFER_SIZE = 1 << 22;
+
+    explicit MprimWriter(std::size_t buffer_size = DEFAULT_BUFFER_SIZE);
+    ~MprimWriter();
+
+    /// Create $path and write the header for a lattice with $num_angles headings
+    /// and cells $resolution meters wide
+    bool open(const std::string& path, double resolution, int num_angles);
+
+    /// Append a primitive from discrete heading $start_angle to the cell offset
+    /// and heading in $end. $poses are in cells relative to the start cell.
+    /// Primitives must be written grouped by start heading.
+    bool write(int start_angle, const Pose2_disc& end, const Pose2_cont* poses, std::size_t num_poses, int cost_mult = 1);
+
+    /// Append every primitive in $primitives
+    bool write(const PrimitiveSet& primitives, int cost_mult = 1);
+
+    /// Flush the buffer, patch the primitive count and close the file
+    bool close();
+
+    bool is_open() const { return file_ != 0; }
+    std::size_t num_primitives() const { return num_primitives_; }
+
+private:
+
+    FILE* file_;
+    std::vector<char> buffer_;
+    std::size_t used_;
+    bool ok_;
+
+    double resolution_;
+    int num_angles_;
+
+    long count_offset_;
+    std::size_t num_primitives_;
+
+    int current_start_angle_;
+    int next_prim_id_;
+
+    MprimWriter(const MprimWriter&);
+    MprimWriter& operator=(const MprimWriter&);
+
+    void reserve(std::size_t size);
+    void flush();
+    void append(const char* s);
+    void append_int(long long i);
+    void append_fixed(double d);
+};
+
+#endif
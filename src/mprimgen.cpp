@@ -0,0 +1,311 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include "footprint.h"
+#include "lattice_primitives.h"
+#include "lattice_symmetry.h"
+#include "motion_generator.h"
+#include "primitive_export.h"
+#include "primitive_pruning.h"
+#include "work_stealing_pool.h"
+
+static void print_usage(const char* prog)
+{
+    printf("usage: %s [options]\n", prog);
+    printf("\n");
+    printf("Enumerate unicycle motion primitives over every (start heading, lattice goal) pair.\n");
+    printf("\n");
+    printf("  -n, --num-angles N   number of discrete headings (default 16)\n");
+    printf("  -e, --extent E       enumerate goals over [-E, E] cells (default 5)\n");
+    printf("  -r, --min-radius R   smallest allowed turning radius in cells (default 0)\n");
+    printf("  -R, --max-radius R   largest allowed turning radius in cells (default unbounded)\n");
+    printf("  -j, --threads N      number of worker threads (default: one per core)\n");
+    printf("  -o, --output FILE    write the primitives to an SBPL .mprim file, and a binary\n");
+    printf("                       primitive library next to it with a .mprimlib extension\n");
+    printf("      --resolution M   cell size in meters for the .mprim file (default 0.025)\n");
+    printf("      --footprint POLY store the cells swept by the footprint polygon \"x1,y1;x2,y2;...\",\n");
+    printf("                       in cells, in the primitive library; \"arrow\" for the designer's\n");
+    printf("                       arrow or \"none\" to skip (default arrow)\n");
+    printf("      --sample-resolution D\n");
+    printf("                       space intermediate poses at most D cells apart (default: legacy density)\n");
+    printf("  -g, --generator NAME curve generator, one of:");
+    for (const std::string& name : motion_generator_names()) {
+        printf(" %s", name.c_str());
+    }
+    printf(" (default %s)\n", motion_generator_names().front().c_str());
+    printf("      --turning-radius R\n");
+    printf("                       turning radius in cells for generators with a fixed one (default 1)\n");
+    printf("  -s, --symmetry       solve only the canonical headings and derive the rest by lattice symmetry\n");
+    printf("      --verify-symmetry\n");
+    printf("                       also solve the derived headings directly and report any that differ\n");
+    printf("      --prune RATIO    drop primitives that a chain of cheaper kept primitives\n");
+    printf("                       reproduces within RATIO times their cost\n");
+    printf("  -v, --verbose        print the number of primitives per start heading\n");
+    printf("  -h, --help           print this message\n");
+}
+
+int main(int argc, char* argv[])
+{
+    LatticeParams params;
+    int num_threads = 0;
+    bool verbose = false;
+    std::string mprim_path;
+    double resolution = 0.025;
+    bool use_symmetry = false;
+    bool verify_symmetry = false;
+    std::string generator_name = motion_generator_names().front();
+    MotionGeneratorParams generator_params;
+    bool prune = false;
+    PruneParams prune_params;
+    Footprint footprint = arrow_footprint();
+
+    enum { OPT_VERIFY_SYMMETRY = 256, OPT_RESOLUTION, OPT_SAMPLE_RESOLUTION, OPT_TURNING_RADIUS, OPT_PRUNE, OPT_FOOTPRINT };
+
+    const struct option long_options[] =
+    {
+        { "num-angles", required_argument, 0, 'n' },
+        { "extent",     required_argument, 0, 'e' },
+        { "min-radius", required_argument, 0, 'r' },
+        { "max-radius", required_argument, 0, 'R' },
+        { "threads",    required_argument, 0, 'j' },
+        { "output",     required_argument, 0, 'o' },
+        { "resolution", required_argument, 0, OPT_RESOLUTION },
+        { "sample-resolution", required_argument, 0, OPT_SAMPLE_RESOLUTION },
+        { "generator",  required_argument, 0, 'g' },
+        { "turning-radius", required_argument, 0, OPT_TURNING_RADIUS },
+        { "symmetry",   no_argument,       0, 's' },
+        { "verify-symmetry", no_argument,  0, OPT_VERIFY_SYMMETRY },
+        { "prune",      required_argument, 0, OPT_PRUNE },
+        { "footprint",  required_argument, 0, OPT_FOOTPRINT },
+        { "verbose",    no_argument,       0, 'v' },
+        { "help",       no_argument,       0, 'h' },
+        { 0, 0, 0, 0 }
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "n:e:r:R:j:o:g:svh", long_options, 0)) != -1) {
+        switch (opt) {
+        case 'n':
+            params.num_angles = atoi(optarg);
+            break;
+        case 'e':
+            params.extent = atoi(optarg);
+            break;
+        case 'r':
+            params.min_radius = atof(optarg);
+            break;
+        case 'R':
+            params.max_radius = atof(optarg);
+            break;
+        case 'j':
+            num_threads = atoi(optarg);
+            break;
+        case 'o':
+            mprim_path = optarg;
+            break;
+        case OPT_RESOLUTION:
+            resolution = atof(optarg);
+            break;
+        case OPT_SAMPLE_RESOLUTION:
+            params.sample_resolution = atof(optarg);
+            break;
+        case 'g':
+            generator_name = optarg;
+            break;
+        case OPT_TURNING_RADIUS:
+            generator_params.turning_radius = atof(optarg);
+            break;
+        case 's':
+            use_symmetry = true;
+            break;
+        case OPT_VERIFY_SYMMETRY:
+            use_symmetry = true;
+            verify_symmetry = true;
+            break;
+        case OPT_PRUNE:
+            prune = true;
+            prune_params.cost_ratio = atof(optarg);
+            break;
+        case OPT_FOOTPRINT:
+            if (std::string(optarg) == "arrow") {
+                footprint = arrow_footprint();
+            }
+            else if (std::string(optarg) == "none") {
+                footprint.clear();
+            }
+            else if (!parse_footprint(optarg, footprint)) {
+                fprintf(stderr, "Malformed footprint '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (params.num_angles <= 0 || params.extent < 0) {
+        fprintf(stderr, "num_angles must be positive and extent non-negative\n");
+        return 1;
+    }
+
+    if (!(generator_params.turning_radius > 0.0)) {
+        fprintf(stderr, "turning radius must be positive\n");
+        return 1;
+    }
+
+    if (prune && prune_params.cost_ratio < 1.0) {
+        fprintf(stderr, "prune ratio must be at least 1\n");
+        return 1;
+    }
+
+    if (params.sample_resolution < 0.0) {
+        fprintf(stderr, "sample resolution must be non-negative\n");
+        return 1;
+    }
+
+    std::unique_ptr<MotionGenerator> generator = create_motion_generator(generator_name, generator_params);
+    if (!generator) {
+        fprintf(stderr, "Unknown generator '%s'\n", generator_name.c_str());
+        return 1;
+    }
+
+    WorkStealingPool pool(num_threads);
+
+    // swept cells are only stored in the library, so skip them without one
+    const bool sweep = !mprim_path.empty() && !footprint.empty();
+    if (!sweep) {
+        footprint.clear();
+    }
+
+    PrimitiveExporter exporter;
+    if (!mprim_path.empty() && !exporter.open(mprim_path, resolution, params.num_angles, footprint)) {
+        fprintf(stderr, "Failed to open %s for writing\n", mprim_path.c_str());
+        return 1;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    PrimitiveSet canonical;
+    if (use_symmetry) {
+        canonical = generate_canonical_primitives(*generator, params, pool);
+    }
+
+    // only one start heading's primitives are held at a time, in storage
+    // that is reused from one heading to the next, unless pruning needs them all
+    PrimitiveSet primitives;
+    PrimitiveSet all_primitives;
+    std::vector<int> start_angle(1);
+    std::vector<std::size_t> num_per_angle(params.num_angles, 0);
+    std::size_t num_primitives = 0;
+    std::size_t num_poses = 0;
+    std::size_t num_cells = 0;
+    for (int a = 0; a < params.num_angles; ++a) {
+        if (use_symmetry) {
+            expand_canonical_primitives(params, canonical, a, primitives);
+        }
+        else {
+            start_angle[0] = a;
+            generator->generate_lattice_primitives(params, start_angle, pool, primitives);
+        }
+
+        if (prune) {
+            all_primitives.append(primitives);
+            continue;
+        }
+
+        if (sweep) {
+            compute_swept_cells(primitives, footprint, pool);
+        }
+        if (exporter.is_open()) {
+            exporter.write(primitives);
+        }
+        num_poses += primitives.poses.size();
+        num_cells += primitives.cells.size();
+        num_per_angle[a] = primitives.size();
+        num_primitives += primitives.size();
+    }
+
+    PruneReport prune_report;
+    if (prune) {
+        prune_primitive_set(all_primitives, params.num_angles, prune_params, pool, primitives, prune_report);
+        if (sweep) {
+            compute_swept_cells(primitives, footprint, pool);
+        }
+        if (exporter.is_open()) {
+            exporter.write(primitives);
+        }
+        num_poses = primitives.poses.size();
+        num_cells = primitives.cells.size();
+        num_per_angle = prune_report.num_kept;
+        num_primitives = primitives.size();
+    }
+
+    if (exporter.is_open() && !exporter.close()) {
+        fprintf(stderr, "Failed to write %s\n", mprim_path.c_str());
+        return 1;
+    }
+
+    auto end_time = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(end_time - start_time).count();
+
+    if (verbose) {
+        for (int a = 0; a < params.num_angles; ++a) {
+            printf("start angle %3d: %zu primitives\n", a, num_per_angle[a]);
+        }
+    }
+
+    const std::size_t num_pairs = num_lattice_goals(params) * params.num_angles;
+    printf("%zu primitives (%zu intermediate poses) from %zu (start, goal) pairs\n", num_primitives, num_poses, num_pairs);
+    printf("%d threads, %0.3f s, %0.0f pairs/s\n", pool.num_threads(), elapsed, num_pairs / elapsed);
+    if (sweep) {
+        printf("%zu swept cells by a %zu-vertex footprint, %0.1f per primitive\n",
+                num_cells, footprint.size(), num_primitives ? (double)num_cells / num_primitives : 0.0);
+    }
+
+    if (use_symmetry) {
+        std::size_t num_canonical = canonical_headings(params.num_angles).size();
+        printf("solved %zu canonical headings (%zu primitives) under %d lattice symmetries\n",
+                num_canonical, canonical.size(), num_lattice_symmetries(params.num_angles));
+    }
+
+    if (prune) {
+        printf("pruned %zu primitives to %zu at cost ratio %g in %zu cost bands (%zu states expanded, %zu searches aborted)\n",
+                prune_report.total_input, prune_report.total_kept, prune_params.cost_ratio,
+                prune_report.num_bands, prune_report.num_expansions, prune_report.num_aborted);
+        printf("removed primitives are reproduced at %0.3f times their cost on average, %0.3f at worst\n",
+                prune_report.mean_stretch, prune_report.max_stretch);
+        if (verbose) {
+            for (int a = 0; a < params.num_angles; ++a) {
+                printf("start angle %3d: kept %zu of %zu\n", a, prune_report.num_kept[a], prune_report.num_input[a]);
+            }
+        }
+    }
+
+    if (verify_symmetry) {
+        const double pose_tolerance = 1e-6;
+        std::vector<SymmetryMismatch> mismatches = verify_lattice_symmetry(*generator, params, canonical, pose_tolerance, pool);
+        for (const SymmetryMismatch& m : mismatches) {
+            printf("start angle %3d (from %d): %zu missing, %zu extra, %zu with differing poses (max error %g)\n",
+                    m.start_angle, m.canonical_angle, m.num_missing, m.num_extra, m.num_pose_mismatches, m.max_pose_error);
+        }
+        if (!mismatches.empty()) {
+            printf("symmetry fails for %zu of %d headings\n", mismatches.size(), params.num_angles);
+            return 2;
+        }
+        printf("symmetry holds exactly for %d headings\n", params.num_angles);
+    }
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include "heuristic_table.h"
+#include "lattice_graph.h"
+#include "primitive_library.h"
+#include "work_stealing_pool.h"
+
+static void print_usage(const char* prog)
+{
+    printf("usage: %s [options] LIBRARY\n", prog);
+    printf("\n");
+    printf("Build a free-space cost-to-go lookup table for the primitives in LIBRARY, a\n");
+    printf("binary primitive library written by mprimgen.\n");
+    printf("\n");
+    printf("  -o, --output FILE    write the table to FILE (default: LIBRARY with a .mprimheur extension)\n");
+    printf("  -R, --radius R       cover states within R cells of the goal in x and y (default 32)\n");
+    printf("  -m, --margin M       search M cells past the radius; costs are exact up to about\n");
+    printf("                       R + M cells of path length and saturate beyond (default R)\n");
+    printf("  -j, --threads N      number of worker threads (default: one per core)\n");
+    printf("      --verify         check the written table against forward searches\n");
+    printf("  -h, --help           print this message\n");
+}
+
+static std::string heuristic_table_path(const std::string& library_path)
+{
+    const std::string ext = ".mprimlib";
+    if (library_path.size() >= ext.size() && library_path.compare(library_path.size() - ext.size(), ext.size(), ext) == 0) {
+        return library_path.substr(0, library_path.size() - ext.size()) + ".mprimheur";
+    }
+    return library_path + ".mprimheur";
+}
+
+int main(int argc, char* argv[])
+{
+    HeuristicTableParams params;
+    int num_threads = 0;
+    bool verify = false;
+    std::string output_path;
+
+    enum { OPT_VERIFY = 256 };
+
+    const struct option long_options[] =
+    {
+        { "output",     required_argument, 0, 'o' },
+        { "radius",     required_argument, 0, 'R' },
+        { "margin",     required_argument, 0, 'm' },
+        { "threads",    required_argument, 0, 'j' },
+        { "verify",     no_argument,       0, OPT_VERIFY },
+        { "help",       no_argument,       0, 'h' },
+        { 0, 0, 0, 0 }
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "o:R:m:j:h", long_options, 0)) != -1) {
+        switch (opt) {
+        case 'o':
+            output_path = optarg;
+            break;
+        case 'R':
+            params.radius = atoi(optarg);
+            break;
+        case 'm':
+            params.margin = atoi(optarg);
+            break;
+        case 'j':
+            num_threads = atoi(optarg);
+            break;
+        case OPT_VERIFY:
+            verify = true;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (optind != argc - 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (params.radius < 0) {
+        fprintf(stderr, "radius must be non-negative\n");
+        return 1;
+    }
+
+    const std::string library_path = argv[optind];
+    if (output_path.empty()) {
+        output_path = heuristic_table_path(library_path);
+    }
+
+    PrimitiveLibrary library;
+    if (!library.open(library_path)) {
+        fprintf(stderr, "Failed to open primitive library %s\n", library_path.c_str());
+        return 1;
+    }
+
+    LatticeEdges edges;
+    lattice_edges(library, edges);
+
+    WorkStealingPool pool(num_threads);
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    std::vector<uint32_t> costs;
+    uint32_t max_cost;
+    HeuristicTableReport report;
+    build_heuristic_table(edges, params, pool, costs, max_cost, report);
+
+    auto end_time = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(end_time - start_time).count();
+
+    if (!write_heuristic_table(output_path, library.num_angles(), params.radius, max_cost, costs)) {
+        fprintf(stderr, "Failed to write %s\n", output_path.c_str());
+        return 1;
+    }
+
+    printf("%zu entries (%zu bytes) for %zu primitives over %d headings within %d cells\n",
+            costs.size(), costs.size() * sizeof(uint32_t), library.num_primitives(), library.num_angles(), params.radius);
+    printf("%zu exact, %zu saturated at cost %u\n", report.num_exact, report.num_saturated, max_cost);
+    printf("%d threads, %0.3f s, %zu states expanded\n", pool.num_threads(), elapsed, report.num_expansions);
+
+    if (verify) {
+        HeuristicTable table;
+        if (!table.open(output_path)) {
+            fprintf(stderr, "Failed to map %s\n", output_path.c_str());
+            return 1;
+        }
+        std::size_t num_mismatches = verify_heuristic_table(edges, table, params, pool);
+        printf("verification %s: %zu entries differ from forward searches\n", num_mismatches ? "fails" : "passes", num_mismatches);
+        if (num_mismatches) {
+            return 2;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include "lattice_graph.h"
+#include "primitive_library.h"
+#include "reachability.h"
+#include "work_stealing_pool.h"
+
+static void print_usage(const char* prog)
+{
+    printf("usage: %s [options] LIBRARY\n", prog);
+    printf("\n");
+    printf("Report which lattice states the primitives in LIBRARY, a binary primitive\n");
+    printf("library written by mprimgen, reach from each start heading within a bounded\n");
+    printf("number of steps, and whether every heading can be turned into every other.\n");
+    printf("\n");
+    printf("  -R, --radius R       analyze states within R cells of the start (default 10)\n");
+    printf("  -N, --steps N        chain at most N primitives (default 8)\n");
+    printf("  -a, --start-angle A  analyze only start heading A (default: every heading)\n");
+    printf("  -j, --threads N      number of worker threads (default: one per core)\n");
+    printf("  -v, --verbose        print the states reached after each step\n");
+    printf("  -h, --help           print this message\n");
+}
+
+int main(int argc, char* argv[])
+{
+    ReachabilityParams params;
+    int start_angle = -1;
+    int num_threads = 0;
+    bool verbose = false;
+
+    const struct option long_options[] =
+    {
+        { "radius",     required_argument, 0, 'R' },
+        { "steps",      required_argument, 0, 'N' },
+        { "start-angle", required_argument, 0, 'a' },
+        { "threads",    required_argument, 0, 'j' },
+        { "verbose",    no_argument,       0, 'v' },
+        { "help",       no_argument,       0, 'h' },
+        { 0, 0, 0, 0 }
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "R:N:a:j:vh", long_options, 0)) != -1) {
+        switch (opt) {
+        case 'R':
+            params.radius = atoi(optarg);
+            break;
+        case 'N':
+            params.max_steps = atoi(optarg);
+            break;
+        case 'a':
+            start_angle = atoi(optarg);
+            break;
+        case 'j':
+            num_threads = atoi(optarg);
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (optind != argc - 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (params.radius < 0 || params.max_steps < 0 || params.max_steps > REACH_MAX_STEPS) {
+        fprintf(stderr, "radius must be non-negative and steps within [0, %d]\n", REACH_MAX_STEPS);
+        return 1;
+    }
+
+    PrimitiveLibrary library;
+    if (!library.open(argv[optind])) {
+        fprintf(stderr, "Failed to open primitive library %s\n", argv[optind]);
+        return 1;
+    }
+
+    if (start_angle >= library.num_angles()) {
+        fprintf(stderr, "start angle must be less than %d\n", library.num_angles());
+        return 1;
+    }
+
+    LatticeEdges edges;
+    lattice_edges(library, edges);
+
+    WorkStealingPool pool(num_threads);
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    bool complete = true;
+    ReachabilityResult result;
+    for (int a = 0; a < library.num_angles(); ++a) {
+        if (start_angle >= 0 && a != start_angle) {
+            continue;
+        }
+
+        lattice_reachability(edges, a, params, pool, result);
+
+        const std::size_t num_states = result.reached.num_states();
+        const std::size_t num_reached = result.num_reached.back();
+        const int num_steps = (int)result.num_reached.size() - 1;
+        printf("start angle %3d: reached %zu of %zu states (%0.1f%%) %s %d steps\n",
+                a, num_reached, num_states, 100.0 * num_reached / num_states,
+                result.complete() ? "after" : "within", result.complete() ? num_steps : params.max_steps);
+        if (verbose) {
+            for (int k = 0; k <= num_steps; ++k) {
+                printf("    %3d steps: %zu\n", k, result.num_reached[k]);
+            }
+        }
+        complete &= result.complete();
+    }
+
+    auto end_time = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(end_time - start_time).count();
+
+    std::vector<int> component;
+    const int num_components = heading_components(edges, component);
+    if (num_components == 1) {
+        printf("heading transitions are strongly connected\n");
+    }
+    else {
+        printf("heading transitions split into %d strongly connected components:\n", num_components);
+        for (int c = 0; c < num_components; ++c) {
+            printf("    ");
+            for (int a = 0; a < library.num_angles(); ++a) {
+                if (component[a] == c) {
+                    printf(" %d", a);
+                }
+            }
+            printf("\n");
+        }
+    }
+
+    printf("%d threads, %0.3f s\n", pool.num_threads(), elapsed);
+
+    return complete && num_components == 1 ? 0 : 2;
+}
@@ -0,0 +1,84 @@
+#include "occupancy_grid.h"
+#include <algorithm>
+#include <random>
+
+void make_random_grid(int width, int height, double density, unsigned seed, OccupancyGrid& grid)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    grid.resize(width, height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            grid.set(x, y, uniform(rng) < density);
+        }
+    }
+}
+
+void make_maze_grid(int width, int height, int corridor_width, unsigned seed, OccupancyGrid& grid)
+{
+    grid.resize(width, height);
+    for (std::size_t i = 0; i < grid.cells.size(); ++i) {
+        grid.cells[i] = 1;
+    }
+
+    // rooms are corridor_width cells square, with a wall cell before each
+    const int pitch = corridor_width + 1;
+    const int rooms_x = (width - 1) / pitch;
+    const int rooms_y = (height - 1) / pitch;
+    if (rooms_x <= 0 || rooms_y <= 0) {
+        return;
+    }
+
+    auto carve = [&](int x0, int y0, int w, int h)
+    {
+        for (int y = y0; y < y0 + h; ++y) {
+            for (int x = x0; x < x0 + w; ++x) {
+                grid.set(x, y, false);
+            }
+        }
+    };
+
+    // depth-first backtracking over the rooms
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> visited(rooms_x * rooms_y, 0);
+    std::vector<int> stack(1, 0);
+    visited[0] = 1;
+    carve(1, 1, corridor_width, corridor_width);
+    while (!stack.empty()) {
+        const int room = stack.back();
+        const int rx = room % rooms_x;
+        const int ry = room / rooms_x;
+
+        int neighbors[4];
+        int num_neighbors = 0;
+        const int offsets[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+        for (int k = 0; k < 4; ++k) {
+            const int nx = rx + offsets[k][0];
+            const int ny = ry + offsets[k][1];
+            if (nx >= 0 && nx < rooms_x && ny >= 0 && ny < rooms_y && !visited[ny * rooms_x + nx]) {
+                neighbors[num_neighbors++] = k;
+            }
+        }
+
+        if (num_neighbors == 0) {
+            stack.pop_back();
+            continue;
+        }
+
+        const int k = neighbors[std::uniform_int_distribution<int>(0, num_neighbors - 1)(rng)];
+        const int nx = rx + offsets[k][0];
+        const int ny = ry + offsets[k][1];
+        visited[ny * rooms_x + nx] = 1;
+        stack.push_back(ny * rooms_x + nx);
+
+        // open the room and the wall between it and the current one
+        const int x0 = 1 + std::min(rx, nx) * pitch;
+        const int y0 = 1 + std::min(ry, ny) * pitch;
+        if (offsets[k][0] != 0) {
+            carve(x0, y0, corridor_width + pitch, corridor_width);
+        }
+        else {
+            carve(x0, y0, corridor_width, corridor_width + pitch);
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef occupancy_grid_h
+#define occupancy_grid_h
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+/// A 2D grid of free and occupied cells, cell (x, y) at x + y * width
+struct OccupancyGrid
+{
+    OccupancyGrid() : width(0), height(0) { }
+
+    int width;
+    int height;
+    std::vector<uint8_t> cells;     ///< nonzero if occupied
+
+    void resize(int w, int h) { width = w; height = h; cells.assign((std::size_t)w * h, 0); }
+
+    bool in_bounds(int x, int y) const { return x >= 0 && x < width && y >= 0 && y < height; }
+
+    /// Return whether (x, y) is occupied; cells outside the grid are
+    bool occupied(int x, int y) const { return !in_bounds(x, y) || cells[(std::size_t)y * width + x] != 0; }
+
+    void set(int x, int y, bool occupied) { cells[(std::size_t)y * width + x] = occupied ? 1 : 0; }
+};
+
+/// Fill $grid with $width x $height cells, each occupied with probability $density
+void make_random_grid(int width, int height, double density, unsigned seed, OccupancyGrid& grid);
+
+/// Fill $grid with a perfect maze of corridors $corridor_width cells wide,
+/// separated by walls one cell thick, within a $width x $height border
+void make_maze_grid(int width, int height, int corridor_width, unsigned seed, OccupancyGrid& grid);
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef pinv_h
+#define pinv_h
+
+#include <Eigen/Dense>
+
+/// Store the Moore-Penrose pseudo-inverse of $a in $a_pinv, treating singular
+/// values within 1e-10 of 0 as 0
+bool pinv(const Eigen::Matrix2d& a, Eigen::Matrix2d& a_pinv);
+
+#endif
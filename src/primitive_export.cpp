@@ -0,0 +1,45 @@
+#include "primitive_export.h"
+#include "lattice_primitives.h"
+
+bool PrimitiveExporter::open(const std::string& mprim_path, double resolution, int num_angles, const Footprint& footprint)
+{
+    library_path_ = primitive_library_path(mprim_path);
+    if (!mprim_writer_.open(mprim_path, resolution, num_angles)) {
+        return false;
+    }
+    if (!library_writer_.open(library_path_, resolution, num_angles, footprint)) {
+        mprim_writer_.close();
+        return false;
+    }
+    return true;
+}
+
+bool PrimitiveExporter::write(
+    int start_angle,
+    const Pose2_disc& end,
+    const Pose2_cont* poses,
+    std::size_t num_poses,
+    const CellOffset* cells,
+    std::size_t num_cells)
+{
+    bool ok = mprim_writer_.write(start_angle, end, poses, num_poses);
+    ok &= library_writer_.write(start_angle, end, poses, num_poses, cells, num_cells);
+    return ok;
+}
+
+bool PrimitiveExporter::write(const PrimitiveSet& primitives)
+{
+    for (const MotionPrimitive& p : primitives.primitives) {
+        if (!write(p.start_angle, p.end, primitives.poses_of(p), p.num_poses, primitives.cells_of(p), p.num_cells)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PrimitiveExporter::close()
+{
+    bool ok = mprim_writer_.close();
+    ok &= library_writer_.close();
+    return ok;
+}
@@ -0,0 +1,47 @@
+#ifndef primitive_export_h
+#define primitive_export_h
+
+#include <cstddef>
+#include <string>
+#include "Pose2.h"
+#include "mprim_writer.h"
+#include "primitive_library.h"
+
+struct PrimitiveSet;
+
+/// Writes a primitive set as an SBPL .mprim text file and, next to it, a
+/// binary primitive library at primitive_library_path()
+class PrimitiveExporter
+{
+public:
+
+    /// Open both files; $footprint is recorded in the library alongside the swept cells
+    bool open(const std::string& mprim_path, double resolution, int num_angles, const Footprint& footprint = Footprint());
+
+    /// Append a primitive; primitives must be written grouped by start heading.
+    /// Swept cells are only stored in the library.
+    bool write(
+        int start_angle,
+        const Pose2_disc& end,
+        const Pose2_cont* poses,
+        std::size_t num_poses,
+        const CellOffset* cells = 0,
+        std::size_t num_cells = 0);
+
+    /// Append every primitive in $primitives
+    bool write(const PrimitiveSet& primitives);
+
+    bool close();
+
+    bool is_open() const { return mprim_writer_.is_open(); }
+
+    const std::string& library_path() const { return library_path_; }
+
+private:
+
+    MprimWriter mprim_writer_;
+    PrimitiveLibraryWriter library_writer_;
+    std::string library_path_;
+};
+
+#endif
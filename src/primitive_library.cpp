@@ -0,0 +1,273 @@
+#include "primitive_library.h"
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "lattice_primitives.h"
+
+int32_t primitive_cost(const Pose2_cont* poses, std::size_t num_poses)
+{
+    double length = 0.0;
+    for (std::size_t i = 1; i < num_poses; ++i) {
+        length += hypot(poses[i].x - poses[i - 1].x, poses[i].y - poses[i - 1].y);
+    }
+    return (int32_t)std::lround(length * PRIMITIVE_COST_SCALE);
+}
+
+std::string primitive_library_path(const std::string& mprim_path)
+{
+    const std::string ext = ".mprim";
+    if (mprim_path.size() >= ext.size() && mprim_path.compare(mprim_path.size() - ext.size(), ext.size(), ext) == 0) {
+        return mprim_path.substr(0, mprim_path.size() - ext.size()) + ".mprimlib";
+    }
+    return mprim_path + ".mprimlib";
+}
+
+PrimitiveLibraryWriter::PrimitiveLibraryWriter() :
+    file_(0),
+    cells_file_(0),
+    ok_(false),
+    current_start_angle_(-1)
+{
+}
+
+PrimitiveLibraryWriter::~PrimitiveLibraryWriter()
+{
+    if (file_) {
+        close();
+    }
+}
+
+bool PrimitiveLibraryWriter::open(const std::string& path, double resolution, int num_angles, const Footprint& footprint)
+{
+    if (file_) {
+        close();
+    }
+
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) {
+        return false;
+    }
+    setvbuf(file_, 0, _IOFBF, 1 << 22);
+
+    // cells are interleaved with poses as primitives arrive but stored after
+    // them, so they are spooled to a scratch file until close()
+    cells_file_ = tmpfile();
+    if (!cells_file_) {
+        fclose(file_);
+        file_ = 0;
+        return false;
+    }
+
+    memset(&header_, 0, sizeof(header_));
+    memcpy(header_.magic, PRIMITIVE_LIBRARY_MAGIC, sizeof(header_.magic));
+    header_.version = PRIMITIVE_LIBRARY_VERSION;
+    header_.num_angles = (uint32_t)num_angles;
+    header_.resolution = resolution;
+    header_.poses_offset = sizeof(PrimitiveLibraryHeader);
+    header_.num_footprint_vertices = footprint.size();
+
+    footprint_ = footprint;
+    records_.clear();
+    index_.assign(num_angles, PrimitiveIndexEntry());
+    current_start_angle_ = -1;
+
+    // placeholder; the offsets are only known once every pose is written
+    ok_ = fwrite(&header_, sizeof(header_), 1, file_) == 1;
+    return ok_;
+}
+
+bool PrimitiveLibraryWriter::write(
+    int start_angle,
+    const Pose2_disc& end,
+    const Pose2_cont* poses,
+    std::size_t num_poses,
+    const CellOffset* cells,
+    std::size_t num_cells)
+{
+    if (!file_ || start_angle < 0 || start_angle < current_start_angle_ || start_angle >= (int)header_.num_angles) {
+        return false;
+    }
+
+    if (start_angle != current_start_angle_) {
+        current_start_angle_ = start_angle;
+        index_[start_angle].first_primitive = records_.size();
+    }
+
+    PrimitiveRecord record;
+    record.dx = end.x;
+    record.dy = end.y;
+    record.end_angle = end.yaw;
+    record.cost = primitive_cost(poses, num_poses);
+    record.first_pose = header_.num_poses;
+    record.num_poses = (uint32_t)num_poses;
+    record.num_cells = (uint32_t)num_cells;
+    record.first_cell = header_.num_cells;
+    records_.push_back(record);
+    ++index_[start_angle].num_primitives;
+
+    if (num_poses > 0 && fwrite(poses, sizeof(Pose2_cont), num_poses, file_) != num_poses) {
+        ok_ = false;
+    }
+    if (num_cells > 0 && fwrite(cells, sizeof(CellOffset), num_cells, cells_file_) != num_cells) {
+        ok_ = false;
+    }
+    header_.num_poses += num_poses;
+    header_.num_cells += num_cells;
+    return ok_;
+}
+
+bool PrimitiveLibraryWriter::write(const PrimitiveSet& primitives)
+{
+    for (const MotionPrimitive& p : primitives.primitives) {
+        if (!write(p.start_angle, p.end, primitives.poses_of(p), p.num_poses, primitives.cells_of(p), p.num_cells)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PrimitiveLibraryWriter::close()
+{
+    if (!file_) {
+        return false;
+    }
+
+    header_.num_primitives = records_.size();
+    header_.cells_offset = header_.poses_offset + header_.num_poses * sizeof(Pose2_cont);
+    header_.footprint_offset = header_.cells_offset + header_.num_cells * sizeof(CellOffset);
+    header_.primitives_offset = header_.footprint_offset + header_.num_footprint_vertices * sizeof(FootprintVertex);
+    header_.index_offset = header_.primitives_offset + header_.num_primitives * sizeof(PrimitiveRecord);
+
+    if (fseek(cells_file_, 0, SEEK_SET) != 0) {
+        ok_ = false;
+    }
+    char buffer[1 << 16];
+    std::size_t count;
+    while (ok_ && (count = fread(buffer, 1, sizeof(buffer), cells_file_)) > 0) {
+        if (fwrite(buffer, 1, count, file_) != count) {
+            ok_ = false;
+        }
+    }
+    fclose(cells_file_);
+    cells_file_ = 0;
+
+    if (!footprint_.empty() && fwrite(footprint_.data(), sizeof(FootprintVertex), footprint_.size(), file_) != footprint_.size()) {
+        ok_ = false;
+    }
+
+    if (!records_.empty() && fwrite(records_.data(), sizeof(PrimitiveRecord), records_.size(), file_) != records_.size()) {
+        ok_ = false;
+    }
+    if (!index_.empty() && fwrite(index_.data(), sizeof(PrimitiveIndexEntry), index_.size(), file_) != index_.size()) {
+        ok_ = false;
+    }
+    if (fseek(file_, 0, SEEK_SET) != 0 || fwrite(&header_, sizeof(header_), 1, file_) != 1) {
+        ok_ = false;
+    }
+    if (fclose(file_) != 0) {
+        ok_ = false;
+    }
+
+    file_ = 0;
+    records_.clear();
+    index_.clear();
+    footprint_.clear();
+    return ok_;
+}
+
+PrimitiveLibrary::PrimitiveLibrary() :
+    data_(0),
+    size_(0),
+    header_(0),
+    poses_(0),
+    cells_(0),
+    footprint_(0),
+    primitives_(0),
+    index_(0)
+{
+}
+
+PrimitiveLibrary::~PrimitiveLibrary()
+{
+    close();
+}
+
+/// Return whether [$offset, $offset + $count * $stride) lies within a file of $size bytes
+static bool section_fits(uint64_t offset, uint64_t count, uint64_t stride, std::size_t size)
+{
+    return offset % 8 == 0 && offset <= size && count <= (size - offset) / stride;
+}
+
+bool PrimitiveLibrary::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (std::size_t)st.st_size < sizeof(PrimitiveLibraryHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    data_ = data;
+    size_ = st.st_size;
+
+    const char* base = (const char*)data_;
+    header_ = (const PrimitiveLibraryHeader*)base;
+
+    if (memcmp(header_->magic, PRIMITIVE_LIBRARY_MAGIC, sizeof(header_->magic)) != 0 ||
+        header_->version != PRIMITIVE_LIBRARY_VERSION ||
+        !section_fits(header_->poses_offset, header_->num_poses, sizeof(Pose2_cont), size_) ||
+        !section_fits(header_->cells_offset, header_->num_cells, sizeof(CellOffset), size_) ||
+        !section_fits(header_->footprint_offset, header_->num_footprint_vertices, sizeof(FootprintVertex), size_) ||
+        !section_fits(header_->primitives_offset, header_->num_primitives, sizeof(PrimitiveRecord), size_) ||
+        !section_fits(header_->index_offset, header_->num_angles, sizeof(PrimitiveIndexEntry), size_))
+    {
+        close();
+        return false;
+    }
+
+    poses_ = (const Pose2_cont*)(base + header_->poses_offset);
+    cells_ = (const CellOffset*)(base + header_->cells_offset);
+    footprint_ = (const FootprintVertex*)(base + header_->footprint_offset);
+    primitives_ = (const PrimitiveRecord*)(base + header_->primitives_offset);
+    index_ = (const PrimitiveIndexEntry*)(base + header_->index_offset);
+
+    for (uint32_t a = 0; a < header_->num_angles; ++a) {
+        const PrimitiveIndexEntry& entry = index_[a];
+        if (entry.first_primitive > header_->num_primitives || entry.num_primitives > header_->num_primitives - entry.first_primitive) {
+            close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void PrimitiveLibrary::close()
+{
+    if (data_) {
+        munmap(data_, size_);
+    }
+    data_ = 0;
+    size_ = 0;
+    header_ = 0;
+    poses_ = 0;
+    cells_ = 0;
+    footprint_ = 0;
+    primitives_ = 0;
+    index_ = 0;
+}
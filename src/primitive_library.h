@@ -0,0 +1,169 @@
+#ifndef primitive_library_h
+#define primitive_library_h
+
+#include <cstddef>
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "footprint.h"
+#include "Pose2.h"
+
+struct PrimitiveSet;
+
+/// On-disk layout of a binary primitive library. All fields are native endian
+/// and every section starts on an 8-byte boundary, so a mapped file can be
+/// used in place:
+///
+///     PrimitiveLibraryHeader
+///     Pose2_cont             poses[num_poses]
+///     CellOffset             cells[num_cells]
+///     FootprintVertex        footprint[num_footprint_vertices]
+///     PrimitiveRecord        primitives[num_primitives]   (grouped by start heading)
+///     PrimitiveIndexEntry    index[num_angles]
+struct PrimitiveLibraryHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t num_angles;
+    double resolution;
+    uint64_t num_primitives;
+    uint64_t num_poses;
+    uint64_t poses_offset;
+    uint64_t primitives_offset;
+    uint64_t index_offset;
+    uint64_t num_cells;
+    uint64_t cells_offset;
+    uint64_t num_footprint_vertices;    ///< 0 if no swept cells were computed
+    uint64_t footprint_offset;
+};
+
+/// A primitive's end cell offset and heading, cost, intermediate poses, and
+/// the cells its footprint sweeps, sorted by dx and then dy
+struct PrimitiveRecord
+{
+    int32_t dx;
+    int32_t dy;
+    int32_t end_angle;
+    int32_t cost;           ///< path length in cells, times PRIMITIVE_COST_SCALE
+    uint64_t first_pose;
+    uint32_t num_poses;
+    uint32_t num_cells;
+    uint64_t first_cell;
+};
+
+/// The primitives for one start heading
+struct PrimitiveIndexEntry
+{
+    uint64_t first_primitive;
+    uint64_t num_primitives;
+};
+
+static const char PRIMITIVE_LIBRARY_MAGIC[8] = { 'M', 'P', 'R', 'I', 'M', 'L', 'I', 'B' };
+static const uint32_t PRIMITIVE_LIBRARY_VERSION = 2;
+
+/// Integer costs keep sums of primitive costs exact
+static const int PRIMITIVE_COST_SCALE = 1000;
+
+/// Return the integer cost of the path through $poses
+int32_t primitive_cost(const Pose2_cont* poses, std::size_t num_poses);
+
+/// Return the library path written alongside the .mprim file at $mprim_path
+std::string primitive_library_path(const std::string& mprim_path);
+
+/// Streams primitives to a binary primitive library. Poses go straight to
+/// disk and cells to a temporary file; only the fixed-size primitive records
+/// are held in memory until close().
+class PrimitiveLibraryWriter
+{
+public:
+
+    PrimitiveLibraryWriter();
+    ~PrimitiveLibraryWriter();
+
+    /// Open $path for writing primitives whose swept cells, if any, were computed with $footprint
+    bool open(const std::string& path, double resolution, int num_angles, const Footprint& footprint = Footprint());
+
+    /// Append a primitive; primitives must be written grouped by start heading,
+    /// in increasing order. Return false for a heading out of [0, num_angles).
+    bool write(
+        int start_angle,
+        const Pose2_disc& end,
+        const Pose2_cont* poses,
+        std::size_t num_poses,
+        const CellOffset* cells = 0,
+        std::size_t num_cells = 0);
+
+    /// Append every primitive in $primitives
+    bool write(const PrimitiveSet& primitives);
+
+    /// Write the cells, footprint, primitive records and index, patch the header and close the file
+    bool close();
+
+    bool is_open() const { return file_ != 0; }
+
+private:
+
+    FILE* file_;
+    FILE* cells_file_;
+    bool ok_;
+    PrimitiveLibraryHeader header_;
+    Footprint footprint_;
+    std::vector<PrimitiveRecord> records_;
+    std::vector<PrimitiveIndexEntry> index_;
+    int current_start_angle_;
+
+    PrimitiveLibraryWriter(const PrimitiveLibraryWriter&);
+    PrimitiveLibraryWriter& operator=(const PrimitiveLibraryWriter&);
+};
+
+/// Read-only view of a memory-mapped primitive library
+class PrimitiveLibrary
+{
+public:
+
+    PrimitiveLibrary();
+    ~PrimitiveLibrary();
+
+    /// Map the library at $path and validate its header and index. Primitive
+    /// records are not visited, so opening costs the same for any library size.
+    bool open(const std::string& path);
+    void close();
+
+    bool is_open() const { return data_ != 0; }
+
+    int num_angles() const { return (int)header_->num_angles; }
+    double resolution() const { return header_->resolution; }
+    std::size_t num_primitives() const { return (std::size_t)header_->num_primitives; }
+
+    /// Return the primitives starting at discrete heading $start_angle
+    const PrimitiveRecord* primitives(int start_angle) const { return primitives_ + index_[start_angle].first_primitive; }
+    std::size_t num_primitives(int start_angle) const { return (std::size_t)index_[start_angle].num_primitives; }
+
+    /// Return the intermediate poses of $primitive, in cells relative to its start cell
+    const Pose2_cont* poses(const PrimitiveRecord& primitive) const { return poses_ + primitive.first_pose; }
+
+    /// Return the cells swept by $primitive, relative to its start cell
+    const CellOffset* cells(const PrimitiveRecord& primitive) const { return cells_ + primitive.first_cell; }
+
+    /// Return the footprint the swept cells were computed with
+    const FootprintVertex* footprint() const { return footprint_; }
+    std::size_t num_footprint_vertices() const { return (std::size_t)header_->num_footprint_vertices; }
+
+private:
+
+    void* data_;
+    std::size_t size_;
+
+    const PrimitiveLibraryHeader* header_;
+    const Pose2_cont* poses_;
+    const CellOffset* cells_;
+    const FootprintVertex* footprint_;
+    const PrimitiveRecord* primitives_;
+    const PrimitiveIndexEntry* index_;
+
+    PrimitiveLibrary(const PrimitiveLibrary&);
+    PrimitiveLibrary& operator=(const PrimitiveLibrary&);
+};
+
+#endif
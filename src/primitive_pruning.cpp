@@ -0,0 +1,224 @@
+#include "primitive_pruning.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <stdint.h>
+#include "lattice_graph.h"
+#include "primitive_library.h"
+#include "work_stealing_pool.h"
+
+struct SearchNode
+{
+    int64_t f;
+    int64_t g;
+    int x, y, angle;
+
+    bool operator>(const SearchNode& rhs) const { return f > rhs.f; }
+};
+
+/// Per-worker search storage, kept between searches
+struct SearchScratch
+{
+    std::unordered_map<uint64_t, int64_t> g;
+    std::vector<SearchNode> open;
+};
+
+static inline uint64_t state_key(int x, int y, int angle)
+{
+    return ((uint64_t)(uint32_t)(x + 0x8000) << 40) | ((uint64_t)(uint32_t)(y + 0x8000) << 16) | (uint64_t)angle;
+}
+
+/// Lower bound on the cost of any path covering the displacement ($dx, $dy).
+/// Primitive costs are rounded polyline lengths, so scale a little below the
+/// straight-line distance; an underestimate only costs search time.
+static inline int64_t cost_to_go(int dx, int dy)
+{
+    return (int64_t)(0.999 * PRIMITIVE_COST_SCALE * sqrt((double)dx * dx + (double)dy * dy));
+}
+
+/// Return the cost of the cheapest path over $edges from (0, 0, $start_angle)
+/// to $goal that costs at most $bound, or -1 if there is none. $expansions
+/// accumulates the states expanded; a search beyond $max_expansions gives up.
+static int64_t bounded_search(
+    const LatticeEdges& edges,
+    int start_angle,
+    const Pose2_disc& goal,
+    int64_t bound,
+    std::size_t max_expansions,
+    SearchScratch& scratch,
+    std::size_t& expansions,
+    bool& aborted)
+{
+    std::unordered_map<uint64_t, int64_t>& g = scratch.g;
+    std::vector<SearchNode>& open = scratch.open;
+    g.clear();
+    open.clear();
+    aborted = false;
+
+    const std::greater<SearchNode> cmp;
+    SearchNode start = { cost_to_go(goal.x, goal.y), 0, 0, 0, start_angle };
+    g[state_key(0, 0, start_angle)] = 0;
+    open.push_back(start);
+
+    std::size_t num_expanded = 0;
+    int64_t result = -1;
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), cmp);
+        SearchNode n = open.back();
+        open.pop_back();
+
+        if (n.f > bound) {
+            break;
+        }
+        if (n.g > g[state_key(n.x, n.y, n.angle)]) {
+            continue;   // stale entry
+        }
+        if (n.x == goal.x && n.y == goal.y && n.angle == goal.yaw) {
+            result = n.g;
+            break;
+        }
+        if (++num_expanded > max_expansions) {
+            aborted = true;
+            break;
+        }
+
+        for (const LatticeEdge& e : edges[n.angle]) {
+            SearchNode s;
+            s.x = n.x + e.dx;
+            s.y = n.y + e.dy;
+            s.angle = e.end_angle;
+            s.g = n.g + e.cost;
+            s.f = s.g + cost_to_go(goal.x - s.x, goal.y - s.y);
+            if (s.f > bound) {
+                continue;
+            }
+            auto it = g.find(state_key(s.x, s.y, s.angle));
+            if (it != g.end() && it->second <= s.g) {
+                continue;
+            }
+            g[state_key(s.x, s.y, s.angle)] = s.g;
+            open.push_back(s);
+            std::push_heap(open.begin(), open.end(), cmp);
+        }
+    }
+
+    expansions += num_expanded;
+    return result;
+}
+
+void prune_primitive_set(
+    const PrimitiveSet& primitives,
+    int num_angles,
+    const PruneParams& params,
+    WorkStealingPool& pool,
+    PrimitiveSet& pruned,
+    PruneReport& report)
+{
+    const std::size_t n = primitives.size();
+
+    report.num_input.assign(num_angles, 0);
+    report.num_kept.assign(num_angles, 0);
+    report.total_input = n;
+    report.total_kept = 0;
+    report.num_bands = 0;
+    report.num_expansions = 0;
+    report.num_aborted = 0;
+    report.mean_stretch = 0.0;
+    report.max_stretch = 0.0;
+
+    std::vector<int32_t> costs(n);
+    std::vector<std::size_t> order(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        costs[i] = primitive_cost(primitives.poses_of(primitives[i]), primitives[i].num_poses);
+        order[i] = i;
+        ++report.num_input[primitives[i].start_angle];
+    }
+
+    // ties keep their input order so the result is deterministic
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return costs[a] < costs[b]; });
+
+    std::vector<uint8_t> kept(n, 0);
+    std::vector<double> stretch(n, 0.0);
+    LatticeEdges edges(num_angles);
+
+    const int32_t band_width = n ? std::max<int32_t>(costs[order[0]], 1) : 1;
+
+    std::vector<SearchScratch> scratch(pool.num_threads());
+    std::vector<std::size_t> expansions(pool.num_threads(), 0);
+    std::vector<std::size_t> aborted(pool.num_threads(), 0);
+
+    std::size_t band_begin = 0;
+    while (band_begin < n) {
+        // candidates in a band can only be replaced by primitives from earlier bands
+        const int32_t band_limit = costs[order[band_begin]] + band_width;
+        std::size_t band_end = band_begin;
+        while (band_end < n && costs[order[band_end]] < band_limit) {
+            ++band_end;
+        }
+
+        pool.parallel_for(band_begin, band_end, 1, [&](int worker, std::size_t first, std::size_t last)
+        {
+            for (std::size_t k = first; k < last; ++k) {
+                const std::size_t i = order[k];
+                const MotionPrimitive& p = primitives[i];
+                const int64_t bound = (int64_t)std::floor(params.cost_ratio * costs[i]);
+                bool search_aborted;
+                int64_t cost = bounded_search(
+                        edges, p.start_angle, p.end, bound, params.max_expansions,
+                        scratch[worker], expansions[worker], search_aborted);
+                if (search_aborted) {
+                    ++aborted[worker];
+                }
+                if (cost < 0) {
+                    kept[i] = 1;
+                }
+                else {
+                    stretch[i] = (double)cost / (double)costs[i];
+                }
+            }
+        });
+
+        for (std::size_t k = band_begin; k < band_end; ++k) {
+            const std::size_t i = order[k];
+            if (kept[i]) {
+                const MotionPrimitive& p = primitives[i];
+                LatticeEdge e = { p.end.x, p.end.y, p.end.yaw, costs[i] };
+                edges[p.start_angle].push_back(e);
+            }
+        }
+
+        ++report.num_bands;
+        band_begin = band_end;
+    }
+
+    pruned.clear();
+    double total_stretch = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const MotionPrimitive& p = primitives[i];
+        if (kept[i]) {
+            MotionPrimitive q = p;
+            q.first_pose = pruned.poses.size();
+            const Pose2_cont* poses = primitives.poses_of(p);
+            pruned.poses.insert(pruned.poses.end(), poses, poses + p.num_poses);
+            q.first_cell = pruned.cells.size();
+            const CellOffset* cells = primitives.cells_of(p);
+            pruned.cells.insert(pruned.cells.end(), cells, cells + p.num_cells);
+            pruned.primitives.push_back(q);
+            ++report.num_kept[p.start_angle];
+            ++report.total_kept;
+        }
+        else {
+            total_stretch += stretch[i];
+            report.max_stretch = std::max(report.max_stretch, stretch[i]);
+        }
+    }
+
+    const std::size_t num_removed = n - report.total_kept;
+    report.mean_stretch = num_removed ? total_stretch / num_removed : 0.0;
+    for (int w = 0; w < pool.num_threads(); ++w) {
+        report.num_expansions += expansions[w];
+        report.num_aborted += aborted[w];
+    }
+}
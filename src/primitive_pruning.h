@@ -0,0 +1,55 @@
+#ifndef primitive_pruning_h
+#define primitive_pruning_h
+
+#include <cstddef>
+#include <vector>
+#include "lattice_primitives.h"
+
+class WorkStealingPool;
+
+/// Bounds on the search run for each candidate primitive
+struct PruneParams
+{
+    PruneParams() : cost_ratio(1.1), max_expansions(1000000) { }
+
+    double cost_ratio;              ///< largest allowed replacement cost over original cost
+    std::size_t max_expansions;     ///< a search that expands more states keeps its primitive
+};
+
+/// Outcome of prune_primitive_set
+struct PruneReport
+{
+    std::vector<std::size_t> num_input;     ///< per start heading
+    std::vector<std::size_t> num_kept;      ///< per start heading
+    std::size_t total_input;
+    std::size_t total_kept;
+    std::size_t num_bands;          ///< cost bands processed one after another
+    std::size_t num_expansions;     ///< states expanded over every search
+    std::size_t num_aborted;        ///< searches that hit max_expansions
+    double mean_stretch;            ///< mean replacement cost over original cost of removed primitives
+    double max_stretch;
+};
+
+/// Reduce $primitives, covering $num_angles start headings, to a lattice
+/// spanner: a primitive is removed if a sequence of kept, cheaper primitives
+/// reaches the same endpoint at no more than $params.cost_ratio times its
+/// cost, so every removed motion stays available within that ratio.
+/// Primitives are decided in order of increasing cost. Costs are
+/// primitive_cost() values, as stored in exported libraries.
+///
+/// Candidates are processed in bands one minimum primitive cost wide and
+/// searched in parallel within a band. A candidate may only be replaced
+/// using kept primitives from earlier bands. With a ratio of 1 this is
+/// exactly the sequential greedy spanner; above 1 it can keep a few more
+/// primitives than the sequential greedy algorithm would.
+///
+/// $pruned receives the kept primitives in their input order.
+void prune_primitive_set(
+    const PrimitiveSet& primitives,
+    int num_angles,
+    const PruneParams& params,
+    WorkStealingPool& pool,
+    PrimitiveSet& pruned,
+    PruneReport& report);
+
+#endif
@@ -0,0 +1,202 @@
+#include "reachability.h"
+#include <algorithm>
+#include "work_stealing_pool.h"
+
+void LatticeBitset::resize(int num_angles, int radius)
+{
+    num_angles_ = num_angles;
+    radius_ = radius;
+    width_ = 2 * radius + 1;
+    words_per_row_ = (width_ + 63) / 64;
+    last_word_mask_ = (width_ % 64) ? (((uint64_t)1 << (width_ % 64)) - 1) : ~(uint64_t)0;
+    words_.assign((std::size_t)num_angles_ * width_ * words_per_row_, 0);
+}
+
+void LatticeBitset::clear()
+{
+    std::fill(words_.begin(), words_.end(), 0);
+}
+
+std::size_t LatticeBitset::count(int angle) const
+{
+    const std::size_t plane = (std::size_t)width_ * words_per_row_;
+    std::size_t n = 0;
+    for (std::size_t i = angle * plane; i < (angle + 1) * plane; ++i) {
+        n += __builtin_popcountll(words_[i]);
+    }
+    return n;
+}
+
+std::size_t LatticeBitset::count() const
+{
+    std::size_t n = 0;
+    for (uint64_t w : words_) {
+        n += __builtin_popcountll(w);
+    }
+    return n;
+}
+
+void LatticeBitset::or_translated(const LatticeBitset& from, int from_angle, int dx, int dy, int angle)
+{
+    if (dx >= width_ || -dx >= width_) {
+        return;
+    }
+
+    const int n = words_per_row_;
+    const int word_shift = (dx >= 0 ? dx : -dx) / 64;
+    const int bit_shift = (dx >= 0 ? dx : -dx) % 64;
+    for (int y = std::max(-radius_, -radius_ + dy); y <= std::min(radius_, radius_ + dy); ++y) {
+        const uint64_t* src = from.row(y - dy, from_angle);
+        uint64_t* dst = row(y, angle);
+        if (dx >= 0) {
+            // bit j of the source lands on bit j + dx
+            for (int i = n - 1; i >= word_shift; --i) {
+                uint64_t w = src[i - word_shift] << bit_shift;
+                if (bit_shift && i - word_shift - 1 >= 0) {
+                    w |= src[i - word_shift - 1] >> (64 - bit_shift);
+                }
+                dst[i] |= w;
+            }
+        }
+        else {
+            for (int i = 0; i + word_shift < n; ++i) {
+                uint64_t w = src[i + word_shift] >> bit_shift;
+                if (bit_shift && i + word_shift + 1 < n) {
+                    w |= src[i + word_shift + 1] << (64 - bit_shift);
+                }
+                dst[i] |= w;
+            }
+        }
+        dst[n - 1] &= last_word_mask_;
+    }
+}
+
+void lattice_reachability(
+    const LatticeEdges& edges,
+    int start_angle,
+    const ReachabilityParams& params,
+    WorkStealingPool& pool,
+    ReachabilityResult& result)
+{
+    const int num_angles = (int)edges.size();
+    const int radius = params.radius;
+    const int max_steps = std::min(params.max_steps, REACH_MAX_STEPS);
+    const int width = 2 * radius + 1;
+
+    // the states entering heading b come from the edges ending in it
+    LatticeEdges reversed;
+    reverse_lattice_edges(edges, reversed);
+
+    LatticeBitset frontier;
+    LatticeBitset next;
+    frontier.resize(num_angles, radius);
+    next.resize(num_angles, radius);
+    result.reached.resize(num_angles, radius);
+    result.num_reached.clear();
+    result.cell_steps.assign((std::size_t)width * width, REACH_UNREACHED);
+    result.cell_headings.assign((std::size_t)width * width, 0);
+
+    frontier.set(0, 0, start_angle);
+    result.reached.set(0, 0, start_angle);
+    result.cell_steps[result.cell_index(0, 0)] = 0;
+    result.num_reached.push_back(1);
+
+    std::vector<std::size_t> num_new(num_angles);
+    LatticeBitset& reached = result.reached;
+    for (int step = 1; step <= max_steps; ++step) {
+        pool.parallel_for(0, num_angles, 1, [&](int, std::size_t first, std::size_t last)
+        {
+            for (std::size_t b = first; b < last; ++b) {
+                for (int y = -radius; y <= radius; ++y) {
+                    std::fill(next.row(y, (int)b), next.row(y, (int)b) + next.words_per_row(), 0);
+                }
+                for (const LatticeEdge& r : reversed[b]) {
+                    next.or_translated(frontier, r.end_angle, -r.dx, -r.dy, (int)b);
+                }
+
+                // keep only the states first reached now
+                for (int y = -radius; y <= radius; ++y) {
+                    uint64_t* n = next.row(y, (int)b);
+                    uint64_t* v = reached.row(y, (int)b);
+                    for (int i = 0; i < next.words_per_row(); ++i) {
+                        n[i] &= ~v[i];
+                        v[i] |= n[i];
+                    }
+                }
+                num_new[b] = next.count((int)b);
+            }
+        });
+
+        std::size_t total_new = 0;
+        for (int b = 0; b < num_angles; ++b) {
+            total_new += num_new[b];
+        }
+        if (total_new == 0) {
+            break;
+        }
+        result.num_reached.push_back(result.num_reached.back() + total_new);
+
+        for (int b = 0; b < num_angles; ++b) {
+            for (int y = -radius; y <= radius; ++y) {
+                const uint64_t* n = next.row(y, b);
+                for (int i = 0; i < next.words_per_row(); ++i) {
+                    for (uint64_t w = n[i]; w; w &= w - 1) {
+                        const int x = i * 64 + __builtin_ctzll(w) - radius;
+                        uint8_t& s = result.cell_steps[result.cell_index(x, y)];
+                        s = std::min<uint8_t>(s, (uint8_t)step);
+                    }
+                }
+            }
+        }
+
+        std::swap(frontier, next);
+    }
+
+    for (int b = 0; b < num_angles; ++b) {
+        for (int y = -radius; y <= radius; ++y) {
+            for (int x = -radius; x <= radius; ++x) {
+                if (reached.test(x, y, b)) {
+                    ++result.cell_headings[result.cell_index(x, y)];
+                }
+            }
+        }
+    }
+}
+
+int heading_components(const LatticeEdges& edges, std::vector<int>& component)
+{
+    const int num_angles = (int)edges.size();
+
+    // reach[a][b] is whether some chain of primitives turns heading a into b
+    std::vector<std::vector<uint8_t>> reach(num_angles, std::vector<uint8_t>(num_angles, 0));
+    std::vector<int> stack;
+    for (int a = 0; a < num_angles; ++a) {
+        reach[a][a] = 1;
+        stack.assign(1, a);
+        while (!stack.empty()) {
+            const int h = stack.back();
+            stack.pop_back();
+            for (const LatticeEdge& e : edges[h]) {
+                if (!reach[a][e.end_angle]) {
+                    reach[a][e.end_angle] = 1;
+                    stack.push_back(e.end_angle);
+                }
+            }
+        }
+    }
+
+    component.assign(num_angles, -1);
+    int num_components = 0;
+    for (int a = 0; a < num_angles; ++a) {
+        if (component[a] >= 0) {
+            continue;
+        }
+        for (int b = a; b < num_angles; ++b) {
+            if (reach[a][b] && reach[b][a]) {
+                component[b] = num_components;
+            }
+        }
+        ++num_components;
+    }
+    return num_components;
+}
@@ -0,0 +1,109 @@
+#ifndef reachability_h
+#define reachability_h
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+#include "lattice_graph.h"
+
+class WorkStealingPool;
+
+/// One bit per lattice state within $radius cells of the origin. Each row of
+/// a heading's plane is padded to whole words and the padding is kept clear,
+/// so a translation of the whole set is a word-wise shift of every row.
+class LatticeBitset
+{
+public:
+
+    LatticeBitset() : num_angles_(0), radius_(0), width_(0), words_per_row_(0) { }
+
+    /// Size the set for $num_angles headings and clear it
+    void resize(int num_angles, int radius);
+    void clear();
+
+    int num_angles() const { return num_angles_; }
+    int radius() const { return radius_; }
+    int width() const { return width_; }
+    int words_per_row() const { return words_per_row_; }
+    std::size_t num_states() const { return (std::size_t)num_angles_ * width_ * width_; }
+
+    bool contains(int x, int y) const { return x >= -radius_ && x <= radius_ && y >= -radius_ && y <= radius_; }
+
+    bool test(int x, int y, int angle) const
+    {
+        const uint64_t* r = row(y, angle);
+        return (r[(x + radius_) >> 6] >> ((x + radius_) & 63)) & 1;
+    }
+
+    void set(int x, int y, int angle)
+    {
+        uint64_t* r = row(y, angle);
+        r[(x + radius_) >> 6] |= (uint64_t)1 << ((x + radius_) & 63);
+    }
+
+    /// Return the words holding row $y of heading $angle
+    uint64_t* row(int y, int angle) { return &words_[((std::size_t)angle * width_ + (y + radius_)) * words_per_row_]; }
+    const uint64_t* row(int y, int angle) const { return &words_[((std::size_t)angle * width_ + (y + radius_)) * words_per_row_]; }
+
+    /// Return the number of states in heading $angle's plane, or in every plane
+    std::size_t count(int angle) const;
+    std::size_t count() const;
+
+    /// Set every state of heading $angle reached from a state of heading
+    /// $from_angle in $from by the translation ($dx, $dy)
+    void or_translated(const LatticeBitset& from, int from_angle, int dx, int dy, int angle);
+
+private:
+
+    int num_angles_;
+    int radius_;
+    int width_;
+    int words_per_row_;
+    uint64_t last_word_mask_;
+    std::vector<uint64_t> words_;
+};
+
+/// Bounds on a reachability analysis
+struct ReachabilityParams
+{
+    ReachabilityParams() : radius(10), max_steps(8) { }
+
+    int radius;     ///< analyze states within [-radius, radius] cells of the start in x and y
+    int max_steps;  ///< largest number of primitives chained, at most REACH_MAX_STEPS
+};
+
+static const int REACH_MAX_STEPS = 254;
+static const uint8_t REACH_UNREACHED = 255;
+
+/// States reachable from a start state within a bounded number of steps
+struct ReachabilityResult
+{
+    LatticeBitset reached;
+    std::vector<std::size_t> num_reached;   ///< states reached within k steps, for every k up to the last step taken
+    std::vector<uint8_t> cell_steps;        ///< fewest steps reaching each cell in any heading, or REACH_UNREACHED
+    std::vector<uint8_t> cell_headings;     ///< number of headings reached at each cell
+
+    /// Return the entry for cell ($x, $y) of $cell_steps or $cell_headings
+    std::size_t cell_index(int x, int y) const { return (std::size_t)(y + reached.radius()) * reached.width() + (x + reached.radius()); }
+
+    bool complete() const { return !num_reached.empty() && num_reached.back() == reached.num_states(); }
+};
+
+/// Find every state within $params.radius cells of (0, 0, $start_angle)
+/// reachable over $edges in at most $params.max_steps steps without leaving
+/// that region, by breadth-first search over bitsets. Each level shifts the
+/// frontier once per edge; the headings of the next frontier are filled in parallel.
+void lattice_reachability(
+    const LatticeEdges& edges,
+    int start_angle,
+    const ReachabilityParams& params,
+    WorkStealingPool& pool,
+    ReachabilityResult& result);
+
+/// Label each heading by its strongly connected component in the graph that
+/// has an edge a->b whenever some primitive turns heading a into heading b.
+/// Components are numbered in order of their smallest heading. Return the
+/// number of components; the transitions are strongly connected iff it is 1.
+int heading_components(const LatticeEdges& edges, std::vector<int>& component);
+
+#endif
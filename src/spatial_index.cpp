@@ -0,0 +1,157 @@
+#include "spatial_index.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialIndex::SpatialIndex(double cell_size) :
+    inv_cell_size_(1.0 / cell_size),
+    size_(0)
+{
+}
+
+void SpatialIndex::clear()
+{
+    items_.clear();
+    buckets_.clear();
+    size_ = 0;
+}
+
+int SpatialIndex::cell_of(double v) const
+{
+    return (int)floor(v * inv_cell_size_);
+}
+
+SpatialIndex::CellRange SpatialIndex::cells_of(const Bounds2& bounds) const
+{
+    CellRange r = { cell_of(bounds.min_x), cell_of(bounds.min_y), cell_of(bounds.max_x), cell_of(bounds.max_y) };
+    return r;
+}
+
+void SpatialIndex::add_to_buckets(uint32_t id, const CellRange& cells)
+{
+    for (int y = cells.min_y; y <= cells.max_y; ++y) {
+        for (int x = cells.min_x; x <= cells.max_x; ++x) {
+            buckets_[bucket_key(x, y)].push_back(id);
+        }
+    }
+}
+
+void SpatialIndex::remove_from_buckets(uint32_t id, const CellRange& cells)
+{
+    for (int y = cells.min_y; y <= cells.max_y; ++y) {
+        for (int x = cells.min_x; x <= cells.max_x; ++x) {
+            BucketMap::iterator it = buckets_.find(bucket_key(x, y));
+            if (it == buckets_.end()) {
+                continue;
+            }
+            std::vector<uint32_t>& bucket = it->second;
+            std::vector<uint32_t>::iterator found = std::find(bucket.begin(), bucket.end(), id);
+            if (found != bucket.end()) {
+                *found = bucket.back();
+                bucket.pop_back();
+            }
+            if (bucket.empty()) {
+                buckets_.erase(it);
+            }
+        }
+    }
+}
+
+void SpatialIndex::insert(uint32_t id, const Bounds2& bounds)
+{
+    if (id >= items_.size()) {
+        items_.resize(id + 1);
+    }
+
+    Item& item = items_[id];
+    item.bounds = bounds;
+    item.cells = cells_of(bounds);
+    item.present = true;
+    add_to_buckets(id, item.cells);
+    ++size_;
+}
+
+void SpatialIndex::update(uint32_t id, const Bounds2& bounds)
+{
+    Item& item = items_[id];
+    item.bounds = bounds;
+
+    // small moves stay within the same buckets
+    const CellRange cells = cells_of(bounds);
+    if (cells == item.cells) {
+        return;
+    }
+    remove_from_buckets(id, item.cells);
+    add_to_buckets(id, cells);
+    item.cells = cells;
+}
+
+void SpatialIndex::remove(uint32_t id)
+{
+    if (!contains(id)) {
+        return;
+    }
+    Item& item = items_[id];
+    remove_from_buckets(id, item.cells);
+    item.present = false;
+    --size_;
+}
+
+void SpatialIndex::visit(int x, int y, const std::vector<uint32_t>& bucket, const Bounds2& box, const CellRange& cells, std::vector<uint32_t>& ids) const
+{
+    for (uint32_t id : bucket) {
+        // an item spanning several buckets is reported from the first of
+        // them within the query, so that no record of visits is needed
+        const Item& item = items_[id];
+        if (std::max(item.cells.min_x, cells.min_x) != x || std::max(item.cells.min_y, cells.min_y) != y) {
+            continue;
+        }
+        if (item.bounds.intersects(box)) {
+            ids.push_back(id);
+        }
+    }
+}
+
+void SpatialIndex::query(double x, double y, std::vector<uint32_t>& ids) const
+{
+    // a point lies in one bucket, and an item is in each bucket at most once
+    BucketMap::const_iterator it = buckets_.find(bucket_key(cell_of(x), cell_of(y)));
+    if (it == buckets_.end()) {
+        return;
+    }
+    for (uint32_t id : it->second) {
+        if (items_[id].bounds.contains(x, y)) {
+            ids.push_back(id);
+        }
+    }
+}
+
+void SpatialIndex::query(const Bounds2& box, std::vector<uint32_t>& ids) const
+{
+    if (box.empty() || !size_) {
+        return;
+    }
+
+    // a box wider than the occupied buckets is cheaper to answer by
+    // visiting those buckets than by probing every bucket it covers
+    const CellRange cells = cells_of(box);
+    const double num_cells = ((double)cells.max_x - cells.min_x + 1) * ((double)cells.max_y - cells.min_y + 1);
+    if (num_cells > (double)buckets_.size()) {
+        for (const BucketMap::value_type& bucket : buckets_) {
+            const int x = (int32_t)(bucket.first >> 32);
+            const int y = (int32_t)(uint32_t)bucket.first;
+            if (x >= cells.min_x && x <= cells.max_x && y >= cells.min_y && y <= cells.max_y) {
+                visit(x, y, bucket.second, box, cells, ids);
+            }
+        }
+        return;
+    }
+
+    for (int y = cells.min_y; y <= cells.max_y; ++y) {
+        for (int x = cells.min_x; x <= cells.max_x; ++x) {
+            BucketMap::const_iterator it = buckets_.find(bucket_key(x, y));
+            if (it != buckets_.end()) {
+                visit(x, y, it->second, box, cells, ids);
+            }
+        }
+    }
+}
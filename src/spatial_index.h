@@ -0,0 +1,91 @@
+#ifndef spatial_index_h
+#define spatial_index_h
+
+#include <cstddef>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "Pose2.h"
+
+/// A uniform grid of square buckets over the plane, holding items by their
+/// bounds so that the items at a point or within a box can be found without
+/// visiting the rest. Items are small integer ids chosen by the caller; an
+/// item is listed in every bucket its bounds overlap. Only buckets holding
+/// items are stored, so the plane is unbounded.
+///
+/// Queries may run concurrently with each other but not with edits.
+class SpatialIndex
+{
+public:
+
+    /// Create an index with buckets $cell_size wide. Items a little smaller
+    /// than the buckets land in at most four of them.
+    explicit SpatialIndex(double cell_size = 1.0);
+
+    /// Remove every item
+    void clear();
+
+    /// Add item $id, which must not be present, with bounds $bounds
+    void insert(uint32_t id, const Bounds2& bounds);
+
+    /// Change the bounds of item $id, which must be present. Only the
+    /// buckets it enters or leaves are touched.
+    void update(uint32_t id, const Bounds2& bounds);
+
+    /// Remove item $id if it is present
+    void remove(uint32_t id);
+
+    bool contains(uint32_t id) const { return id < items_.size() && items_[id].present; }
+    const Bounds2& bounds(uint32_t id) const { return items_[id].bounds; }
+    std::size_t size() const { return size_; }
+
+    /// Append to $ids every item whose bounds contain ($x, $y)
+    void query(double x, double y, std::vector<uint32_t>& ids) const;
+
+    /// Append to $ids every item whose bounds intersect $box, each once
+    void query(const Bounds2& box, std::vector<uint32_t>& ids) const;
+
+private:
+
+    struct CellRange
+    {
+        int min_x, min_y, max_x, max_y;
+
+        bool operator==(const CellRange& rhs) const
+        {
+            return min_x == rhs.min_x && min_y == rhs.min_y && max_x == rhs.max_x && max_y == rhs.max_y;
+        }
+    };
+
+    struct Item
+    {
+        Item() : present(false) { }
+        Bounds2 bounds;
+        CellRange cells;
+        bool present;
+    };
+
+    typedef std::unordered_map<uint64_t, std::vector<uint32_t>> BucketMap;
+
+    double inv_cell_size_;
+    std::vector<Item> items_;
+    std::size_t size_;
+    BucketMap buckets_;
+
+    static uint64_t bucket_key(int x, int y)
+    {
+        return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+    }
+
+    int cell_of(double v) const;
+    CellRange cells_of(const Bounds2& bounds) const;
+
+    void add_to_buckets(uint32_t id, const CellRange& cells);
+    void remove_from_buckets(uint32_t id, const CellRange& cells);
+
+    /// Report the items of $bucket, at cell ($x, $y) of the query's $cells,
+    /// whose bounds intersect $box
+    void visit(int x, int y, const std::vector<uint32_t>& bucket, const Bounds2& box, const CellRange& cells, std::vector<uint32_t>& ids) const;
+};
+
+#endif
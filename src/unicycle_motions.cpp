@@ -1,231 +1,538 @@
+#include <algorithm>
 #include <Eigen/Dense>
-#include <Eigen/SVD>
 #include "unicycle_motions.h"
+#include "angles.h"
+#include "logging.h"
+#include "pinv.h"
 
 double NUM_ANGLES = 16;
 int NUM_SAMPLES = 10;
 
-#ifdef DEBUG
-#define DEBUG_PRINT(fmt, ...) printf(fmt, ##__VA_ARGS__)
-#else
-#define DEBUG_PRINT(fmt, ...)
-#endif
-
-// @from http://listengine.tuxfamily.org/lists.tuxfamily.org/eigen/2010/01/msg00173.html
-static bool pinv(const Eigen::Matrix2d& a, Eigen::Matrix2d& a_pinv)
+static inline double interp(double from, double to, double alpha)
 {
-    // see : http://en.wikipedia.org/wiki/Moore-Penrose_pseudoinverse#The_general_case_and_the_SVD_method
+    return (1.0 - alpha) * from + alpha * to;
+}
 
-    if (a.rows() < a.cols())
-        return false;
+bool solve_unicycle_motion(const Pose2_cont& start, const Pose2_cont& goal, UnicycleMotion& motion)
+{
+    LOG_TRACE("--------------------------------------------------------------------------------\n");
+    LOG_TRACE("generating unicycle motion between %s and %s\n", to_string(start).c_str(), to_string(goal).c_str());
+    LOG_TRACE("--------------------------------------------------------------------------------\n");
 
-    // SVD
-    Eigen::JacobiSVD<Eigen::Matrix2d> svdA(a, Eigen::ComputeFullU | Eigen::ComputeFullV);
-    Eigen::Vector2d vSingular = svdA.singularValues();
+    auto almost_equals = [](double lhs, double rhs, double eps) { return fabs(lhs - rhs) < eps; };
+    const double eps = 1e-6;
 
-    // Build a diagonal matrix with the Inverted Singular values
-    // The pseudo inverted singular matrix is easy to compute :
-    // is formed by replacing every nonzero entry by its reciprocal (inversing).
-    Eigen::Vector2d vPseudoInvertedSingular(svdA.matrixV().cols(),1);
+    motion.start = start;
 
-    for (int iRow = 0; iRow < vSingular.rows(); iRow++)
-    {
-        if (fabs(vSingular(iRow)) <= 1e-10) // Todo : Put epsilon in parameter
+    // check for straight-line motion or turn-in-place
+    double dx = goal.x - start.x;
+    double dy = goal.y - start.y;
+    double dtheta = shortest_angle_diff(goal.yaw, start.yaw);
+    if ((dx == 0.0 && dy == 0.0) || (dtheta == 0.0)) {
+        // compare headings modulo 2*pi; atan2 only covers [-pi, pi]
+        double heading = atan2(dy, dx);
+        if (almost_equals(shortest_angle_diff(heading, start.yaw), 0.0, eps) &&
+            almost_equals(shortest_angle_diff(heading, goal.yaw), 0.0, eps))
         {
-            vPseudoInvertedSingular(iRow, 0) = 0.;
+            LOG_TRACE("Interpolated Motion\n");
+            motion.straight_length = sqrt(dx * dx + dy * dy);
+            motion.radius = 0.0;
+            motion.w = 0.0;
+            motion.v = motion.straight_length;
+            motion.tl = 1.0;
+            return true;
         }
-        else
-        {
-            vPseudoInvertedSingular(iRow, 0) = 1. / vSingular(iRow);
+        else {
+            LOG_TRACE("No unicycle motion for turns-in-place or skidding\n");
+            return false;
         }
     }
 
-    // A little optimization here
-    Eigen::Matrix2d mAdjointU = svdA.matrixU().adjoint().block(0, 0, vSingular.rows(), svdA.matrixU().adjoint().cols());
+    LOG_TRACE("Arc Motion\n");
+    Eigen::Matrix2d R;
+    R(0, 0) = cos(start.yaw);
+    R(0, 1) = sin(goal.yaw) - sin(start.yaw);
+    R(1, 0) = sin(start.yaw);
+    R(1, 1) = -(cos(goal.yaw) - cos(start.yaw));
+
+    Eigen::Matrix2d Rpinv;
+    if (!pinv(R, Rpinv)) {
+        LOG_TRACE("Failed to compute Moore-penrose pseudo-inverse");
+        return false;
+    }
 
-    // Pseudo-Inversion : V * S * U'
-    a_pinv = (svdA.matrixV() * vPseudoInvertedSingular.asDiagonal()) * mAdjointU;
+    Eigen::Vector2d S = Rpinv * Eigen::Vector2d(goal.x - start.x, goal.y - start.y);
 
-    return true;
-}
+    // pure arcs solve to a straight length of 0 up to roundoff, whose sign
+    // would otherwise decide whether they are accepted
+    double straight_length = fabs(S(0)) < 1e-12 ? 0.0 : S(0);
+    double radius = S(1);
 
-double NormalizeAngle(double angle_rad, double angle_min_rad, double angle_max_rad)
-{
-    if (fabs(angle_rad) > 2.0 * M_PI) { // normalize to [-2*pi, 2*pi] range
-        angle_rad -= ((int)(angle_rad / (2.0 * M_PI))) * 2.0 * M_PI;
+    if (fabs(radius) < 1e-6)  {
+        LOG_TRACE("Unable to turn with radius %0.3f\n", radius);
+        return false;
     }
 
-    while (angle_rad > angle_max_rad) {
-        angle_rad -= 2.0 * M_PI;
+    double w = shortest_angle_diff(goal.yaw, start.yaw) + (straight_length / radius);
+    double v = radius * w;
+    double tl = straight_length / v;
+
+    if (straight_length < 0) {
+        LOG_TRACE("Not allowed to go backwards (length = %0.3f)\n", straight_length);
+        return false;
     }
 
-    while (angle_rad < angle_min_rad) {
-        angle_rad += 2 * M_PI;
+    if (v < 0) {
+        LOG_TRACE("Not allowed to go backwards (velocity = %0.3f)\n", v);
+        return false;
     }
 
-    return angle_rad;
+    if (tl < 0.0 || tl > 1.0) {
+        LOG_TRACE("Another dimension! Another dimension! (tl = %0.3f)\n", tl);
+        return false;
+    }
+
+    LOG_TRACE("R = [ %0.3f, %0.3f; %0.3f, %0.3f]\n", R(0, 0), R(0, 1), R(1, 0), R(1, 1));
+    LOG_TRACE("S = [%0.3f, %0.3f]\n", S(0), S(1));
+    LOG_TRACE("straight_length = %0.3f\n", straight_length);
+    LOG_TRACE("radius = %0.3f\n", radius);
+    LOG_TRACE("w = %0.3f\n", w);
+    LOG_TRACE("v = %0.3f\n", v);
+    LOG_TRACE("tl = %0.3f\n", tl);
+
+    motion.straight_length = straight_length;
+    motion.radius = radius;
+    motion.w = w;
+    motion.v = v;
+    motion.tl = tl;
+    return true;
 }
 
-double ShortestAngleDist(double a1_rad, double a2_rad)
+Pose2_cont unicycle_motion_pose(const UnicycleMotion& motion, double t)
 {
-    double a1_norm = NormalizeAngle(a1_rad, 0.0, 2.0 * M_PI);
-    double a2_norm = NormalizeAngle(a2_rad, 0.0, 2.0 * M_PI);
-    return std::min(fabs(a1_norm - a2_norm), 2.0 * M_PI - fabs(a2_norm - a1_norm));
+    const Pose2_cont& start = motion.start;
+    if (motion.radius == 0.0) {
+        double d = motion.straight_length * t;
+        return Pose2_cont(start.x + d * cos(start.yaw), start.y + d * sin(start.yaw), start.yaw);
+    }
+
+    if (t < motion.tl) {
+        double d = motion.v * t;
+        return Pose2_cont(start.x + d * cos(start.yaw), start.y + d * sin(start.yaw), start.yaw);
+    }
+
+    const double r = motion.radius;
+    const double theta = start.yaw + motion.w * (t - motion.tl);
+    return Pose2_cont(
+            start.x + motion.straight_length * cos(start.yaw) + r * sin(theta) - r * sin(start.yaw),
+            start.y + motion.straight_length * sin(start.yaw) - r * cos(theta) + r * cos(start.yaw),
+            theta);
 }
 
-double ShortestAngleDiff(double a1_rad, double a2_rad)
+Pose2_cont unicycle_motion_end(const UnicycleMotion& motion)
 {
-    double a1_norm = NormalizeAngle(a1_rad, 0.0, 2.0 * M_PI);
-    double a2_norm = NormalizeAngle(a2_rad, 0.0, 2.0 * M_PI);
+    return unicycle_motion_pose(motion, 1.0);
+}
 
-    double dist = ShortestAngleDist(a1_rad, a2_rad);
-    if (ShortestAngleDist(a1_norm + dist, a2_norm) < ShortestAngleDist(a1_norm - dist, a2_norm)) {
-        return -dist;
-    }
-    else {
-        return dist;
+double unicycle_motion_length(const UnicycleMotion& motion)
+{
+    if (motion.radius == 0.0) {
+        return fabs(motion.straight_length);
     }
+    return fabs(motion.straight_length) + fabs(motion.radius * motion.w * (1.0 - motion.tl));
 }
 
-static inline double interp(double from, double to, double alpha)
+int num_unicycle_motion_samples(const UnicycleMotion& motion)
 {
-    return (1.0 - alpha) * from + alpha * to;
+    if (motion.radius == 0.0) {
+        return (int)std::ceil(fabs(motion.straight_length) / UNICYCLE_STRAIGHT_SAMPLE_RES);
+    }
+
+    // historically the turned angle stands in for the arc length here
+    double arc_length = motion.w * (1.0 - motion.tl);
+    double total_length = fabs(motion.straight_length) + fabs(arc_length);
+    return (int)std::ceil(total_length / UNICYCLE_ARC_SAMPLE_RES);
 }
 
-static inline double interp_angle(double from, double to, double alpha)
+int num_unicycle_motion_samples(const UnicycleMotion& motion, double resolution)
 {
-    return from + alpha * ShortestAngleDiff(to, from);
+    // samples are evenly spaced in time and the speed differs between the
+    // two segments, so bound the spacing on the faster one
+    double speed = fabs(motion.radius == 0.0 ? motion.straight_length : motion.v);
+    if (motion.radius != 0.0) {
+        speed = std::max(speed, fabs(motion.radius * motion.w));
+    }
+    return std::max(2, (int)std::ceil(speed / resolution) + 1);
 }
 
-std::vector<Pose2_cont> create_interpolated_motion(const Pose2_cont& start, const Pose2_cont& goal)
+UnicycleMotionSampler::UnicycleMotionSampler(const UnicycleMotion& motion, int num_samples) :
+    motion_(motion),
+    num_samples_(num_samples),
+    i_(0),
+    k_(0),
+    c_(0.0),
+    s_(0.0)
 {
-    auto sqrd = [](double d) { return d * d; };
-    std::vector<Pose2_cont> motion;
+    const Pose2_cont& start = motion.start;
+    cos_start_ = cos(start.yaw);
+    sin_start_ = sin(start.yaw);
+
+    end_x_ = start.x + motion.straight_length * cos_start_;
+    end_y_ = start.y + motion.straight_length * sin_start_;
+
+    // arc center; arc pose i lies at center + r * (sin(theta_i), -cos(theta_i))
+    cx_ = end_x_ - motion.radius * sin_start_;
+    cy_ = end_y_ + motion.radius * cos_start_;
+
+    // consecutive samples are w / (num_samples - 1) apart in heading, so
+    // (cos(theta), sin(theta)) advances by a fixed rotation
+    const double step = num_samples > 1 ? motion.w / (double)(num_samples - 1) : 0.0;
+    cos_step_ = cos(step);
+    sin_step_ = sin(step);
+}
 
-    const double res = 0.01;
-    double dist = sqrt(sqrd(goal.x - start.x) +  sqrd(goal.y - start.y));
-    const int num_samples = (int)std::ceil(dist / res);
+Pose2_cont UnicycleMotionSampler::next()
+{
+    const Pose2_cont& start = motion_.start;
+    const int i = i_++;
 
-    motion.resize(num_samples);
-    for (int i = 0; i < num_samples; ++i) {
-        double alpha = (double)i / (num_samples - 1);
+    if (motion_.radius == 0.0) {
+        double alpha = num_samples_ > 1 ? i * (1.0 / (num_samples_ - 1)) : 0.0;
+        return Pose2_cont(interp(start.x, end_x_, alpha), interp(start.y, end_y_, alpha), start.yaw);
+    }
 
-        double interm_x = interp(start.x, goal.x, alpha);
-        double interm_y = interp(start.y, goal.y, alpha);
-        double interm_yaw = interp_angle(start.yaw, goal.yaw, alpha);
+    double dt = (double)i / (double)(num_samples_ - 1);
+    if (k_ == 0 && dt < motion_.tl) {
+        return Pose2_cont(start.x + motion_.v * cos_start_ * dt, start.y + motion_.v * sin_start_ * dt, start.yaw);
+    }
 
-        motion.emplace_back(interm_x, interm_y, interm_yaw);
+    double theta = start.yaw + motion_.w * (dt - motion_.tl);
+    if (k_++ % UNICYCLE_SAMPLE_RESEED_INTERVAL == 0) {
+        c_ = cos(theta);
+        s_ = sin(theta);
     }
+    else {
+        double cn = c_ * cos_step_ - s_ * sin_step_;
+        s_ = s_ * cos_step_ + c_ * sin_step_;
+        c_ = cn;
+    }
+    return Pose2_cont(cx_ + motion_.radius * s_, cy_ - motion_.radius * c_, theta);
+}
 
-    return motion;
+/// Write the samples of a straight-line motion
+static void sample_straight(const UnicycleMotion& motion, int num_samples, Pose2_cont* poses)
+{
+    const Pose2_cont& start = motion.start;
+    const double end_x = start.x + motion.straight_length * cos(start.yaw);
+    const double end_y = start.y + motion.straight_length * sin(start.yaw);
+    const double scale = num_samples > 1 ? 1.0 / (num_samples - 1) : 0.0;
+    for (int i = 0; i < num_samples; ++i) {
+        double alpha = i * scale;
+        poses[i] = Pose2_cont(interp(start.x, end_x, alpha), interp(start.y, end_y, alpha), start.yaw);
+    }
 }
 
-double shortest_angle_diff(double af, double ai)
+/// Write the samples of the straight segment of an arc motion and return the
+/// index of the first sample on the arc
+static int sample_arc_lead_in(const UnicycleMotion& motion, int num_samples, Pose2_cont* poses)
 {
-    auto cmodf = [](double a, double n) { return fmod(fmod(a, n) + n, n); };
-    double a = af - ai;
-    a = cmodf(a + M_PI, 2.0 * M_PI) - M_PI;
-    return a;
+    const Pose2_cont& start = motion.start;
+    const double vx = motion.v * cos(start.yaw);
+    const double vy = motion.v * sin(start.yaw);
+    int i = 0;
+    for (; i < num_samples; ++i) {
+        double dt = (double)i / (double)(num_samples - 1);
+        if (!(dt < motion.tl)) {
+            break;
+        }
+        poses[i] = Pose2_cont(start.x + vx * dt, start.y + vy * dt, start.yaw);
+    }
+    return i;
 }
 
-std::vector<Pose2_cont>
-generate_unicycle_motion(const Pose2_cont& start, const Pose2_cont& goal)
+void sample_unicycle_motion(const UnicycleMotion& motion, int num_samples, Pose2_cont* poses)
 {
-    DEBUG_PRINT("--------------------------------------------------------------------------------\n");
-    DEBUG_PRINT("generating unicycle motion between %s and %s\n", to_string(start).c_str(), to_string(goal).c_str());
-    DEBUG_PRINT("--------------------------------------------------------------------------------\n");
+    if (motion.radius == 0.0) {
+        sample_straight(motion, num_samples, poses);
+        return;
+    }
 
-    auto almost_equals = [](double lhs, double rhs, double eps) { return fabs(lhs - rhs) < eps; };
-    const double eps = 1e-6;
+    const Pose2_cont& start = motion.start;
+    const double r = motion.radius;
+    const double w = motion.w;
+    const double tl = motion.tl;
 
-    // check for straight-line motion or turn-in-place
-    double dx = goal.x - start.x;
-    double dy = goal.y - start.y;
-    double dtheta = shortest_angle_diff(goal.yaw, start.yaw);
-    if ((dx == 0.0 && dy == 0.0) || (dtheta == 0.0)) {
-        if (almost_equals(atan2(dy, dx), start.yaw, eps) && almost_equals(atan2(dy, dx), goal.yaw, eps)) {
-            DEBUG_PRINT("Interpolated Motion\n");
-            return create_interpolated_motion(start, goal);
+    int i = sample_arc_lead_in(motion, num_samples, poses);
+
+    // arc center; pose i lies at center + r * (sin(theta_i), -cos(theta_i))
+    const double cx = start.x + motion.straight_length * cos(start.yaw) - r * sin(start.yaw);
+    const double cy = start.y + motion.straight_length * sin(start.yaw) + r * cos(start.yaw);
+
+    // consecutive samples are w / (num_samples - 1) apart in heading, so
+    // (cos(theta), sin(theta)) advances by a fixed rotation
+    const double step = w / (double)(num_samples - 1);
+    const double cos_step = cos(step);
+    const double sin_step = sin(step);
+
+    double c = 0.0, s = 0.0;
+    for (int k = 0; i < num_samples; ++i, ++k) {
+        double dt = (double)i / (double)(num_samples - 1);
+        double theta = start.yaw + w * (dt - tl);
+        if (k % UNICYCLE_SAMPLE_RESEED_INTERVAL == 0) {
+            c = cos(theta);
+            s = sin(theta);
         }
         else {
-            DEBUG_PRINT("No unicycle motion for turns-in-place or skidding\n");
-            return { };
+            double cn = c * cos_step - s * sin_step;
+            s = s * cos_step + c * sin_step;
+            c = cn;
         }
+        poses[i] = Pose2_cont(cx + r * s, cy - r * c, theta);
     }
+}
 
-    DEBUG_PRINT("Arc Motion\n");
-    Eigen::Matrix2d R;
-    R(0, 0) = cos(start.yaw);
-    R(0, 1) = sin(goal.yaw) - sin(start.yaw);
-    R(1, 0) = sin(start.yaw);
-    R(1, 1) = -(cos(goal.yaw) - cos(start.yaw));
+void sample_unicycle_motion_direct(const UnicycleMotion& motion, int num_samples, Pose2_cont* poses)
+{
+    if (motion.radius == 0.0) {
+        sample_straight(motion, num_samples, poses);
+        return;
+    }
 
-    Eigen::Matrix2d Rpinv;
-    if (!pinv(R, Rpinv)) {
-        DEBUG_PRINT("Failed to compute Moore-penrose pseudo-inverse");
-        return { };
+    const Pose2_cont& start = motion.start;
+    const double straight_length = motion.straight_length;
+    const double radius = motion.radius;
+    const double w = motion.w;
+    const double v = motion.v;
+    const double tl = motion.tl;
+
+    for (int i = 0; i < num_samples; ++i) {
+        double dt = (double)i / (double)(num_samples - 1);
+        if (dt < tl) {
+            double x = start.x + v * dt * cos(start.yaw);
+            double y = start.y + v * dt * sin(start.yaw);
+            double theta = start.yaw;
+            poses[i] = { x, y, theta };
+        }
+        else {
+            double x = start.x + straight_length * cos(start.yaw) + radius * sin(w * (dt - tl) + start.yaw) - radius * sin(start.yaw);
+            double y = start.y + straight_length * sin(start.yaw) - radius * cos(w * (dt - tl) + start.yaw) + radius * cos(start.yaw);
+            double theta = start.yaw + w * (dt - tl);
+            poses[i] = { x, y, theta };
+        }
     }
+}
 
-    Eigen::Vector2d S = Rpinv * Eigen::Vector2d(goal.x - start.x, goal.y - start.y);
+std::vector<Pose2_cont> sample_unicycle_motion(const UnicycleMotion& motion)
+{
+    std::vector<Pose2_cont> interm_poses(num_unicycle_motion_samples(motion));
+    if (!interm_poses.empty()) {
+        sample_unicycle_motion(motion, (int)interm_poses.size(), &interm_poses[0]);
+    }
+    return interm_poses;
+}
 
-    double straight_length = S(0);
-    double radius = S(1);
+std::vector<Pose2_cont>
+generate_unicycle_motion(const Pose2_cont& start, const Pose2_cont& goal)
+{
+    std::vector<Pose2_cont> poses;
+    generate_unicycle_motion(start, goal, poses);
+    return poses;
+}
 
-    if (fabs(radius) < 1e-6)  {
-        DEBUG_PRINT("Unable to turn with radius %0.3f\n", radius);
-        return { };
+bool generate_unicycle_motion(
+    const Pose2_cont& start,
+    const Pose2_cont& goal,
+    std::vector<Pose2_cont>& poses,
+    double resolution)
+{
+    poses.clear();
+
+    UnicycleMotion motion;
+    if (!solve_unicycle_motion(start, goal, motion)) {
+        return false;
     }
 
-    double w = shortest_angle_diff(goal.yaw, start.yaw) + (straight_length / radius);
-    double v = radius * w;
-    double tl = straight_length / v;
+    const int num_samples = resolution > 0.0 ?
+            num_unicycle_motion_samples(motion, resolution) :
+            num_unicycle_motion_samples(motion);
+    if (num_samples <= 0) {
+        return false;
+    }
 
-    if (straight_length < 0) {
-        DEBUG_PRINT("Not allowed to go backwards (length = %0.3f)\n", straight_length);
-        return { };
+    poses.resize(num_samples);
+    sample_unicycle_motion(motion, num_samples, &poses[0]);
+    return true;
+}
+
+std::size_t generate_unicycle_motion(const Pose2_cont& start, const Pose2_cont& goal, Pose2_cont* poses, std::size_t capacity)
+{
+    UnicycleMotion motion;
+    if (!solve_unicycle_motion(start, goal, motion)) {
+        return 0;
     }
 
-    if (v < 0) {
-        DEBUG_PRINT("Not allowed to go backwards (velocity = %0.3f)\n", v);
-        return { };
+    const int num_samples = num_unicycle_motion_samples(motion);
+    if (num_samples <= 0) {
+        return 0;
     }
 
-    if (tl < 0.0 || tl > 1.0) {
-        DEBUG_PRINT("Another dimension! Another dimension! (tl = %0.3f)\n", tl);
-        return { };
+    if ((std::size_t)num_samples <= capacity) {
+        sample_unicycle_motion(motion, num_samples, poses);
     }
+    return (std::size_t)num_samples;
+}
 
-    DEBUG_PRINT("R = [ %0.3f, %0.3f; %0.3f, %0.3f]\n", R(0, 0), R(0, 1), R(1, 0), R(1, 1));
-    DEBUG_PRINT("S = [%0.3f, %0.3f]\n", S(0), S(1));
-    DEBUG_PRINT("straight_length = %0.3f\n", straight_length);
-    DEBUG_PRINT("radius = %0.3f\n", radius);
-    DEBUG_PRINT("w = %0.3f\n", w);
-    DEBUG_PRINT("v = %0.3f\n", v);
-    DEBUG_PRINT("tl = %0.3f\n", tl);
+UnicycleMotion UnicycleMotionBatch::motion(const Pose2Array& starts, std::size_t i) const
+{
+    UnicycleMotion m;
+    m.start = starts[i];
+    m.straight_length = straight_length[i];
+    m.radius = radius[i];
+    m.w = w[i];
+    m.v = v[i];
+    m.tl = tl[i];
+    return m;
+}
 
-    const double res = 0.1;
-    double arc_length = w * (1.0 - tl);
-    double total_length = fabs(straight_length) + fabs(arc_length);
+void solve_unicycle_motions(const Pose2Array& starts, const Pose2Array& goals, UnicycleMotionBatch& motions)
+{
+    const std::size_t n = goals.size();
+
+    motions.straight_length.resize(n);
+    motions.radius.resize(n);
+    motions.w.resize(n);
+    motions.v.resize(n);
+    motions.tl.resize(n);
+    motions.type.resize(n);
+    motions.cos_start.resize(n);
+    motions.sin_start.resize(n);
+    motions.cos_goal.resize(n);
+    motions.sin_goal.resize(n);
+    motions.dx.resize(n);
+    motions.dy.resize(n);
+    motions.dtheta.resize(n);
+
+    const double* sx = starts.x.data();
+    const double* sy = starts.y.data();
+    const double* syaw = starts.yaw.data();
+    const double* gx = goals.x.data();
+    const double* gy = goals.y.data();
+    const double* gyaw = goals.yaw.data();
+
+    double* cs = motions.cos_start.data();
+    double* ss = motions.sin_start.data();
+    double* cg = motions.cos_goal.data();
+    double* sg = motions.sin_goal.data();
+    double* dx = motions.dx.data();
+    double* dy = motions.dy.data();
+    double* dtheta = motions.dtheta.data();
+    double* straight_length = motions.straight_length.data();
+    double* radius = motions.radius.data();
+    double* w = motions.w.data();
+    double* v = motions.v.data();
+    double* tl = motions.tl.data();
+    uint8_t* type = motions.type.data();
+
+    // pass 1: trig and deltas, looked up when both ends are discrete headings
+    if (starts.has_headings() && goals.has_headings() && starts.headings == goals.headings) {
+        const HeadingTable& table = *starts.headings;
+        const int* sh = starts.heading.data();
+        const int* gh = goals.heading.data();
+        for (std::size_t i = 0; i < n; ++i) {
+            cs[i] = table.cos(sh[i]);
+            ss[i] = table.sin(sh[i]);
+            cg[i] = table.cos(gh[i]);
+            sg[i] = table.sin(gh[i]);
+            dtheta[i] = table.diff(gh[i], sh[i]);
+        }
+    }
+    else {
+        for (std::size_t i = 0; i < n; ++i) {
+            cs[i] = cos(syaw[i]);
+            ss[i] = sin(syaw[i]);
+            cg[i] = cos(gyaw[i]);
+            sg[i] = sin(gyaw[i]);
+            dtheta[i] = shortest_angle_diff(gyaw[i], syaw[i]);
+        }
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        dx[i] = gx[i] - sx[i];
+        dy[i] = gy[i] - sy[i];
+    }
 
-    const int num_samples = (int)std::ceil(total_length / res);
-    std::vector<Pose2_cont> interm_poses;
-    interm_poses.resize(num_samples);
+    // pass 2: solve R * [straight_length; radius] = [dx; dy] in closed form,
+    // where R = [cs, sg - ss; ss, cs - cg] and det(R) = 1 - cos(dtheta)
+    for (std::size_t i = 0; i < n; ++i) {
+        const double a = cs[i];
+        const double b = sg[i] - ss[i];
+        const double c = ss[i];
+        const double d = cs[i] - cg[i];
+        const double det = a * d - b * c;
+        straight_length[i] = (d * dx[i] - b * dy[i]) / det;
+        radius[i] = (a * dy[i] - c * dx[i]) / det;
+    }
 
-    for (int i = 0; i < num_samples; ++i) {
-        double dt = (double)i / (double)(num_samples - 1);
-        if (dt < tl) {
-            double x = start.x + v * dt * cos(start.yaw);
-            double y = start.y + v * dt * sin(start.yaw);
-            double theta = start.yaw;
-            interm_poses[i] = { x, y, theta };
+    // pass 3: redo the rank-deficient systems the way pinv() treats them,
+    // dropping any singular value at or below 1e-10
+    const double sv_eps = 1e-10;
+    for (std::size_t i = 0; i < n; ++i) {
+        const double a = cs[i];
+        const double b = sg[i] - ss[i];
+        const double c = ss[i];
+        const double d = cs[i] - cg[i];
+        const double det = a * d - b * c;
+        const double frob = a * a + b * b + c * c + d * d;
+        const double sv_max = sqrt(0.5 * (frob + sqrt(std::max(0.0, frob * frob - 4.0 * det * det))));
+        const double sv_min = sv_max > 0.0 ? fabs(det) / sv_max : 0.0;
+        if (sv_min > sv_eps) {
+            continue;
+        }
+        if (sv_max <= sv_eps) {
+            straight_length[i] = 0.0;
+            radius[i] = 0.0;
         }
         else {
-            double x = start.x + straight_length * cos(start.yaw) + radius * sin(w * (dt - tl) + start.yaw) - radius * sin(start.yaw);
-            double y = start.y + straight_length * sin(start.yaw) - radius * cos(w * (dt - tl) + start.yaw) + radius * cos(start.yaw);
-            double theta = start.yaw + w * (dt - tl);
-            interm_poses[i] = { x, y, theta };
+            // the pseudo-inverse of a rank-1 matrix is its transpose over its squared norm
+            straight_length[i] = (a * dx[i] + c * dy[i]) / frob;
+            radius[i] = (b * dx[i] + d * dy[i]) / frob;
         }
     }
 
-    return interm_poses;
+    // pass 4: timing, with the same snapping of roundoff-sized straight
+    // lengths as solve_unicycle_motion
+    const double length_eps = 1e-12;
+    for (std::size_t i = 0; i < n; ++i) {
+        straight_length[i] = fabs(straight_length[i]) < length_eps ? 0.0 : straight_length[i];
+        w[i] = dtheta[i] + straight_length[i] / radius[i];
+        v[i] = radius[i] * w[i];
+        tl[i] = straight_length[i] / v[i];
+    }
+
+    // pass 5: classify
+    const double eps = 1e-6;
+    for (std::size_t i = 0; i < n; ++i) {
+        if ((dx[i] == 0.0 && dy[i] == 0.0) || dtheta[i] == 0.0) {
+            double heading = atan2(dy[i], dx[i]);
+            if (fabs(shortest_angle_diff(heading, syaw[i])) < eps && fabs(shortest_angle_diff(heading, gyaw[i])) < eps) {
+                type[i] = UNICYCLE_STRAIGHT;
+                straight_length[i] = sqrt(dx[i] * dx[i] + dy[i] * dy[i]);
+                radius[i] = 0.0;
+                w[i] = 0.0;
+                v[i] = straight_length[i];
+                tl[i] = 1.0;
+            }
+            else {
+                type[i] = UNICYCLE_INFEASIBLE;
+            }
+        }
+        else {
+            // negated comparisons keep solve_unicycle_motion's handling of NaNs
+            bool feasible =
+                    !(fabs(radius[i]) < 1e-6) &&
+                    !(straight_length[i] < 0.0) &&
+                    !(v[i] < 0.0) &&
+                    !(tl[i] < 0.0 || tl[i] > 1.0);
+            type[i] = feasible ? UNICYCLE_ARC : UNICYCLE_INFEASIBLE;
+        }
+    }
 }
@@ -1,10 +1,228 @@
 #ifndef unicycle_motions_h
 #define unicycle_motions_h
 
+#include <cstddef>
+#include <stdint.h>
 #include <vector>
 #include "Pose2.h"
+#include "discrete_heading.h"
+
+/// Parameters of a straight-then-arc unicycle motion. The motion drives
+/// $straight_length along the start heading and then follows an arc of
+/// $radius; $tl is the fraction of unit time spent on the straight segment.
+/// Pure straight-line motions have a $radius of 0 and a $tl of 1.
+struct UnicycleMotion
+{
+    Pose2_cont start;
+    double straight_length;
+    double radius;
+    double w;
+    double v;
+    double tl;
+};
+
+/// Solve for the unicycle motion from $start to $goal. Return false if the goal
+/// requires turning in place, skidding, or driving backwards.
+bool solve_unicycle_motion(const Pose2_cont& start, const Pose2_cont& goal, UnicycleMotion& motion);
+
+/// Return the pose reached at normalized time $t, in [0, 1], along $motion
+Pose2_cont unicycle_motion_pose(const UnicycleMotion& motion, double t);
+
+/// Return the final pose of $motion without sampling it
+Pose2_cont unicycle_motion_end(const UnicycleMotion& motion);
+
+/// Return the path length of $motion in cells
+double unicycle_motion_length(const UnicycleMotion& motion);
+
+/// Default sample spacing, in cells, of straight-line motions and of the
+/// straight segment plus turned angle of arc motions
+static const double UNICYCLE_STRAIGHT_SAMPLE_RES = 0.01;
+static const double UNICYCLE_ARC_SAMPLE_RES = 0.1;
+
+/// Return the number of intermediate poses sample_unicycle_motion takes along
+/// $motion at the default density
+int num_unicycle_motion_samples(const UnicycleMotion& motion);
+
+/// Return the number of samples, evenly spaced in time, that keeps
+/// consecutive poses at most $resolution cells apart along $motion
+int num_unicycle_motion_samples(const UnicycleMotion& motion, double resolution);
+
+/// Produces the same poses as sample_unicycle_motion one at a time, for
+/// callers that consume samples as they go rather than storing them. The bulk
+/// kernel stays separate because it runs a branch-free loop per segment.
+class UnicycleMotionSampler
+{
+public:
+
+    UnicycleMotionSampler(const UnicycleMotion& motion, int num_samples);
+
+    int num_samples() const { return num_samples_; }
+
+    /// Return whether every sample has been produced
+    bool done() const { return i_ >= num_samples_; }
+
+    /// Return the next sample; must not be called once done()
+    Pose2_cont next();
+
+private:
+
+    UnicycleMotion motion_;
+    int num_samples_;
+    int i_;
+    int k_;     ///< samples produced on the arc segment so far
+
+    double cos_start_, sin_start_;
+    double end_x_, end_y_;   ///< straight-line motions only
+    double cx_, cy_;         ///< arc center
+    double cos_step_, sin_step_;
+    double c_, s_;           ///< (cos, sin) of the current arc heading
+};
+
+/// Arc samples are re-seeded from a direct sin/cos evaluation this often
+static const int UNICYCLE_SAMPLE_RESEED_INTERVAL = 32;
+
+/// Write $num_samples intermediate poses, evenly spaced in time along $motion,
+/// into $poses. Arc samples come from rotating (cos(theta), sin(theta)) by the
+/// fixed per-sample heading step instead of evaluating sin and cos per sample;
+/// the recurrence is re-seeded every UNICYCLE_SAMPLE_RESEED_INTERVAL samples,
+/// so the drift from sample_unicycle_motion_direct stays within a few ulps of
+/// |radius| per step since the last re-seed. Over a 64-heading, +-15 cell
+/// lattice the largest position difference is 2e-13 cells (see
+/// bench/sampling_bench). Headings are computed exactly as before.
+void sample_unicycle_motion(const UnicycleMotion& motion, int num_samples, Pose2_cont* poses);
+
+/// Reference version of sample_unicycle_motion that evaluates sin and cos at every sample
+void sample_unicycle_motion_direct(const UnicycleMotion& motion, int num_samples, Pose2_cont* poses);
+
+/// Return a vector of intermediate poses along a solved unicycle motion
+std::vector<Pose2_cont> sample_unicycle_motion(const UnicycleMotion& motion);
 
 /// Return a vector of intermediate poses on the unicycle-based motion from $start to $goal
 std::vector<Pose2_cont> generate_unicycle_motion(const Pose2_cont& start, const Pose2_cont& goal);
 
+/// Replace the contents of $poses with the intermediate poses on the motion
+/// from $start to $goal, reusing its capacity. Poses are at most $resolution
+/// cells apart, or at the default density if it is 0. Return false, leaving
+/// $poses empty, if there is no such motion.
+bool generate_unicycle_motion(
+    const Pose2_cont& start,
+    const Pose2_cont& goal,
+    std::vector<Pose2_cont>& poses,
+    double resolution = 0.0);
+
+/// Write the intermediate poses on the motion from $start to $goal into
+/// $poses, which holds $capacity poses. Return the number of poses on the
+/// motion, 0 if there is no such motion; nothing is written if it exceeds $capacity.
+std::size_t generate_unicycle_motion(const Pose2_cont& start, const Pose2_cont& goal, Pose2_cont* poses, std::size_t capacity);
+
+enum UnicycleMotionType
+{
+    UNICYCLE_INFEASIBLE = 0,
+    UNICYCLE_STRAIGHT,
+    UNICYCLE_ARC
+};
+
+/// Struct-of-arrays poses for batched solves. Poses pushed with a discrete
+/// heading also record its index, so that solves can read the heading's
+/// trig from its table instead of recomputing it from the yaw.
+struct Pose2Array
+{
+    Pose2Array() : headings(0) { }
+
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> yaw;
+    std::vector<int> heading;
+    const HeadingTable* headings;
+
+    std::size_t size() const { return x.size(); }
+    void clear() { x.clear(); y.clear(); yaw.clear(); heading.clear(); headings = 0; }
+    void push_back(const Pose2_cont& p) { x.push_back(p.x); y.push_back(p.y); yaw.push_back(p.yaw); }
+    void push_back(double px, double py, const DiscreteHeading& h)
+    {
+        x.push_back(px);
+        y.push_back(py);
+        yaw.push_back(h.angle());
+        heading.push_back(h.index());
+        headings = &h.table();
+    }
+    Pose2_cont operator[](std::size_t i) const { return Pose2_cont(x[i], y[i], yaw[i]); }
+
+    /// Return whether every pose was pushed with a heading from one table
+    bool has_headings() const { return heading.size() == x.size() && headings; }
+};
+
+/// Struct-of-arrays results of a batched solve. The per-pass scratch arrays
+/// are kept between calls so that reusing a batch does not allocate.
+struct UnicycleMotionBatch
+{
+    std::vector<double> straight_length;
+    std::vector<double> radius;
+    std::vector<double> w;
+    std::vector<double> v;
+    std::vector<double> tl;
+    std::vector<uint8_t> type;  ///< a UnicycleMotionType
+
+    std::size_t size() const { return type.size(); }
+
+    /// Return the $i'th motion, which must not be UNICYCLE_INFEASIBLE
+    UnicycleMotion motion(const Pose2Array& starts, std::size_t i) const;
+
+    // scratch
+    std::vector<double> cos_start, sin_start, cos_goal, sin_goal;
+    std::vector<double> dx, dy, dtheta;
+};
+
+/// Solve for the unicycle motions from $starts[i] to $goals[i]. Accepts and
+/// rejects the same goals as solve_unicycle_motion, but solves the 2x2 system
+/// in closed form rather than through an SVD-based pseudo-inverse, and works
+/// in separate passes over contiguous arrays so the arithmetic vectorizes.
+void solve_unicycle_motions(const Pose2Array& starts, const Pose2Array& goals, UnicycleMotionBatch& motions);
+
+/// The straight-then-arc unicycle model as a curve generator; see motion_generator.h
+struct UnicycleGenerator
+{
+    typedef UnicycleMotion Motion;
+    typedef UnicycleMotionBatch Batch;
+
+    static const char* name() { return "unicycle"; }
+
+    bool solve(const Pose2_cont& start, const Pose2_cont& goal, Motion& motion) const
+    {
+        return solve_unicycle_motion(start, goal, motion);
+    }
+
+    void solve(const Pose2Array& starts, const Pose2Array& goals, Batch& motions) const
+    {
+        solve_unicycle_motions(starts, goals, motions);
+    }
+
+    bool feasible(const Batch& motions, std::size_t i) const
+    {
+        return motions.type[i] != UNICYCLE_INFEASIBLE;
+    }
+
+    Motion motion(const Batch& motions, const Pose2Array& starts, std::size_t i) const
+    {
+        return motions.motion(starts, i);
+    }
+
+    double turning_radius(const Motion& motion) const
+    {
+        return motion.radius < 0.0 ? -motion.radius : motion.radius;
+    }
+
+    int num_samples(const Motion& motion, double resolution) const
+    {
+        return resolution > 0.0 ?
+                num_unicycle_motion_samples(motion, resolution) :
+                num_unicycle_motion_samples(motion);
+    }
+
+    void sample(const Motion& motion, int num_samples, Pose2_cont* poses) const
+    {
+        sample_unicycle_motion(motion, num_samples, poses);
+    }
+};
+
 #endif
@@ -0,0 +1,134 @@
+#include "work_stealing_pool.h"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(int num_threads) :
+    generation_(0),
+    stop_(false),
+    remaining_(0)
+{
+    if (num_threads <= 0) {
+        num_threads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+
+    for (int i = 0; i < num_threads; ++i) {
+        queues_.push_back(new Queue);
+    }
+
+    // worker 0 is whichever thread calls parallel_for()
+    for (int i = 1; i < num_threads; ++i) {
+        threads_.push_back(std::thread(&WorkStealingPool::worker_main, this, i));
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_available_.notify_all();
+
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+
+    for (Queue* queue : queues_) {
+        delete queue;
+    }
+}
+
+void WorkStealingPool::parallel_for(std::size_t first, std::size_t last, std::size_t grain, const RangeFunction& fn)
+{
+    if (first >= last) {
+        return;
+    }
+
+    grain = std::max<std::size_t>(grain, 1);
+    const std::size_t num_chunks = (last - first + grain - 1) / grain;
+    const std::size_t num_workers = queues_.size();
+
+    remaining_ = num_chunks;
+
+    // hand every worker a contiguous run of chunks so that neighbouring
+    // indices tend to execute on the same thread
+    for (std::size_t w = 0; w < num_workers; ++w) {
+        std::size_t chunk_begin = num_chunks * w / num_workers;
+        std::size_t chunk_end = num_chunks * (w + 1) / num_workers;
+        std::lock_guard<std::mutex> lock(queues_[w]->mutex);
+        queues_[w]->tasks.clear();
+        queues_[w]->head = 0;
+        for (std::size_t c = chunk_begin; c < chunk_end; ++c) {
+            Task task;
+            task.fn = &fn;
+            task.first = first + c * grain;
+            task.last = std::min(last, task.first + grain);
+            queues_[w]->tasks.push_back(task);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generation_;
+    }
+    work_available_.notify_all();
+
+    Task task;
+    while (pop_or_steal(0, task)) {
+        run(0, task);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_done_.wait(lock, [this]() { return remaining_ == 0; });
+}
+
+void WorkStealingPool::worker_main(int worker)
+{
+    unsigned long seen_generation = 0;
+    while (true) {
+        Task task;
+        while (pop_or_steal(worker, task)) {
+            run(worker, task);
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_available_.wait(lock, [&]() { return stop_ || generation_ != seen_generation; });
+        if (stop_) {
+            return;
+        }
+        seen_generation = generation_;
+    }
+}
+
+bool WorkStealingPool::pop_or_steal(int worker, Task& task)
+{
+    {
+        Queue& own = *queues_[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    const int num_workers = (int)queues_.size();
+    for (int i = 1; i < num_workers; ++i) {
+        Queue& victim = *queues_[(worker + i) % num_workers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.empty()) {
+            task = victim.tasks[victim.head++];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingPool::run(int worker, const Task& task)
+{
+    (*task.fn)(worker, task.first, task.last);
+    if (--remaining_ == 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        work_done_.notify_all();
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef work_stealing_pool_h
+#define work_stealing_pool_h
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// A fixed set of worker threads that execute index ranges. Every worker owns a
+/// deque of chunks; it pops from the back of its own deque and, once that is
+/// empty, steals from the front of the others'. The thread calling
+/// parallel_for() participates as worker 0.
+class WorkStealingPool
+{
+public:
+
+    /// Called with the index of the executing worker and a chunk [first, last)
+    typedef std::function<void(int, std::size_t, std::size_t)> RangeFunction;
+
+    /// Create a pool with $num_threads workers; 0 uses one per hardware thread
+    explicit WorkStealingPool(int num_threads = 0);
+    ~WorkStealingPool();
+
+    int num_threads() const { return (int)queues_.size(); }
+
+    /// Split [$first, $last) into chunks of at most $grain indices, run $fn on
+    /// every chunk, and block until all of them have completed. Must not be
+    /// called from inside $fn.
+    void parallel_for(std::size_t first, std::size_t last, std::size_t grain, const RangeFunction& fn);
+
+private:
+
+    struct Task
+    {
+        const RangeFunction* fn;
+        std::size_t first;
+        std::size_t last;
+    };
+
+    /// The owner pops from the back and thieves take from $head. Tasks are
+    /// only pushed while the pool is idle, so the storage is reset then and
+    /// its capacity reused from one parallel_for to the next.
+    struct Queue
+    {
+        Queue() : head(0) { }
+        std::mutex mutex;
+        std::vector<Task> tasks;
+        std::size_t head;
+
+        bool empty() const { return head == tasks.size(); }
+    };
+
+    std::vector<Queue*> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable work_done_;
+    unsigned long generation_;
+    bool stop_;
+
+    std::atomic<std::size_t> remaining_;
+
+    WorkStealingPool(const WorkStealingPool&);
+    WorkStealingPool& operator=(const WorkStealingPool&);
+
+    void worker_main(int worker);
+    bool pop_or_steal(int worker, Task& task);
+    void run(int worker, const Task& task);
+};
+
+#endif